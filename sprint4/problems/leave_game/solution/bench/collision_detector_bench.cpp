@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "../src/collision_detector.h"
+
+namespace {
+
+using namespace collision_detector;
+
+class VectorProvider : public ItemGathererProvider {
+ public:
+  VectorProvider(std::vector<Item> items, std::vector<Gatherer> gatherers)
+      : items_(std::move(items)), gatherers_(std::move(gatherers)) {
+  }
+
+  size_t ItemsCount() const override {
+    return items_.size();
+  }
+
+  Item GetItem(size_t idx) const override {
+    return items_[idx];
+  }
+
+  size_t GatherersCount() const override {
+    return gatherers_.size();
+  }
+
+  Gatherer GetGatherer(size_t idx) const override {
+    return gatherers_[idx];
+  }
+
+ private:
+  std::vector<Item> items_;
+  std::vector<Gatherer> gatherers_;
+};
+
+// Сцена, похожая на игровую: собаки проходят за тик около единицы пути,
+// трофеи разбросаны по карте 100x100
+struct Scene {
+  Scene(size_t item_count, size_t gatherer_count) {
+    std::mt19937 random{1};
+    std::uniform_real_distribution<double> coord(0.0, 100.0);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+
+    for (size_t i = 0; i < item_count; ++i) {
+      item_list.push_back({{coord(random), coord(random)}, 0.0});
+      items.Add(item_list.back());
+    }
+    for (size_t g = 0; g < gatherer_count; ++g) {
+      geom::Point2D start{coord(random), coord(random)};
+      gatherer_list.push_back({start, {start.x + step(random), start.y + step(random)}, 0.6});
+      gatherers.Add(gatherer_list.back());
+    }
+  }
+
+  std::vector<Item> item_list;
+  std::vector<Gatherer> gatherer_list;
+  ItemsBatch items;
+  GatherersBatch gatherers;
+};
+
+void BM_Kernel(benchmark::State& state, Kernel kernel) {
+  if (!IsKernelSupported(kernel)) {
+    state.SkipWithError("kernel is not supported by this CPU");
+    return;
+  }
+  Scene scene(state.range(0), state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FindGatherEvents(scene.items.View(), scene.gatherers.View(), kernel));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+// Путь через виртуальный интерфейс с копированием в структуры массивов
+void BM_Provider(benchmark::State& state) {
+  Scene scene(state.range(0), state.range(1));
+  VectorProvider provider(scene.item_list, scene.gatherer_list);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FindGatherEvents(provider));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+void SceneSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"items", "gatherers"});
+  for (auto [items, gatherers] : {std::pair{16, 16}, {256, 64}, {1024, 256}, {4096, 1024}}) {
+    benchmark->Args({items, gatherers});
+  }
+}
+
+BENCHMARK_CAPTURE(BM_Kernel, scalar, Kernel::SCALAR)->Apply(SceneSizes);
+BENCHMARK_CAPTURE(BM_Kernel, sse2, Kernel::SSE2)->Apply(SceneSizes);
+BENCHMARK_CAPTURE(BM_Kernel, avx2, Kernel::AVX2)->Apply(SceneSizes);
+BENCHMARK(BM_Provider)->Apply(SceneSizes);
+
+}  // namespace
@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "../src/compression.h"
+#include "../src/game_state.h"
+#include "simulation.h"
+
+namespace {
+
+using compression::Encoding;
+
+// Сжатие ответа /api/v1/game/state: время процессора на запрос против сэкономленного трафика.
+// compressed_bytes/body_bytes - доля трафика, которая остаётся после сжатия.
+void BM_CompressState(benchmark::State& state) {
+  const auto streets = static_cast<int>(state.range(0));
+  const auto dogs = static_cast<int>(state.range(1));
+  const auto level = static_cast<int>(state.range(2));
+
+  simulation::Simulation simulation{streets, dogs};
+  simulation.ScatterLoot(dogs);
+  const std::string body =
+      boost::json::serialize(game_state::SerializeSession(simulation.GetSession(), std::nullopt));
+
+  std::size_t compressed_bytes = 0;
+  for (auto _ : state) {
+    const std::string compressed = compression::Compress(body, Encoding::GZIP, level);
+    compressed_bytes = compressed.size();
+    benchmark::DoNotOptimize(compressed.data());
+  }
+  state.counters["body_bytes"] = static_cast<double>(body.size());
+  state.counters["compressed_bytes"] = static_cast<double>(compressed_bytes);
+  state.counters["ratio"] = static_cast<double>(compressed_bytes) / body.size();
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(body.size()));
+}
+
+void StateSizesAndLevels(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"streets", "dogs", "level"});
+  for (auto [streets, dogs] : {std::pair{10, 10}, {20, 100}, {50, 1000}}) {
+    for (const int level : {compression::FAST_LEVEL, 6, compression::BEST_LEVEL}) {
+      benchmark->Args({streets, dogs, level});
+    }
+  }
+}
+
+BENCHMARK(BM_CompressState)->Apply(StateSizesAndLevels)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,171 @@
+#include <benchmark/benchmark.h>
+
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "../src/game_state.h"
+#include "../src/serialization.h"
+#include "simulation.h"
+
+namespace {
+
+using simulation::Simulation;
+
+constexpr double TICK = 0.05;
+
+int Streets(const benchmark::State& state) {
+  return static_cast<int>(state.range(0));
+}
+
+int Dogs(const benchmark::State& state) {
+  return static_cast<int>(state.range(1));
+}
+
+// Перемещение собак и сбор трофеев в одной сессии
+void BM_GameSessionTick(benchmark::State& state) {
+  Simulation simulation{Streets(state), Dogs(state)};
+  simulation.ScatterLoot(Dogs(state));
+  auto& session = simulation.GetSession();
+
+  for (auto _ : state) {
+    session.Tick(TICK);
+    simulation.SteerDogs();
+  }
+  state.counters["ticks/s"] =
+      benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+  state.SetItemsProcessed(state.iterations() * Dogs(state));
+}
+
+// Полный тик игры: перемещение, сбор трофеев, генерация новых
+void BM_GameTick(benchmark::State& state) {
+  Simulation simulation{Streets(state), Dogs(state)};
+  auto& game = simulation.GetGame();
+  game.SetLootGeneratorConfig(1.0, 0.5);
+
+  for (auto _ : state) {
+    game.Tick(TICK);
+    simulation.SteerDogs();
+  }
+  state.counters["ticks/s"] =
+      benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+  state.SetItemsProcessed(state.iterations() * Dogs(state));
+}
+
+// Сбор трофеев без перемещения; собранные трофеи возвращаются на карту вне замера
+void BM_ProcessCollisions(benchmark::State& state) {
+  Simulation simulation{Streets(state), Dogs(state)};
+  auto& session = simulation.GetSession();
+  const auto loot_count = static_cast<size_t>(Dogs(state));
+  simulation.ScatterLoot(static_cast<int>(loot_count));
+
+  for (auto _ : state) {
+    session.ProcessCollisions(TICK);
+
+    state.PauseTiming();
+    simulation.ScatterLoot(static_cast<int>(loot_count - session.GetLoots().size()));
+    for (const auto& player : simulation.GetPlayers().GetAllPlayers()) {
+      player.GetDog().GetBag().Clear();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * Dogs(state));
+}
+
+// Размещение новых трофеев на дорогах карты
+void BM_GenerateLoot(benchmark::State& state) {
+  const model::Map map = simulation::MakeLatticeMap(Streets(state));
+  const auto count = static_cast<unsigned>(state.range(1));
+  // Каждый замер начинается с пустой сессии, чтобы трофеи не копились
+  std::optional<model::GameSession> session;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    session.emplace(map);
+    state.ResumeTiming();
+
+    session->GenerateLoot(count, map.GetLootTypesCount());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+void BM_SaveGame(benchmark::State& state) {
+  Simulation simulation{Streets(state), Dogs(state)};
+  simulation.ScatterLoot(Dogs(state));
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    std::ostringstream out;
+    model::SaveGame(simulation.GetGame(), simulation.GetPlayers(), out);
+    bytes = out.view().size();
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.counters["snapshot_bytes"] = static_cast<double>(bytes);
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+
+void BM_LoadGame(benchmark::State& state) {
+  Simulation simulation{Streets(state), Dogs(state)};
+  simulation.ScatterLoot(Dogs(state));
+  std::ostringstream out;
+  model::SaveGame(simulation.GetGame(), simulation.GetPlayers(), out);
+  const std::string snapshot = out.str();
+
+  // Восстановленная игра разрушается вне замера; игроки ссылаются на сессии игры
+  std::optional<model::Game> game;
+  std::optional<model::Players> players;
+  for (auto _ : state) {
+    state.PauseTiming();
+    players.reset();
+    game.emplace();
+    game->AddMap(simulation::MakeLatticeMap(Streets(state)));
+    players.emplace();
+    std::istringstream in{snapshot};
+    state.ResumeTiming();
+
+    model::LoadGame(*game, *players, in);
+    benchmark::DoNotOptimize(players->GetAllPlayers().size());
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(snapshot.size()));
+}
+
+// Ответ /api/v1/game/state для всей сессии, вместе с переводом в текст
+void BM_StateSerialization(benchmark::State& state) {
+  Simulation simulation{Streets(state), Dogs(state)};
+  simulation.ScatterLoot(Dogs(state));
+  const auto& session = simulation.GetSession();
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    const std::string body =
+        boost::json::serialize(game_state::SerializeSession(session, std::nullopt));
+    bytes = body.size();
+    benchmark::DoNotOptimize(body.data());
+  }
+  state.counters["body_bytes"] = static_cast<double>(bytes);
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+
+void WorldSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"streets", "dogs"});
+  for (auto [streets, dogs] : {std::pair{10, 10}, {20, 100}, {50, 1000}}) {
+    benchmark->Args({streets, dogs});
+  }
+}
+
+void LootBatches(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"streets", "loot"});
+  for (auto [streets, loot] : {std::pair{10, 1}, {10, 100}, {50, 1000}}) {
+    benchmark->Args({streets, loot});
+  }
+}
+
+BENCHMARK(BM_GameSessionTick)->Apply(WorldSizes);
+BENCHMARK(BM_GameTick)->Apply(WorldSizes);
+BENCHMARK(BM_ProcessCollisions)->Apply(WorldSizes);
+BENCHMARK(BM_GenerateLoot)->Apply(LootBatches);
+BENCHMARK(BM_SaveGame)->Apply(WorldSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LoadGame)->Apply(WorldSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StateSerialization)->Apply(WorldSizes)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+# Сравнивает game_server (epoll) и game_server_uring (io_uring) под нагрузкой game_load,
+# в которой игроки в основном опрашивают /api/v1/game/state.
+# Оба сервера собираются с -DGAME_SERVER_IO_URING=ON и запускаются по очереди
+# на порту 8080 с одной и той же конфигурацией; нужна база из GAME_DB_URL.
+#
+# Использование: io_backend_bench.sh <каталог с исполняемыми файлами> [каталог результатов]
+# Параметры нагрузки задаются переменными окружения:
+#   PLAYERS (200), STATE_RATE (20), ACTION_RATE (0.5), DURATION (30), SHARDS (0)
+set -euo pipefail
+
+bin_dir=${1:?directory with game_server, game_server_uring and game_load}
+out_dir=${2:-bench_results/io_backend}
+: "${GAME_DB_URL:?GAME_DB_URL must point to the game database}"
+
+players=${PLAYERS:-200}
+state_rate=${STATE_RATE:-20}
+action_rate=${ACTION_RATE:-0.5}
+duration=${DURATION:-30}
+shards=${SHARDS:-0}
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+mkdir -p "${out_dir}"
+
+server_pid=
+stop_server() {
+  if [[ -n "${server_pid}" ]]; then
+    kill -INT "${server_pid}" 2>/dev/null || true
+    wait "${server_pid}" 2>/dev/null || true
+    server_pid=
+  fi
+}
+trap stop_server EXIT
+
+wait_for_port() {
+  for _ in $(seq 100); do
+    if (exec 3<>/dev/tcp/127.0.0.1/8080) 2>/dev/null; then
+      return 0
+    fi
+    sleep 0.1
+  done
+  echo "server did not start listening on 8080" >&2
+  return 1
+}
+
+for backend in epoll uring; do
+  server="${bin_dir}/game_server"
+  [[ "${backend}" == uring ]] && server="${bin_dir}/game_server_uring"
+
+  "${server}" --config-file "${root}/data/config.json" --www-root "${root}/static" \
+    --tick-period 50 --shards "${shards}" >"${out_dir}/${backend}.log" 2>&1 &
+  server_pid=$!
+  wait_for_port
+
+  "${bin_dir}/game_load" --players "${players}" --state-rate "${state_rate}" \
+    --action-rate "${action_rate}" --duration "${duration}" \
+    --output "${out_dir}/${backend}.json"
+  stop_server
+
+  # Сервер пишет в журнал механизм, с которым он собран; сверяем, что запущен нужный
+  grep -q "\"io_backend\":\"${backend/uring/io_uring}\"" "${out_dir}/${backend}.log" ||
+    echo "warning: ${server} did not report io_backend=${backend}" >&2
+done
+
+python3 - "${out_dir}" <<'EOF'
+import json, sys
+out_dir = sys.argv[1]
+print(f"{'backend':8} {'state rps':>10} {'p50 ms':>8} {'p99 ms':>8} {'p99.9 ms':>9} {'errors':>7}")
+for backend in ("epoll", "uring"):
+    with open(f"{out_dir}/{backend}.json") as f:
+        state = json.load(f)["requests"]["state"]
+    latency = state["latency_ms"]
+    errors = state["status_5xx"] + state["io_errors"]
+    print(f"{backend:8} {state['throughput_rps']:10.0f} {latency['p50']:8.2f} "
+          f"{latency['p99']:8.2f} {latency['p99.9']:9.2f} {errors:7}")
+EOF
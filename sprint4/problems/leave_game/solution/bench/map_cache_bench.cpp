@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include <boost/json.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/json_loader.h"
+#include "simulation.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+namespace json = boost::json;
+
+// config.json с одной картой-решёткой из simulation.h
+fs::path WriteLatticeConfig(int streets) {
+  const model::Map map = simulation::MakeLatticeMap(streets);
+
+  json::array roads;
+  for (const auto& road : map.GetRoads()) {
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    if (road.IsHorizontal()) {
+      roads.push_back(json::object{{"x0", start.x}, {"y0", start.y}, {"x1", end.x}});
+    } else {
+      roads.push_back(json::object{{"x0", start.x}, {"y0", start.y}, {"y1", end.y}});
+    }
+  }
+  json::array offices;
+  for (const auto& office : map.GetOffices()) {
+    offices.push_back(json::object{{"id", *office.GetId()},
+                                   {"x", office.GetPosition().x},
+                                   {"y", office.GetPosition().y},
+                                   {"offsetX", 0},
+                                   {"offsetY", 0}});
+  }
+  json::array loot_types;
+  for (const int value : map.GetLootValues()) {
+    loot_types.push_back(
+        json::object{{"name", "key"}, {"file", "assets/key.obj"}, {"value", value}});
+  }
+
+  const json::object config{
+      {"defaultDogSpeed", 3.0},
+      {"lootGeneratorConfig", json::object{{"period", 5.0}, {"probability", 0.5}}},
+      {"maps", json::array{json::object{{"id", *map.GetId()},
+                                        {"name", map.GetName()},
+                                        {"roads", std::move(roads)},
+                                        {"buildings", json::array{}},
+                                        {"offices", std::move(offices)},
+                                        {"lootTypes", std::move(loot_types)}}}}};
+
+  const fs::path path =
+      fs::temp_directory_path() / ("game_model_bench_config_" + std::to_string(streets) + ".json");
+  std::ofstream{path} << json::serialize(config);
+  return path;
+}
+
+// Запуск сервера без кеша: разбор JSON и построение модели
+void BM_LoadConfigJson(benchmark::State& state) {
+  const fs::path config = WriteLatticeConfig(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    auto package = json_loader::LoadGamePackage(config);
+    benchmark::DoNotOptimize(package.game.GetMaps().data());
+  }
+  state.counters["config_bytes"] = static_cast<double>(fs::file_size(config));
+  fs::remove(config);
+}
+
+// Запуск с актуальным кешем: хеш конфигурации и чтение отображённого файла
+void BM_LoadMapCache(benchmark::State& state) {
+  const fs::path config = WriteLatticeConfig(static_cast<int>(state.range(0)));
+  const fs::path cache = config.string() + ".cache";
+  json_loader::LoadGamePackage(config, cache);
+
+  for (auto _ : state) {
+    auto package = json_loader::LoadGamePackage(config, cache);
+    benchmark::DoNotOptimize(package.game.GetMaps().data());
+  }
+  state.counters["cache_bytes"] = static_cast<double>(fs::file_size(cache));
+  fs::remove(config);
+  fs::remove(cache);
+}
+
+BENCHMARK(BM_LoadConfigJson)->ArgName("streets")->Arg(50)->Arg(200)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadMapCache)->ArgName("streets")->Arg(50)->Arg(200)->Unit(benchmark::kMillisecond);
+
+}  // namespace
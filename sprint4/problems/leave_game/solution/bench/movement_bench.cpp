@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/model.h"
+#include "../src/region_movement.h"
+#include "simulation.h"
+
+namespace {
+
+using namespace model;
+
+using simulation::BLOCK;
+using simulation::MakeLatticeMap;
+
+constexpr double TICK = 0.05;
+constexpr double SPEED = 4;
+
+// Собаки стартуют на случайных перекрёстках и поворачивают, упёршись в край
+class Walkers {
+ public:
+  Walkers(int streets, int count) : random_{1}, intersection_{0, streets - 1} {
+    for (int i = 0; i < count; ++i) {
+      Dog dog{"dog" + std::to_string(i)};
+      dog.MoveDog({static_cast<double>(intersection_(random_) * BLOCK),
+                   static_cast<double>(intersection_(random_) * BLOCK)});
+      Turn(dog);
+      dogs_.push_back(std::move(dog));
+    }
+  }
+
+  std::vector<Dog>& GetDogs() {
+    return dogs_;
+  }
+
+  void Turn(Dog& dog) {
+    static const std::array<std::string, 4> directions{"L", "R", "U", "D"};
+    dog.SetDogDirSpeed(directions[random_() % directions.size()], SPEED);
+  }
+
+  void TurnStopped(Dog& dog) {
+    if (dog.GetSpeed() == MoveInfo::Speed{0, 0}) {
+      Turn(dog);
+    }
+  }
+
+ private:
+  std::mt19937 random_;
+  std::uniform_int_distribution<int> intersection_;
+  std::vector<Dog> dogs_;
+};
+
+void SetTickCounters(benchmark::State& state, int roads) {
+  state.counters["roads"] = roads;
+  state.counters["ticks/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                 benchmark::Counter::kIsRate);
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+void BM_RoadGraphTick(benchmark::State& state) {
+  const Map map = MakeLatticeMap(static_cast<int>(state.range(0)));
+  Walkers walkers(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+  GameSession session{map};
+  std::vector<Dog::Id> ids;
+  for (auto& dog : walkers.GetDogs()) {
+    const auto position = dog.GetPosition();
+    Dog& added = session.AddDog(dog);
+    added.MoveDog(position);
+    ids.push_back(added.GetId());
+  }
+
+  for (auto _ : state) {
+    session.MoveDogs(TICK);
+    for (const auto id : ids) {
+      walkers.TurnStopped(*session.FindDog(id));
+    }
+  }
+  SetTickCounters(state, static_cast<int>(map.GetRoads().size()));
+}
+
+void BM_RegionTick(benchmark::State& state) {
+  const Map map = MakeLatticeMap(static_cast<int>(state.range(0)));
+  Walkers walkers(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+  const RegionMovement movement{map};
+
+  for (auto _ : state) {
+    for (auto& dog : walkers.GetDogs()) {
+      movement.MoveDog(dog, TICK);
+    }
+    for (auto& dog : walkers.GetDogs()) {
+      walkers.TurnStopped(dog);
+    }
+  }
+  SetTickCounters(state, static_cast<int>(map.GetRoads().size()));
+}
+
+void MapSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"streets", "dogs"});
+  for (auto [streets, dogs] : {std::pair{5, 100}, {20, 100}, {20, 1000}, {50, 1000}}) {
+    benchmark->Args({streets, dogs});
+  }
+}
+
+BENCHMARK(BM_RoadGraphTick)->Apply(MapSizes);
+BENCHMARK(BM_RegionTick)->Apply(MapSizes);
+
+}  // namespace
@@ -0,0 +1,129 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../src/router.h"
+
+namespace {
+
+using Verb = router::http::verb;
+
+struct Request {
+  std::string_view target;
+  Verb method;
+};
+
+// Смесь запросов, похожая на нагрузку game_load: в основном опрос состояния и действия
+constexpr std::array<Request, 10> REQUESTS = {{
+    {"/api/v1/game/state", Verb::get},
+    {"/api/v1/game/state?radius=20", Verb::get},
+    {"/api/v1/game/player/action", Verb::post},
+    {"/api/v1/game/state", Verb::get},
+    {"/api/v1/game/player/action", Verb::post},
+    {"/api/v1/game/state?x0=0&y0=0&x1=40&y1=30", Verb::get},
+    {"/api/v1/game/players", Verb::get},
+    {"/api/v1/maps/map1", Verb::get},
+    {"/api/v1/game/join", Verb::get},  // 405
+    {"/api/v1/unknown", Verb::get},    // 404
+}};
+
+using router::MakeRoute;
+using router::On;
+
+constexpr router::Router ROUTES{std::array{
+    MakeRoute("/api/v1/maps", On(Verb::get, 1), On(Verb::head, 1)),
+    MakeRoute("/api/v1/maps/{id}", On(Verb::get, 2), On(Verb::head, 2)),
+    MakeRoute("/api/v1/game/join", On(Verb::post, 3)),
+    MakeRoute("/api/v1/game/players", On(Verb::get, 4), On(Verb::head, 4)),
+    MakeRoute("/api/v1/game/state", On(Verb::get, 5), On(Verb::head, 5)),
+    MakeRoute("/api/v1/game/player/action", On(Verb::post, 6)),
+    MakeRoute("/api/v1/game/tick", On(Verb::post, 7)),
+    MakeRoute("/api/v1/game/records", On(Verb::get, 8), On(Verb::head, 8)),
+}};
+
+// Результат выбора обработчика: его номер или текст заголовка Allow для ответа 405
+struct Dispatched {
+  int handler = 0;
+  std::string_view allow;
+  std::string_view param;
+};
+
+Dispatched RouterDispatch(const Request& request) {
+  const auto match = ROUTES.Find(request.target, request.method);
+  if (match.handler) {
+    return {*match.handler, {}, match.params.size() > 0 ? match.params[0] : std::string_view{}};
+  }
+  return {0, match.allow, {}};
+}
+
+// Прежний способ: unordered_map по пути, поиск метода перебором, Allow собирается
+// заново при каждом 405, параметризованный путь проверяется через starts_with
+Dispatched LegacyDispatch(const Request& request, std::string& allow_buffer) {
+  static const std::unordered_map<std::string_view, std::vector<std::pair<Verb, int>>> handlers =
+      {{"/api/v1/game/join", {{Verb::post, 3}}},
+       {"/api/v1/game/players", {{Verb::get, 4}, {Verb::head, 4}}},
+       {"/api/v1/maps", {{Verb::get, 1}, {Verb::head, 1}}},
+       {"/api/v1/game/records", {{Verb::get, 8}, {Verb::head, 8}}},
+       {"/api/v1/game/state", {{Verb::get, 5}, {Verb::head, 5}}},
+       {"/api/v1/game/player/action", {{Verb::post, 6}}},
+       {"/api/v1/game/tick", {{Verb::post, 7}}}};
+
+  const std::string_view target = request.target;
+  const std::string_view base_path = target.substr(0, target.find('?'));
+
+  if (auto it = handlers.find(base_path); it != handlers.end()) {
+    for (const auto& [verb, handler] : it->second) {
+      if (verb == request.method) {
+        return {handler, {}, {}};
+      }
+    }
+    std::vector<std::string_view> allowed_methods;
+    for (const auto& [verb, _] : it->second) {
+      const auto name = router::http::to_string(verb);
+      allowed_methods.emplace_back(name.data(), name.size());
+    }
+    allow_buffer.clear();
+    for (const auto& method : allowed_methods) {
+      if (!allow_buffer.empty()) {
+        allow_buffer += ", ";
+      }
+      allow_buffer += method;
+    }
+    return {0, allow_buffer, {}};
+  }
+
+  if (target.starts_with("/api/v1/maps/") && target.size() > strlen("/api/v1/maps/")) {
+    return {2, {}, target.substr(strlen("/api/v1/maps/"))};
+  }
+  return {};
+}
+
+void BM_RouterDispatch(benchmark::State& state) {
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RouterDispatch(REQUESTS[i]));
+    i = (i + 1) % REQUESTS.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LegacyDispatch(benchmark::State& state) {
+  std::string allow_buffer;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LegacyDispatch(REQUESTS[i], allow_buffer));
+    i = (i + 1) % REQUESTS.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_RouterDispatch);
+BENCHMARK(BM_LegacyDispatch);
+
+}  // namespace
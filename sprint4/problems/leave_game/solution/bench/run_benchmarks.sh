@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+# Прогоняет game_model_bench и сохраняет результаты в JSON, названный по коммиту.
+# Два прогона сравниваются скриптом compare.py из Google Benchmark:
+#   compare.py benchmarks <old>.json <new>.json
+#
+# Использование: run_benchmarks.sh <game_model_bench> [каталог результатов] [флаги benchmark...]
+set -euo pipefail
+
+bench=${1:?path to game_model_bench}
+out_dir=${2:-bench_results}
+shift $(( $# < 2 ? $# : 2 ))
+
+if commit=$(git rev-parse --short HEAD 2>/dev/null); then
+  git diff --quiet HEAD -- || commit="${commit}-dirty"
+else
+  commit=unknown
+fi
+
+mkdir -p "${out_dir}"
+out="${out_dir}/${commit}.json"
+
+"${bench}" \
+  --benchmark_out="${out}" \
+  --benchmark_out_format=json \
+  --benchmark_repetitions="${BENCH_REPETITIONS:-3}" \
+  --benchmark_report_aggregates_only=true \
+  --benchmark_context=commit="${commit}" \
+  "$@"
+
+echo "Results: ${out}"
@@ -0,0 +1,72 @@
+#!/usr/bin/env bash
+# Сравнивает пропускную способность game_server с общим io_context (--shards 0)
+# и с шардами (--shards N) под нагрузкой game_load.
+# В режиме шардов каждый шард ведёт свою часть игры: сессии и игроков, отданных
+# ему при входе. Запросы с токеном выполняются в шарде игрока, тики частей идут
+# параллельно, поэтому запросы API ускоряются с числом ядер.
+# Нужна база из GAME_DB_URL.
+#
+# Использование: shards_bench.sh <каталог с исполняемыми файлами> [каталог результатов]
+# Параметры нагрузки задаются переменными окружения:
+#   SHARD_COUNTS ("0 <ядра>"), PLAYERS (200), STATE_RATE (20), ACTION_RATE (0.5),
+#   DURATION (30)
+set -euo pipefail
+
+bin_dir=${1:?directory with game_server and game_load}
+out_dir=${2:-bench_results/shards}
+: "${GAME_DB_URL:?GAME_DB_URL must point to the game database}"
+
+shard_counts=${SHARD_COUNTS:-"0 $(nproc)"}
+players=${PLAYERS:-200}
+state_rate=${STATE_RATE:-20}
+action_rate=${ACTION_RATE:-0.5}
+duration=${DURATION:-30}
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+mkdir -p "${out_dir}"
+
+server_pid=
+stop_server() {
+  if [[ -n "${server_pid}" ]]; then
+    kill -INT "${server_pid}" 2>/dev/null || true
+    wait "${server_pid}" 2>/dev/null || true
+    server_pid=
+  fi
+}
+trap stop_server EXIT
+
+wait_for_port() {
+  for _ in $(seq 100); do
+    if (exec 3<>/dev/tcp/127.0.0.1/8080) 2>/dev/null; then
+      return 0
+    fi
+    sleep 0.1
+  done
+  echo "server did not start listening on 8080" >&2
+  return 1
+}
+
+for shards in ${shard_counts}; do
+  "${bin_dir}/game_server" --config-file "${root}/data/config.json" --www-root "${root}/static" \
+    --tick-period 50 --shards "${shards}" >"${out_dir}/shards_${shards}.log" 2>&1 &
+  server_pid=$!
+  wait_for_port
+
+  "${bin_dir}/game_load" --players "${players}" --state-rate "${state_rate}" \
+    --action-rate "${action_rate}" --duration "${duration}" \
+    --output "${out_dir}/shards_${shards}.json"
+  stop_server
+done
+
+python3 - "${out_dir}" ${shard_counts} <<'EOF'
+import json, sys
+out_dir, counts = sys.argv[1], sys.argv[2:]
+print(f"{'shards':>6} {'state rps':>10} {'action rps':>11} {'p50 ms':>8} {'p99 ms':>8} {'errors':>7}")
+for shards in counts:
+    with open(f"{out_dir}/shards_{shards}.json") as f:
+        requests = json.load(f)["requests"]
+    state, action = requests["state"], requests["action"]
+    errors = sum(kind["status_5xx"] + kind["io_errors"] for kind in requests.values())
+    print(f"{shards:>6} {state['throughput_rps']:10.0f} {action['throughput_rps']:11.0f} "
+          f"{state['latency_ms']['p50']:8.2f} {state['latency_ms']['p99']:8.2f} {errors:7}")
+EOF
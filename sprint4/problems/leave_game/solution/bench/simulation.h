@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/model.h"
+
+namespace simulation {
+
+inline constexpr model::Coord BLOCK = 10;
+
+// Решётка streets x streets улиц; каждая улица собрана из отрезков длиной
+// в квартал, как в картах, нарисованных по кварталам. Офисы стоят на каждом
+// пятом перекрёстке по диагонали.
+inline model::Map MakeLatticeMap(int streets, double dog_speed = 4) {
+  using namespace model;
+
+  Map map{Map::Id{"lattice" + std::to_string(streets)}, "Lattice"};
+  map.SetDefaultDogSpeed(dog_speed);
+  map.SetBagCapacity(3);
+  map.SetLootValues({10, 20, 30});
+  for (int line = 0; line < streets; ++line) {
+    for (int block = 0; block + 1 < streets; ++block) {
+      map.AddRoad(Road{Road::HORIZONTAL, Point{block * BLOCK, line * BLOCK}, (block + 1) * BLOCK});
+      map.AddRoad(Road{Road::VERTICAL, Point{line * BLOCK, block * BLOCK}, (block + 1) * BLOCK});
+    }
+  }
+  for (int i = 0; i < streets; i += 5) {
+    map.AddOffice(Office{Office::Id{"o" + std::to_string(i)}, Point{i * BLOCK, i * BLOCK}, {0, 0}});
+  }
+  return map;
+}
+
+/*
+ * Игра без HTTP-сервера: одна сессия на синтетической карте и игроки,
+ * собаки которых бегают по случайным командам. Все случайные величины
+ * берутся из генератора с заданным зерном, поэтому прогоны повторяемы.
+ */
+class Simulation {
+ public:
+  Simulation(int streets, int dogs, unsigned seed = 1)
+      : random_{seed}, intersection_{0, streets - 1} {
+    game_.AddMap(MakeLatticeMap(streets));
+    const model::Map& map = game_.GetMaps().back();
+    session_ = game_.FindSessionForJoin(map.GetId()).get();
+
+    for (int i = 0; i < dogs; ++i) {
+      const auto& player =
+          players_.AddPlayer(model::Dog{"dog" + std::to_string(i)}, *session_);
+      model::Dog& added = player.GetDog();
+      added.MoveDog(RandomIntersection());
+      Steer(added);
+    }
+  }
+
+  model::Game& GetGame() {
+    return game_;
+  }
+
+  model::Players& GetPlayers() {
+    return players_;
+  }
+
+  model::GameSession& GetSession() {
+    return *session_;
+  }
+
+  // Раскладывает count трофеев по случайным перекрёсткам
+  void ScatterLoot(int count) {
+    for (int i = 0; i < count; ++i) {
+      const auto type = static_cast<size_t>(random_() % 3);
+      session_->AddLoot({type, 10, RandomIntersection()});
+    }
+  }
+
+  // Поворачивает остановившихся собак и изредка - бегущих, как это делали бы игроки
+  void SteerDogs() {
+    for (const auto& player : players_.GetAllPlayers()) {
+      model::Dog& dog = player.GetDog();
+      if (dog.GetSpeed() == MoveInfo::Speed{0, 0} || random_() % 50 == 0) {
+        Steer(dog);
+      }
+    }
+  }
+
+ private:
+  MoveInfo::Position RandomIntersection() {
+    return {static_cast<double>(intersection_(random_) * BLOCK),
+            static_cast<double>(intersection_(random_) * BLOCK)};
+  }
+
+  void Steer(model::Dog& dog) {
+    static const std::array<std::string, 4> directions{"L", "R", "U", "D"};
+    dog.SetDogDirSpeed(directions[random_() % directions.size()],
+                       session_->GetMapDefaultSpeed());
+  }
+
+  std::mt19937 random_;
+  std::uniform_int_distribution<int> intersection_;
+  model::Game game_;
+  model::Players players_;
+  model::GameSession* session_ = nullptr;
+};
+
+}  // namespace simulation
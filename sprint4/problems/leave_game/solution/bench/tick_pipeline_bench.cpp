@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+
+#include <boost/signals2.hpp>
+
+#include <chrono>
+#include <string>
+
+#include "../src/tick_pipeline.h"
+#include "simulation.h"
+
+namespace {
+
+using std::chrono::milliseconds;
+
+constexpr int STAGES = 6;
+
+// Накладные расходы на тик без работы в стадиях: конвейер (timed - с таймерами стадий)
+// против прежней рассылки через boost::signals2
+void BM_TickPipelineOverhead(benchmark::State& state) {
+  game_time::TickPipeline pipeline;
+  metrics::Histogram duration;
+  int calls = 0;
+  for (int i = 0; i < STAGES; ++i) {
+    pipeline.AddStage("stage" + std::to_string(i), [&calls](milliseconds) { ++calls; },
+                      state.range(0) ? &duration : nullptr);
+  }
+  for (auto _ : state) {
+    pipeline.Run(milliseconds{10});
+  }
+  benchmark::DoNotOptimize(calls);
+}
+
+void BM_Signals2Overhead(benchmark::State& state) {
+  boost::signals2::signal<void(milliseconds)> signal;
+  int calls = 0;
+  for (int i = 0; i < STAGES; ++i) {
+    signal.connect([&calls](milliseconds) { ++calls; });
+  }
+  for (auto _ : state) {
+    signal(milliseconds{10});
+  }
+  benchmark::DoNotOptimize(calls);
+}
+
+// Тик игры через конвейер: фазы движения, столкновений и трофеев
+void BM_GameTickPipeline(benchmark::State& state) {
+  simulation::Simulation simulation{static_cast<int>(state.range(0)),
+                                    static_cast<int>(state.range(1))};
+  model::Game& game = simulation.GetGame();
+  const auto seconds = [](milliseconds delta) { return delta.count() / 1000.0; };
+
+  game_time::TickPipeline pipeline;
+  pipeline.AddStage("movement", [&](milliseconds delta) { game.TickMovement(seconds(delta)); });
+  pipeline.AddStage("collisions",
+                    [&](milliseconds delta) { game.TickCollisions(seconds(delta)); });
+  pipeline.AddStage("loot", [&](milliseconds delta) { game.TickLoot(seconds(delta)); });
+
+  for (auto _ : state) {
+    pipeline.Run(milliseconds{10});
+  }
+}
+
+BENCHMARK(BM_TickPipelineOverhead)->ArgName("timed")->Arg(0)->Arg(1)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_Signals2Overhead)->Unit(benchmark::kNanosecond);
+BENCHMARK(BM_GameTickPipeline)
+    ->ArgNames({"streets", "dogs"})
+    ->Args({10, 100})
+    ->Args({50, 1000})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace admission {
+
+using Clock = std::chrono::steady_clock;
+
+// Ограничения для одного эндпоинта
+struct EndpointLimits {
+  // Сколько запросов может одновременно ждать strand или выполняться
+  std::size_t max_in_flight = 256;
+  // Сколько запрос может простоять в очереди strand, прежде чем его отклонят
+  std::chrono::milliseconds queue_budget{200};
+  // Значение заголовка Retry-After в ответе 503
+  std::chrono::seconds retry_after{1};
+};
+
+/*
+ * Контроль допуска запросов к API.
+ * Каждый допущенный запрос получает билет, который учитывается в счётчике
+ * эндпоинта, пока запрос не обработан. Запросы сверх лимита и запросы,
+ * слишком долго простоявшие в очереди strand, отклоняются ответом 503.
+ */
+class AdmissionController {
+  struct Endpoint {
+    explicit Endpoint(EndpointLimits limits) : limits(limits) {
+    }
+
+    EndpointLimits limits;
+    std::atomic<std::size_t> in_flight{0};
+  };
+
+ public:
+  class Ticket {
+   public:
+    Ticket(Endpoint& endpoint, Clock::time_point enqueued) noexcept
+        : endpoint_(&endpoint), enqueued_(enqueued) {
+    }
+
+    Ticket(const Ticket&) = delete;
+    Ticket& operator=(const Ticket&) = delete;
+
+    Ticket(Ticket&& other) noexcept
+        : endpoint_(std::exchange(other.endpoint_, nullptr)), enqueued_(other.enqueued_) {
+    }
+    Ticket& operator=(Ticket&& other) noexcept {
+      if (this != &other) {
+        Release();
+        endpoint_ = std::exchange(other.endpoint_, nullptr);
+        enqueued_ = other.enqueued_;
+      }
+      return *this;
+    }
+
+    ~Ticket() {
+      Release();
+    }
+
+    // Время, прошедшее с момента допуска запроса
+    Clock::duration QueueTime(Clock::time_point now = Clock::now()) const noexcept {
+      return now - enqueued_;
+    }
+
+    // Запрос простоял в очереди дольше бюджета эндпоинта,
+    // его следует отклонить, не выполняя
+    bool IsExpired(Clock::time_point now = Clock::now()) const noexcept {
+      return QueueTime(now) > endpoint_->limits.queue_budget;
+    }
+
+    std::chrono::seconds GetRetryAfter() const noexcept {
+      return endpoint_->limits.retry_after;
+    }
+
+   private:
+    void Release() noexcept {
+      if (endpoint_) {
+        endpoint_->in_flight.fetch_sub(1, std::memory_order_relaxed);
+        endpoint_ = nullptr;
+      }
+    }
+
+    Endpoint* endpoint_;
+    Clock::time_point enqueued_;
+  };
+
+  explicit AdmissionController(EndpointLimits default_limits = {})
+      : default_limits_(default_limits) {
+  }
+
+  // Задаёт ограничения эндпоинта. Вызывается до начала обработки запросов.
+  void SetLimits(std::string endpoint, EndpointLimits limits) {
+    endpoints_.insert_or_assign(std::move(endpoint), std::make_unique<Endpoint>(limits));
+  }
+
+  const EndpointLimits& GetDefaultLimits() const noexcept {
+    return default_limits_;
+  }
+
+  // Допускает запрос к эндпоинту или возвращает std::nullopt, если
+  // лимит одновременно обрабатываемых запросов исчерпан.
+  // Эндпоинты без явно заданных ограничений делят общий счётчик.
+  std::optional<Ticket> TryAdmit(std::string_view endpoint) noexcept {
+    Endpoint& ep = FindEndpoint(endpoint);
+    std::size_t current = ep.in_flight.load(std::memory_order_relaxed);
+    do {
+      if (current >= ep.limits.max_in_flight) {
+        return std::nullopt;
+      }
+    } while (!ep.in_flight.compare_exchange_weak(current, current + 1,
+                                                 std::memory_order_relaxed));
+    return Ticket{ep, Clock::now()};
+  }
+
+  std::chrono::seconds GetRetryAfter(std::string_view endpoint) noexcept {
+    return FindEndpoint(endpoint).limits.retry_after;
+  }
+
+ private:
+  Endpoint& FindEndpoint(std::string_view endpoint) noexcept {
+    if (auto it = endpoints_.find(endpoint); it != endpoints_.end()) {
+      return *it->second;
+    }
+    return shared_;
+  }
+
+  EndpointLimits default_limits_;
+  Endpoint shared_{default_limits_};
+  std::map<std::string, std::unique_ptr<Endpoint>, std::less<>> endpoints_;
+};
+
+}  // namespace admission
@@ -1,47 +1,235 @@
 // application.cpp
 #include "application.h"
+#include "log.h"
+#include "metrics.h"
+
+#include <iterator>
+#include <utility>
 
 namespace app {
 
 Application::Application(model::Game&& game, extra_data::MapsExtra&& extra,
                          const std::string& db_url)
-    : game_(std::move(game)),
-      maps_extra_(std::move(extra)),
-      database_(std::make_unique<db::Database>(db_url)) {
+    : database_(std::make_unique<db::Database>(db_url)) {
   database_->Initialize();  // Проверяем и создаем таблицы при необходимости
-  players_.SetTimeWaitDog(game.GetSettings().dog_retirement_time);
+  auto& partition = *partitions_.emplace_back(
+      std::make_unique<Partition>(0, std::move(game), std::move(extra)));
+  partition.players.SetTimeWaitDog(partition.game.GetSettings().dog_retirement_time);
+  partition.tick_pipeline = BuildTickPipeline(partition, 0);
 }
 
-Application::~Application() {
-  if (players_connection_.connected()) {
-    players_connection_.disconnect();
-  }
-  if (save_connection_.connected()) {
-    save_connection_.disconnect();
-  }
+std::unique_ptr<game_time::TickPipeline> Application::BuildTickPipeline(Partition& partition,
+                                                                        unsigned workers) {
+  const auto seconds = [](milliseconds delta) {
+    return static_cast<double>(delta.count()) / 1000.0;
+  };
+  auto& server_metrics = metrics::Server();
+  auto& game = partition.game;
+  auto pipeline = std::make_unique<game_time::TickPipeline>(workers);
+
+  pipeline->AddStage(
+      "movement", [&game, seconds](milliseconds delta) { game.TickMovement(seconds(delta)); },
+      &server_metrics.tick_movement);
+  pipeline->AddStage(
+      "collisions", [&game, seconds](milliseconds delta) { game.TickCollisions(seconds(delta)); },
+      &server_metrics.tick_collisions);
+  pipeline->AddStage(
+      "loot", [&game, seconds](milliseconds delta) { game.TickLoot(seconds(delta)); },
+      &server_metrics.tick_loot);
+  pipeline->AddStage(
+      "retirement",
+      [this, &partition, seconds](milliseconds delta) {
+        partition.players.OnTick(seconds(delta), [this](const model::Dog& dog, double play_time) {
+          database_->AddRetiredPlayer(dog.GetName(), dog.GetScore(), play_time);
+        });
+      },
+      &server_metrics.tick_retirement);
+  // Сериализация и публикация только читают часть и могут идти одновременно
+  pipeline->AddStageAfter(
+      {"retirement"}, "snapshot",
+      [&partition](milliseconds) {
+        if (partition.snapshot_due) {
+          partition.snapshot = model::SerializeGamePart({partition.game, partition.players});
+        }
+      },
+      &server_metrics.tick_snapshot);
+  pipeline->AddStageAfter(
+      {"retirement"}, "publish",
+      [this, &partition](milliseconds) { PublishTickMetrics(partition); },
+      &server_metrics.tick_publish);
+  return pipeline;
+}
 
-  if (save_stream_.is_open()) {
-    save_stream_.close();
+void Application::PublishTickMetrics(Partition& partition) {
+  auto& server_metrics = metrics::Server();
+  const auto& sessions = partition.game.GetGameSessions();
+  partition.sessions = sessions.size();
+  for (const auto& session : sessions) {
+    server_metrics.session_dogs.Record(session->GetDogs().size());
+    server_metrics.session_loot.Record(session->GetLoots().size());
   }
 }
 
 model::Game& Application::GetGame() {
-  return game_;
+  return CurrentPartition().game;
 }
 
 extra_data::MapsExtra& Application::GetExtraData() {
-  return maps_extra_;
+  return CurrentPartition().maps_extra;
 }
 
 model::Players& Application::GetPlayers() {
-  return players_;
+  return CurrentPartition().players;
+}
+
+std::uint64_t Application::GetMapsVersion() {
+  return CurrentPartition().maps_version;
+}
+
+unsigned Application::GetCurrentPartition() const noexcept {
+  const shard::Shard* current = shard::Shard::Current();
+  return shards_ && current ? current->GetIndex() : 0;
+}
+
+unsigned Application::GetTokenPartition(const model::Token& token) const {
+  if (partitions_.size() == 1) {
+    return 0;
+  }
+  if (const auto it = restored_token_partitions_.find(token);
+      it != restored_token_partitions_.end()) {
+    return it->second;
+  }
+  return model::TokenPartition(token, GetPartitionCount());
+}
+
+unsigned Application::ChooseJoinPartition(const model::Map::Id& map_id) {
+  if (partitions_.size() == 1) {
+    return 0;
+  }
+  // Карты у частей одинаковые, поэтому о карте можно спросить свою часть
+  const model::Game& game = GetGame();
+  const model::Map* map = game.FindMap(map_id);
+  if (!map) {
+    return GetCurrentPartition();
+  }
+  if (game.GetSessionCapacity(*map) == 0) {
+    return model::MapPartition(map_id, GetPartitionCount());
+  }
+  // Сессии карты с ограничением распределяются по частям: игроки входят в части по кругу,
+  // а внутри части заполняют её сессии как обычно
+  return next_join_partition_.fetch_add(1, std::memory_order_relaxed) % GetPartitionCount();
+}
+
+std::vector<model::GamePart> Application::GetGameParts() {
+  std::vector<model::GamePart> parts;
+  for (auto& partition : partitions_) {
+    parts.push_back({partition->game, partition->players});
+  }
+  return parts;
+}
+
+void Application::ForEachPartition(std::function<void(Partition&)> work,
+                                   std::function<void()> done) {
+  if (!shards_) {
+    for (auto& partition : partitions_) {
+      work(*partition);
+    }
+    return done();
+  }
+
+  auto remaining = std::make_shared<std::atomic<std::size_t>>(partitions_.size());
+  for (auto& partition : partitions_) {
+    (*shards_)[partition->index].Post([this, &partition = *partition, work, done, remaining] {
+      work(partition);
+      // Последняя часть передаёт итоги в поток тиков
+      if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        (*shards_)[0].Post(done);
+      }
+    });
+  }
 }
 
 void Application::SetGameSettings(const std::optional<Args>& config) {
   if (!config)
     return;
 
-  game_.GetSettings().random_spawn = config->randomize_spawn_points;
+  auto& partition = *partitions_.front();
+  partition.game.GetSettings().random_spawn = config->randomize_spawn_points;
+
+  // Зерно нужно задать до восстановления сессий: от него зависят их генераторы
+  if (config->random_seed || !config->record_file.empty()) {
+    random_seed_ = config->random_seed.value_or(std::random_device{}());
+    partition.game.SetRandomSeed(*random_seed_);
+  }
+
+  if (config->tick_workers > 0) {
+    partition.tick_pipeline = BuildTickPipeline(partition, config->tick_workers);
+  }
+}
+
+void Application::SplitIntoShards(shard::ShardSet& shards) {
+  if (!partitions_.front()->game.GetGameSessions().empty()) {
+    throw std::logic_error("Game must be split into shards before sessions are created");
+  }
+  shards_ = &shards;
+
+  // Части копируют игру без сессий: карты у копий общие
+  const auto& first = *partitions_.front();
+  for (unsigned i = 1; i < shards.Size(); ++i) {
+    auto& partition = *partitions_.emplace_back(
+        std::make_unique<Partition>(i, model::Game{first.game}, first.maps_extra));
+    partition.game.SetRandomSeed(random_seed_ ? model::PartitionSeed(*random_seed_, i)
+                                              : std::random_device{}());
+  }
+  for (auto& partition : partitions_) {
+    partition->players.SetTimeWaitDog(partition->game.GetSettings().dog_retirement_time);
+    partition->players.SetPartition(partition->index, GetPartitionCount());
+    // Шарды уже занимают все ядра, поэтому стадии тика части идут в её потоке
+    partition->tick_pipeline = BuildTickPipeline(*partition, 0);
+  }
+}
+
+void Application::LoadState(std::istream& in) {
+  model::LoadGameParts(GetGameParts(), in);
+
+  for (const auto& partition : partitions_) {
+    for (const auto& player : partition->players.GetAllPlayers()) {
+      if (model::TokenPartition(player.GetToken(), GetPartitionCount()) != partition->index) {
+        restored_token_partitions_.emplace(player.GetToken(), partition->index);
+      }
+    }
+  }
+}
+
+void Application::StartRecording(const std::optional<Args>& config) {
+  if (!config || config->record_file.empty()) {
+    return;
+  }
+  recorder_ = std::make_unique<recording::Recorder>(config->record_file,
+                                                    random_seed_.value_or(0), GetGameParts());
+  recording_ = true;
+}
+
+const model::Player* Application::JoinGame(const model::Map::Id& map_id,
+                                           const std::string& user_name) {
+  Partition& partition = CurrentPartition();
+  const model::Player* player =
+      model::JoinGame(partition.game, partition.players, map_id, user_name);
+  if (player && recording_.load(std::memory_order_relaxed)) {
+    partition.recorded_events.push_back(
+        {recording::Clock::now(), player->GetToken(),
+         recording::JoinEvent{*map_id, user_name, partition.index}});
+  }
+  return player;
+}
+
+void Application::ApplyPlayerAction(model::Player& player, const std::string& direction) {
+  Partition& partition = CurrentPartition();
+  if (recording_.load(std::memory_order_relaxed)) {
+    partition.recorded_events.push_back({recording::Clock::now(), player.GetToken(),
+                                         recording::ActionEvent{0, direction}});
+  }
+  partition.players.ApplyAction(player, direction);
 }
 
 void Application::SetGameTicker(const std::optional<Args>& config, Strand& strand) {
@@ -49,20 +237,13 @@ void Application::SetGameTicker(const std::optional<Args>& config, Strand& stran
     return;
 
   if (config->tick_period > 0) {
-    game_.GetSettings().ticker = std::make_shared<game_time::Ticker>(
+    auto& ticker = partitions_.front()->game.GetSettings().ticker;
+    ticker = std::make_shared<game_time::Ticker>(
         strand, std::chrono::milliseconds(config->tick_period),
-        [&](std::chrono::milliseconds delta) {
-          // Основной тик игры
-          game_.Tick(static_cast<double>(delta.count()) / 1000.0);
-
-          // Сигнал тика (может использоваться другими подписчиками)
-          tick_signal_(delta);
-        });
-    game_.GetSettings().ticker->Start();
+        [this](std::chrono::milliseconds delta) { RunTick(delta); },
+        game_time::TickerSettings{config->fixed_timestep, config->max_catch_up_steps});
+    ticker->Start();
   }
-  players_connection_ = tick_signal_.connect([this](milliseconds delta) {
-    players_.OnTick(static_cast<double>(delta.count()) / 1000.0, &*database_);
-  });
 }
 
 void Application::SetSaveSettings(const std::optional<Args>& config) {
@@ -78,50 +259,182 @@ void Application::SetSaveSettings(const std::optional<Args>& config) {
   if (!save_stream_.is_open()) {
     throw std::runtime_error("Failed to open save file: " + temp_save_filepath_.string());
   }
+}
+
+void Application::ManualTick(milliseconds delta) {
+  RunTick(delta);
+}
 
-  // Подписываемся на сигнал тика
-  if (game_.GetSettings().ticker) {
-    save_connection_ =
-        tick_signal_.connect([this](milliseconds delta) { this->TrySaveState(delta); });
+void Application::AfterTicks(std::function<void()> fn) {
+  if (!tick_running_) {
+    return fn();
   }
+  after_ticks_.push_back(std::move(fn));
 }
 
-void Application::ManualTick(milliseconds delta) {
-  game_.Tick(static_cast<double>(delta.count()) / 1000.0);
-  tick_signal_(delta);
+void Application::RunTick(milliseconds delta) {
+  // Тик, пришедший во время предыдущего, ждёт его: итоги тиков передаются по порядку
+  pending_ticks_.push_back(delta);
+  if (!tick_running_) {
+    StartTick();
+  }
+}
+
+void Application::StartTick() {
+  tick_running_ = true;
+  auto results = std::make_shared<TickResults>();
+  results->delta = pending_ticks_.front();
+  pending_ticks_.pop_front();
+  results->start = std::chrono::steady_clock::now();
+  results->snapshot_due = IsSaveDue(results->delta);
+  results->events.resize(partitions_.size());
+  results->snapshots.resize(partitions_.size());
+  results->sessions.resize(partitions_.size());
+
+  ForEachPartition(
+      [results](Partition& partition) {
+        // События до тика записываются перед ним
+        results->events[partition.index] = std::exchange(partition.recorded_events, {});
+        partition.snapshot_due = results->snapshot_due;
+        partition.tick_pipeline->Run(results->delta);
+        results->snapshots[partition.index] = std::exchange(partition.snapshot, std::nullopt);
+        results->sessions[partition.index] = partition.sessions;
+      },
+      [this, results] { FinishTick(*results); });
+}
+
+void Application::FinishTick(TickResults& results) {
+  if (recorder_) {
+    std::vector<recording::PlayerEvent> events;
+    for (auto& partition_events : results.events) {
+      std::move(partition_events.begin(), partition_events.end(), std::back_inserter(events));
+    }
+    recorder_->RecordTick(results.delta, std::move(events));
+  }
+
+  if (results.snapshot_due) {
+    std::vector<model::SerGamePart> parts;
+    for (auto& snapshot : results.snapshots) {
+      parts.push_back(std::move(*snapshot));
+    }
+    AtomicSave(std::move(parts));
+  }
+
+  auto& server_metrics = metrics::Server();
+  std::size_t sessions = 0;
+  for (const std::size_t count : results.sessions) {
+    sessions += count;
+  }
+  server_metrics.sessions.Set(static_cast<std::int64_t>(sessions));
+  server_metrics.tick_total.Record(std::chrono::steady_clock::now() - results.start);
 
-  // Если нет автоматических тиков, проверяем сохранение здесь
-  if (!game_.GetSettings().ticker) {
-    TrySaveState(delta);
+  tick_running_ = false;
+  if (!pending_ticks_.empty()) {
+    return StartTick();
+  }
+  for (auto& fn : std::exchange(after_ticks_, {})) {
+    fn();
   }
 }
 
-void Application::TrySaveState(milliseconds delta) {
-  if (!save_stream_.is_open() || save_period_.count() <= 0)
+void Application::RunOverdueTick() {
+  if (GetCurrentPartition() != 0) {
     return;
+  }
+  if (auto& ticker = partitions_.front()->game.GetSettings().ticker) {
+    ticker->RunIfOverdue();
+  }
+}
 
-  time_since_last_save_ += delta;
+void Application::ReloadMapsAsync(Strand& strand,
+                                  std::function<json_loader::GamePackage()> load) {
+  if (reloading_maps_.exchange(true)) {
+    return;
+  }
+  // Предыдущий поток уже передал карты в strand и завершается
+  if (reload_thread_.joinable()) {
+    reload_thread_.join();
+  }
 
-  if (time_since_last_save_ >= save_period_) {
-    AtomicSave();
+  reload_thread_ = std::jthread([this, &strand, load = std::move(load)] {
+    try {
+      // Разбор конфигурации идёт вне strand: тики и запросы его не ждут
+      net::post(strand, [this, package = load()]() mutable {
+        ApplyMapsReload(std::move(package));
+      });
+    } catch (const std::exception& ex) {
+      ServerErrorLog(EXIT_FAILURE, ex.what(), "maps reload");
+      reloading_maps_ = false;
+    }
+  });
+}
+
+void Application::ApplyMapsReload(json_loader::GamePackage package) {
+  // Повтор записи загружает карты из конфигурации один раз и разошёлся бы с ней
+  if (recorder_) {
+    recording_ = false;
+    recorder_.reset();
+    GameRecordingStoppedLog("maps reloaded");
   }
+
+  struct Reload {
+    json_loader::GamePackage package;
+    std::vector<model::Game::MapsReload> results;
+  };
+  auto reload = std::make_shared<Reload>(std::move(package));
+  reload->results.resize(partitions_.size());
+
+  // Каждая часть получает копию загруженной игры; набор карт у копий общий
+  ForEachPartition(
+      [reload](Partition& partition) {
+        reload->results[partition.index] =
+            partition.game.ReloadMaps(model::Game{reload->package.game});
+        partition.maps_extra = reload->package.extra_data;
+        ++partition.maps_version;
+      },
+      [this, reload] {
+        model::Game::MapsReload total;
+        for (const auto& result : reload->results) {
+          total.kept += result.kept;
+          total.migrated += result.migrated;
+          total.retired += result.retired;
+        }
+        MapsReloadLog(reload->package.game.GetMaps().size(), total.kept, total.migrated,
+                      total.retired);
+        reloading_maps_ = false;
+      });
+}
+
+bool Application::IsSaveDue(milliseconds delta) {
+  if (!save_stream_.is_open() || save_period_.count() <= 0)
+    return false;
+
+  time_since_last_save_ += delta;
+  return time_since_last_save_ >= save_period_;
 }
 
 void Application::SaveStateBeforeExit() {
-  if (!save_filepath_.empty()) {
-    AtomicSave();
+  if (save_filepath_.empty()) {
+    return;
   }
+  std::vector<model::SerGamePart> parts;
+  for (const auto& part : GetGameParts()) {
+    parts.push_back(model::SerializeGamePart(part));
+  }
+  AtomicSave(std::move(parts));
 }
 
-void Application::AtomicSave() {
+void Application::AtomicSave(std::vector<model::SerGamePart> parts) {
   if (!save_stream_.is_open())
     return;
 
   try {
+    metrics::ScopedTimer timer{metrics::Server().snapshot_duration};
+
     // 1. Записываем данные во временный файл
     save_stream_.seekp(0);
     save_stream_.clear();
-    model::SaveGame(game_, players_, save_stream_);
+    model::SaveGameParts(std::move(parts), save_stream_);
     save_stream_.flush();
 
     // 2. Атомарно переименовываем временный файл в целевой
@@ -1,62 +1,168 @@
 #pragma once
 
-#include <boost/signals2.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <functional>
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "model.h"
 #include "extra_data.h"
+#include "json_loader.h"
 #include "command_line.h"
 #include "serialization.h"
 #include "database.h"
+#include "game_recording.h"
+#include "tick_pipeline.h"
+#include "shard.h"
 
 namespace net = boost::asio;
-namespace sig = boost::signals2;
 
 using Strand = net::strand<net::io_context::executor_type>;
 
 namespace app {
 
+/*
+ * Игра делится на части (model::GamePart) по одной на шард. Часть владеет своими сессиями
+ * и игроками и выполняется только в потоке своего шарда, поэтому запросы игроков разных
+ * частей и тики частей идут параллельно и без блокировок. Без шардов часть одна и работает
+ * в strand игры.
+ *
+ * Тик начинается в потоке тиков (strand игры, в режиме шардов - шард 0): каждая часть
+ * выполняет его стадии у себя, а последняя закончившая передаёт итоги в поток тиков,
+ * который пишет снимок, запись и общие метрики.
+ */
 class Application {
  public:
   using milliseconds = std::chrono::milliseconds;
-  using TickSignal = boost::signals2::signal<void(milliseconds)>;
 
   explicit Application(model::Game&& game, extra_data::MapsExtra&& extra,
                        const std::string& db_url);
-  ~Application();
 
+  // Часть игры потока, из которого вызван метод: часть шарда или единственная часть
   model::Game& GetGame();
   extra_data::MapsExtra& GetExtraData();
   model::Players& GetPlayers();
+  // Растёт с каждой перезагрузкой карт в этой части
+  std::uint64_t GetMapsVersion();
+
+  unsigned GetPartitionCount() const noexcept {
+    return static_cast<unsigned>(partitions_.size());
+  }
+  unsigned GetCurrentPartition() const noexcept;
+  // Часть, в которой живёт игрок с этим токеном. Вызывается из потока любой части.
+  unsigned GetTokenPartition(const model::Token& token) const;
+  // Часть для нового игрока карты. Вызывается из потока любой части.
+  unsigned ChooseJoinPartition(const model::Map::Id& map_id);
 
   void SetGameSettings(const std::optional<Args>& config);
+  // Делит игру на части по числу шардов. Вызывается до восстановления состояния
+  // и до SetGameTicker; strand тиков должен работать в шарде 0.
+  void SplitIntoShards(shard::ShardSet& shards);
   void SetGameTicker(const std::optional<Args>& config, Strand& strand);
   void SetSaveSettings(const std::optional<Args>& config);
+  // Восстанавливает сессии и игроков из снимка, раскладывая их по частям
+  void LoadState(std::istream& in);
+  // Начинает запись, если она включена. Вызывается после восстановления состояния,
+  // чтобы снимок в заголовке записи совпадал с тем, с чего начнётся повтор.
+  void StartRecording(const std::optional<Args>& config);
+
+  // Вход в игру и действие игрока в текущей части; попадают в запись, если она ведётся
+  const model::Player* JoinGame(const model::Map::Id& map_id, const std::string& user_name);
+  void ApplyPlayerAction(model::Player& player, const std::string& direction);
 
-  // Метод для ручного вызова при обработке /api/v1/game/tick
+  // Метод для ручного вызова при обработке /api/v1/game/tick. Вызывается в потоке тиков.
   void ManualTick(milliseconds delta);
+  // Вызывает fn в потоке тиков, когда завершатся все начатые тики
+  void AfterTicks(std::function<void()> fn);
 
+  // Выполняет автоматический тик, если он просрочен. Вызывается перед обработкой запроса;
+  // действует только в потоке тиков.
+  void RunOverdueTick();
+
+  // Вызывается, когда части не работают: после остановки шардов или внутри strand игры
   void SaveStateBeforeExit();
 
+  // Загружает карты функцией load в фоновом потоке и подменяет их во всех частях, между
+  // тиками. Запросы обслуживаются и во время загрузки. Вызов во время предыдущей загрузки
+  // пропускается. Ошибка загрузки оставляет прежние карты.
+  void ReloadMapsAsync(Strand& strand, std::function<json_loader::GamePackage()> load);
+
   db::Database& GetDatabase() {
     return *database_;
   }
 
  private:
-  void TrySaveState(milliseconds delta);
-  void AtomicSave();
-
-  model::Game game_;
-  extra_data::MapsExtra maps_extra_;
-  model::Players players_;
+  struct Partition {
+    Partition(unsigned index, model::Game game, extra_data::MapsExtra maps_extra)
+        : index{index}, game{std::move(game)}, maps_extra{std::move(maps_extra)} {
+    }
+
+    unsigned index;
+    model::Game game;
+    model::Players players;
+    extra_data::MapsExtra maps_extra;
+    std::uint64_t maps_version = 0;
+    std::unique_ptr<game_time::TickPipeline> tick_pipeline;
+
+    // Входы и действия с прошлого тика, пока ведётся запись
+    std::vector<recording::PlayerEvent> recorded_events;
+    // Итоги тика для потока тиков
+    bool snapshot_due = false;
+    std::optional<model::SerGamePart> snapshot;
+    std::size_t sessions = 0;
+  };
+
+  // Итоги тика, которые части передают потоку тиков
+  struct TickResults {
+    milliseconds delta;
+    std::chrono::steady_clock::time_point start;
+    bool snapshot_due = false;
+    std::vector<std::vector<recording::PlayerEvent>> events;
+    std::vector<std::optional<model::SerGamePart>> snapshots;
+    std::vector<std::size_t> sessions;
+  };
+
+  Partition& CurrentPartition() {
+    return *partitions_[GetCurrentPartition()];
+  }
+  std::vector<model::GamePart> GetGameParts();
+  // Выполняет work в потоке каждой части, затем done в потоке тиков.
+  // Без шардов всё выполняется сразу в вызывающем потоке.
+  void ForEachPartition(std::function<void(Partition&)> work, std::function<void()> done);
+
+  void RunTick(milliseconds delta);
+  void StartTick();
+  void FinishTick(TickResults& results);
+  // Стадии тика части: движение, столкновения, трофеи, уход игроков, затем сериализация
+  // части для снимка и публикация метрик, которые только читают её состояние
+  std::unique_ptr<game_time::TickPipeline> BuildTickPipeline(Partition& partition,
+                                                             unsigned workers);
+  void PublishTickMetrics(Partition& partition);
+  // Учитывает время тика и сообщает, пора ли сохранить состояние
+  bool IsSaveDue(milliseconds delta);
+  void AtomicSave(std::vector<model::SerGamePart> parts);
+  void ApplyMapsReload(json_loader::GamePackage package);
+
+  std::vector<std::unique_ptr<Partition>> partitions_;
+  shard::ShardSet* shards_ = nullptr;
   std::unique_ptr<db::Database> database_;
-  TickSignal tick_signal_;
+  // Части игроков из снимка, чьи токены TokenPartition отнёс бы к другой части.
+  // Заполняется при восстановлении и дальше только читается.
+  std::unordered_map<model::Token, unsigned, util::TaggedHasher<model::Token>>
+      restored_token_partitions_;
+  std::atomic<unsigned> next_join_partition_ = 0;
 
-  sig::connection players_connection_;
+  // Используются в потоке тиков
+  std::deque<milliseconds> pending_ticks_;
+  bool tick_running_ = false;
+  std::vector<std::function<void()>> after_ticks_;
 
   // Настройки сохранения
   std::filesystem::path save_filepath_;
@@ -64,7 +170,16 @@ class Application {
   milliseconds save_period_{0};
   milliseconds time_since_last_save_{0};
   std::ofstream save_stream_;
-  sig::connection save_connection_;
+
+  // Заданное зерно случайных событий; части получают зёрна PartitionSeed
+  std::optional<std::uint64_t> random_seed_;
+  std::unique_ptr<recording::Recorder> recorder_;
+  // Части копят события, пока это так; сбрасывается в потоке тиков
+  std::atomic_bool recording_ = false;
+
+  std::atomic_bool reloading_maps_ = false;
+  // Объявлен последним, чтобы разрушаться первым: поток загрузки обращается к приложению
+  std::jthread reload_thread_;
 };
 
 }  // namespace app
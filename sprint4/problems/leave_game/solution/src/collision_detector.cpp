@@ -1,5 +1,10 @@
 #include "collision_detector.h"
 #include <cassert>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace collision_detector {
 
@@ -50,30 +55,255 @@ static CollectionResult TryCollectPoint_Wrong2(geom::Point2D start, geom::Point2
   return CollectionResult(dist * dist, proj);
 }
 
-std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
-  std::vector<GatheringEvent> detected_events;
+//---------------------------Batches---------------------------
 
-  static auto eq_pt = [](geom::Point2D p1, geom::Point2D p2) {
-    return p1.x == p2.x && p1.y == p2.y;
-  };
+void ItemsBatch::Reserve(size_t count) {
+  x_.reserve(count);
+  y_.reserve(count);
+  width_.reserve(count);
+}
 
-  for (size_t g = 0; g < provider.GatherersCount(); ++g) {
-    Gatherer gatherer = provider.GetGatherer(g);
-    if (eq_pt(gatherer.start_pos, gatherer.end_pos)) {
-      continue;
+void ItemsBatch::Add(const Item& item) {
+  x_.push_back(item.position.x);
+  y_.push_back(item.position.y);
+  width_.push_back(item.width);
+}
+
+void ItemsBatch::Clear() {
+  x_.clear();
+  y_.clear();
+  width_.clear();
+}
+
+void GatherersBatch::Reserve(size_t count) {
+  start_x_.reserve(count);
+  start_y_.reserve(count);
+  end_x_.reserve(count);
+  end_y_.reserve(count);
+  width_.reserve(count);
+}
+
+void GatherersBatch::Add(const Gatherer& gatherer) {
+  start_x_.push_back(gatherer.start_pos.x);
+  start_y_.push_back(gatherer.start_pos.y);
+  end_x_.push_back(gatherer.end_pos.x);
+  end_y_.push_back(gatherer.end_pos.y);
+  width_.push_back(gatherer.width);
+}
+
+void GatherersBatch::Clear() {
+  start_x_.clear();
+  start_y_.clear();
+  end_x_.clear();
+  end_y_.clear();
+  width_.clear();
+}
+
+//---------------------------Kernels---------------------------
+
+namespace {
+
+// Отрезок перемещения собирателя с заранее посчитанными величинами.
+// Формулы и порядок операций совпадают с TryCollectPoint.
+struct Segment {
+  double a_x, a_y;
+  double v_x, v_y;
+  double v_len2;
+  double width;
+  size_t gatherer_id;
+};
+
+using KernelFn = void (*)(const ItemsView& items, const Segment& segment, size_t first_item,
+                          std::vector<GatheringEvent>& events);
+
+void CollectScalar(const ItemsView& items, const Segment& segment, size_t first_item,
+                   std::vector<GatheringEvent>& events) {
+  for (size_t i = first_item; i < items.x.size(); ++i) {
+    const double u_x = items.x[i] - segment.a_x;
+    const double u_y = items.y[i] - segment.a_y;
+    const double u_dot_v = u_x * segment.v_x + u_y * segment.v_y;
+    const double u_len2 = u_x * u_x + u_y * u_y;
+    const double proj_ratio = u_dot_v / segment.v_len2;
+    const double sq_distance = u_len2 - (u_dot_v * u_dot_v) / segment.v_len2;
+    const double radius = segment.width + items.width[i];
+
+    if (proj_ratio >= 0 && proj_ratio <= 1 && sq_distance <= radius * radius) {
+      events.push_back({.item_id = i,
+                        .gatherer_id = segment.gatherer_id,
+                        .sq_distance = sq_distance,
+                        .time = proj_ratio});
+    }
+  }
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define COLLISION_DETECTOR_X86
+
+// Добавляет события для предметов, отмеченных в битовой маске
+inline void PushCollected(int mask, size_t first_item, const double* proj_ratio,
+                          const double* sq_distance, size_t gatherer_id,
+                          std::vector<GatheringEvent>& events) {
+  while (mask) {
+    const int lane = __builtin_ctz(mask);
+    mask &= mask - 1;
+    events.push_back({.item_id = first_item + lane,
+                      .gatherer_id = gatherer_id,
+                      .sq_distance = sq_distance[lane],
+                      .time = proj_ratio[lane]});
+  }
+}
+
+__attribute__((target("sse2"))) void CollectSse2(const ItemsView& items, const Segment& segment,
+                                                 size_t first_item,
+                                                 std::vector<GatheringEvent>& events) {
+  constexpr size_t LANES = 2;
+  const __m128d a_x = _mm_set1_pd(segment.a_x);
+  const __m128d a_y = _mm_set1_pd(segment.a_y);
+  const __m128d v_x = _mm_set1_pd(segment.v_x);
+  const __m128d v_y = _mm_set1_pd(segment.v_y);
+  const __m128d v_len2 = _mm_set1_pd(segment.v_len2);
+  const __m128d width = _mm_set1_pd(segment.width);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d one = _mm_set1_pd(1.0);
+
+  size_t i = first_item;
+  for (; i + LANES <= items.x.size(); i += LANES) {
+    const __m128d u_x = _mm_sub_pd(_mm_loadu_pd(&items.x[i]), a_x);
+    const __m128d u_y = _mm_sub_pd(_mm_loadu_pd(&items.y[i]), a_y);
+    const __m128d u_dot_v = _mm_add_pd(_mm_mul_pd(u_x, v_x), _mm_mul_pd(u_y, v_y));
+    const __m128d u_len2 = _mm_add_pd(_mm_mul_pd(u_x, u_x), _mm_mul_pd(u_y, u_y));
+    const __m128d proj_ratio = _mm_div_pd(u_dot_v, v_len2);
+    const __m128d sq_distance = _mm_sub_pd(u_len2, _mm_div_pd(_mm_mul_pd(u_dot_v, u_dot_v), v_len2));
+    const __m128d radius = _mm_add_pd(width, _mm_loadu_pd(&items.width[i]));
+
+    const __m128d collected =
+        _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(proj_ratio, zero), _mm_cmple_pd(proj_ratio, one)),
+                   _mm_cmple_pd(sq_distance, _mm_mul_pd(radius, radius)));
+    if (const int mask = _mm_movemask_pd(collected)) {
+      alignas(16) double proj[LANES];
+      alignas(16) double dist[LANES];
+      _mm_store_pd(proj, proj_ratio);
+      _mm_store_pd(dist, sq_distance);
+      PushCollected(mask, i, proj, dist, segment.gatherer_id, events);
+    }
+  }
+  CollectScalar(items, segment, i, events);
+}
+
+__attribute__((target("avx2"))) void CollectAvx2(const ItemsView& items, const Segment& segment,
+                                                 size_t first_item,
+                                                 std::vector<GatheringEvent>& events) {
+  constexpr size_t LANES = 4;
+  const __m256d a_x = _mm256_set1_pd(segment.a_x);
+  const __m256d a_y = _mm256_set1_pd(segment.a_y);
+  const __m256d v_x = _mm256_set1_pd(segment.v_x);
+  const __m256d v_y = _mm256_set1_pd(segment.v_y);
+  const __m256d v_len2 = _mm256_set1_pd(segment.v_len2);
+  const __m256d width = _mm256_set1_pd(segment.width);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0);
+
+  size_t i = first_item;
+  for (; i + LANES <= items.x.size(); i += LANES) {
+    const __m256d u_x = _mm256_sub_pd(_mm256_loadu_pd(&items.x[i]), a_x);
+    const __m256d u_y = _mm256_sub_pd(_mm256_loadu_pd(&items.y[i]), a_y);
+    const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(u_x, v_x), _mm256_mul_pd(u_y, v_y));
+    const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(u_x, u_x), _mm256_mul_pd(u_y, u_y));
+    const __m256d proj_ratio = _mm256_div_pd(u_dot_v, v_len2);
+    const __m256d sq_distance =
+        _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), v_len2));
+    const __m256d radius = _mm256_add_pd(width, _mm256_loadu_pd(&items.width[i]));
+
+    const __m256d collected = _mm256_and_pd(
+        _mm256_and_pd(_mm256_cmp_pd(proj_ratio, zero, _CMP_GE_OQ),
+                      _mm256_cmp_pd(proj_ratio, one, _CMP_LE_OQ)),
+        _mm256_cmp_pd(sq_distance, _mm256_mul_pd(radius, radius), _CMP_LE_OQ));
+    if (const int mask = _mm256_movemask_pd(collected)) {
+      alignas(32) double proj[LANES];
+      alignas(32) double dist[LANES];
+      _mm256_store_pd(proj, proj_ratio);
+      _mm256_store_pd(dist, sq_distance);
+      PushCollected(mask, i, proj, dist, segment.gatherer_id, events);
     }
-    for (size_t i = 0; i < provider.ItemsCount(); ++i) {
-      Item item = provider.GetItem(i);
-      auto collect_result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
-
-      if (collect_result.IsCollected(gatherer.width + item.width)) {
-        GatheringEvent evt{.item_id = i,
-                           .gatherer_id = g,
-                           .sq_distance = collect_result.sq_distance,
-                           .time = collect_result.proj_ratio};
-        detected_events.push_back(evt);
+  }
+  CollectScalar(items, segment, i, events);
+}
+#endif
+
+KernelFn GetKernelFn(Kernel kernel) {
+  switch (kernel) {
+#ifdef COLLISION_DETECTOR_X86
+    case Kernel::AVX2:
+      return CollectAvx2;
+    case Kernel::SSE2:
+      return CollectSse2;
+#endif
+    default:
+      return CollectScalar;
+  }
+}
+
+}  // namespace
+
+bool IsKernelSupported(Kernel kernel) noexcept {
+  switch (kernel) {
+    case Kernel::SCALAR:
+      return true;
+#ifdef COLLISION_DETECTOR_X86
+    case Kernel::SSE2:
+      return __builtin_cpu_supports("sse2");
+    case Kernel::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+Kernel GetBestKernel() noexcept {
+  static const Kernel best = [] {
+    for (Kernel kernel : {Kernel::AVX2, Kernel::SSE2}) {
+      if (IsKernelSupported(kernel)) {
+        return kernel;
       }
     }
+    return Kernel::SCALAR;
+  }();
+  return best;
+}
+
+std::vector<GatheringEvent> FindGatherEvents(const ItemsView& items,
+                                             const GatherersView& gatherers) {
+  return FindGatherEvents(items, gatherers, GetBestKernel());
+}
+
+std::vector<GatheringEvent> FindGatherEvents(const ItemsView& items,
+                                             const GatherersView& gatherers, Kernel kernel) {
+  if (!IsKernelSupported(kernel)) {
+    throw std::invalid_argument("Collision kernel is not supported by this CPU");
+  }
+  assert(items.y.size() == items.x.size() && items.width.size() == items.x.size());
+
+  const KernelFn collect = GetKernelFn(kernel);
+  std::vector<GatheringEvent> detected_events;
+
+  for (size_t g = 0; g < gatherers.start_x.size(); ++g) {
+    const double a_x = gatherers.start_x[g];
+    const double a_y = gatherers.start_y[g];
+    const double v_x = gatherers.end_x[g] - a_x;
+    const double v_y = gatherers.end_y[g] - a_y;
+    if (gatherers.end_x[g] == a_x && gatherers.end_y[g] == a_y) {
+      continue;
+    }
+
+    const Segment segment{.a_x = a_x,
+                          .a_y = a_y,
+                          .v_x = v_x,
+                          .v_y = v_y,
+                          .v_len2 = v_x * v_x + v_y * v_y,
+                          .width = gatherers.width[g],
+                          .gatherer_id = g};
+    collect(items, segment, 0, detected_events);
   }
 
   std::sort(
@@ -83,4 +313,20 @@ std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provide
   return detected_events;
 }
 
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+  ItemsBatch items;
+  items.Reserve(provider.ItemsCount());
+  for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+    items.Add(provider.GetItem(i));
+  }
+
+  GatherersBatch gatherers;
+  gatherers.Reserve(provider.GatherersCount());
+  for (size_t g = 0; g < provider.GatherersCount(); ++g) {
+    gatherers.Add(provider.GetGatherer(g));
+  }
+
+  return FindGatherEvents(items.View(), gatherers.View());
+}
+
 }  // namespace collision_detector
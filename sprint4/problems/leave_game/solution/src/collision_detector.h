@@ -3,6 +3,7 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <span>
 #include <vector>
 
 namespace collision_detector {
@@ -50,6 +51,81 @@ struct GatheringEvent {
     double time;
 };
 
+// Предметы в виде структуры массивов: координаты и ширины лежат в отдельных
+// непрерывных массивах одинаковой длины
+struct ItemsView {
+    std::span<const double> x;
+    std::span<const double> y;
+    std::span<const double> width;
+};
+
+// Отрезки перемещения собирателей в виде структуры массивов
+struct GatherersView {
+    std::span<const double> start_x;
+    std::span<const double> start_y;
+    std::span<const double> end_x;
+    std::span<const double> end_y;
+    std::span<const double> width;
+};
+
+class ItemsBatch {
+public:
+    void Reserve(size_t count);
+    void Add(const Item& item);
+    void Clear();
+
+    size_t Size() const noexcept {
+        return x_.size();
+    }
+
+    ItemsView View() const noexcept {
+        return {x_, y_, width_};
+    }
+
+private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> width_;
+};
+
+class GatherersBatch {
+public:
+    void Reserve(size_t count);
+    void Add(const Gatherer& gatherer);
+    void Clear();
+
+    size_t Size() const noexcept {
+        return start_x_.size();
+    }
+
+    GatherersView View() const noexcept {
+        return {start_x_, start_y_, end_x_, end_y_, width_};
+    }
+
+private:
+    std::vector<double> start_x_;
+    std::vector<double> start_y_;
+    std::vector<double> end_x_;
+    std::vector<double> end_y_;
+    std::vector<double> width_;
+};
+
+// Реализация проверки столкновений. AVX2 проверяет 4 предмета за инструкцию,
+// SSE2 - 2. Все реализации дают одинаковый результат.
+enum class Kernel { SCALAR, SSE2, AVX2 };
+
+bool IsKernelSupported(Kernel kernel) noexcept;
+// Самая быстрая реализация, поддерживаемая процессором. Выбирается при первом вызове.
+Kernel GetBestKernel() noexcept;
+
+std::vector<GatheringEvent> FindGatherEvents(const ItemsView& items,
+                                             const GatherersView& gatherers);
+// Для тестов и замеров: использует заданную реализацию.
+// Бросает std::invalid_argument, если процессор её не поддерживает.
+std::vector<GatheringEvent> FindGatherEvents(const ItemsView& items,
+                                             const GatherersView& gatherers, Kernel kernel);
+
+// Копирует предметы и собирателей в структуры массивов и ищет события в них
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
 
 }  // namespace collision_detector
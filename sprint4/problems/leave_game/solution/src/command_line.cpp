@@ -5,6 +5,7 @@
 
   po::options_description desc{"All options"s};
   Args args;
+  std::uint64_t random_seed = 0;
 
   // Allowed options:
   // -h [ --help ]                     produce help message
@@ -15,15 +16,44 @@
 
   desc.add_options()("help,h", "produce help message")(
       "tick-period,t", po::value<unsigned int>(&args.tick_period)->value_name("milliseconds"s),
-      "set tick period")("config-file,c", po::value(&args.config_file)->value_name("file"s),
-                         "set config file path")(
+      "set tick period")(
+      "fixed-timestep", po::bool_switch(&args.fixed_timestep),
+      "tick with a fixed time step, catching up after delays")(
+      "max-catch-up-steps", po::value(&args.max_catch_up_steps)->value_name("count"),
+      "max fixed time steps run at once to catch up")(
+      "tick-workers", po::value(&args.tick_workers)->value_name("count"),
+      "threads for tick stages that may run in parallel")(
+      "config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path")(
+      "map-cache", po::value(&args.map_cache_file)->value_name("file"s),
+      "binary cache of the config maps, rebuilt when the config changes")(
       "www-root,w", po::value(&args.www_root)->value_name("dir"s), "set static files root")(
       "randomize-spawn-points", po::bool_switch(&args.randomize_spawn_points),
       "spawn dogs at random positions")("state-file",
                                         po::value(&args.state_file)->value_name("file"),
                                         "application state file for backup")(
       "save-state-period", po::value(&args.save_state_period)->value_name("milliseconds"),
-      "period of make backup");
+      "period of make backup")(
+      "record-file", po::value(&args.record_file)->value_name("file"),
+      "record joins, actions and ticks for game_replay")(
+      "random-seed", po::value(&random_seed)->value_name("number"),
+      "seed for random game events")(
+      "header-timeout", po::value(&args.header_timeout)->value_name("milliseconds"),
+      "max time to read request headers")(
+      "body-timeout", po::value(&args.body_timeout)->value_name("milliseconds"),
+      "max time to read request body")(
+      "idle-timeout", po::value(&args.idle_timeout)->value_name("milliseconds"),
+      "max idle time of keep-alive connection")(
+      "max-pipelined-requests", po::value(&args.max_pipelined_requests)->value_name("count"),
+      "max requests of one connection awaiting response")(
+      "max-connections", po::value(&args.max_connections)->value_name("count"),
+      "max simultaneous connections, 0 - unlimited")(
+      "max-inflight-requests", po::value(&args.max_inflight_requests)->value_name("count"),
+      "max queued or running requests per API endpoint")(
+      "queue-budget", po::value(&args.queue_budget)->value_name("milliseconds"),
+      "max time an API request may wait in queue before 503")(
+      "shards", po::value(&args.shards)->value_name("count"),
+      "serve connections by count pinned threads with own listeners, 0 - shared io_context; "
+      "each shard also owns a part of the game sessions and players");
 
   po::variables_map vm;
   po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -34,6 +64,10 @@
     return std::nullopt;
   }
 
+  if (vm.contains("random-seed"s)) {
+    args.random_seed = random_seed;
+  }
+
   if (vm.contains("config-file") && vm.contains("www-root")) {
     return args;
   } else {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <boost/program_options.hpp>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <optional>
@@ -10,11 +11,37 @@ using namespace std::literals;
 
 struct Args {
   unsigned int tick_period = 0;
+  // Тик с фиксированным шагом и догоном отставания
+  bool fixed_timestep = false;
+  unsigned int max_catch_up_steps = 5;
+  // Потоки для стадий тика, которые могут выполняться параллельно; 0 - все в потоке тика
+  unsigned int tick_workers = 0;
   std::string config_file;
+  // Двоичный кеш карт из config_file; пусто - конфигурация всегда разбирается из JSON
+  std::string map_cache_file;
   std::string www_root;
   bool randomize_spawn_points = false;
   std::string state_file;
   int save_state_period = 0;
+
+  // Запись входов, действий и тиков для game_replay
+  std::string record_file;
+  // Зерно случайных событий игры; при записи без зерна оно выбирается случайно
+  std::optional<std::uint64_t> random_seed;
+
+  // Ограничения HTTP-соединений (миллисекунды и штуки)
+  unsigned int header_timeout = 10000;
+  unsigned int body_timeout = 30000;
+  unsigned int idle_timeout = 60000;
+  unsigned int max_pipelined_requests = 16;
+  unsigned int max_connections = 10000;
+
+  // Контроль перегрузки API
+  unsigned int max_inflight_requests = 256;
+  unsigned int queue_budget = 200;
+
+  // Число шардов, обслуживающих соединения; 0 - все потоки работают с общим io_context
+  unsigned int shards = 0;
 };
 
 [[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]);
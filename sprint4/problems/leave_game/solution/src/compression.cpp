@@ -0,0 +1,207 @@
+#include "compression.h"
+
+#include <zlib.h>
+
+#include <stdexcept>
+
+namespace compression {
+
+namespace {
+
+// Поток deflate с неизменным форматом обёртки; уровень задаётся перед каждым сжатием
+class Deflater {
+ public:
+  explicit Deflater(int window_bits) {
+    if (deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      throw std::runtime_error("Failed to initialize zlib deflate stream");
+    }
+  }
+
+  Deflater(const Deflater&) = delete;
+  Deflater& operator=(const Deflater&) = delete;
+
+  ~Deflater() {
+    deflateEnd(&stream_);
+  }
+
+  std::string Compress(std::string_view data, int level) {
+    // Сброс сохраняет выделенные окно и хеш-таблицы
+    if (deflateReset(&stream_) != Z_OK) {
+      throw std::runtime_error("Failed to reset zlib deflate stream");
+    }
+
+    std::string result(deflateBound(&stream_, data.size()), '\0');
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream_.avail_in = static_cast<uInt>(data.size());
+    stream_.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream_.avail_out = static_cast<uInt>(result.size());
+
+    // Буферы задаются до смены уровня: старые версии zlib при этом сразу пишут заголовок
+    if (level != level_) {
+      if (deflateParams(&stream_, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("Failed to set zlib compression level");
+      }
+      level_ = level;
+    }
+
+    int status = Z_OK;
+    while ((status = deflate(&stream_, Z_FINISH)) == Z_OK) {
+      // deflateBound посчитан до смены уровня и мог оказаться мал
+      const std::size_t written = stream_.total_out;
+      result.resize(result.size() * 2);
+      stream_.next_out = reinterpret_cast<Bytef*>(result.data() + written);
+      stream_.avail_out = static_cast<uInt>(result.size() - written);
+    }
+    if (status != Z_STREAM_END) {
+      throw std::runtime_error("zlib deflate failed");
+    }
+    result.resize(stream_.total_out);
+    return result;
+  }
+
+ private:
+  z_stream stream_{};
+  int level_ = Z_DEFAULT_COMPRESSION;
+};
+
+// Размер окна 2^15; +16 - обёртка gzip вместо zlib
+constexpr int WINDOW_BITS = 15;
+constexpr int GZIP_WINDOW_BITS = WINDOW_BITS + 16;
+
+Deflater& ThreadDeflater(Encoding encoding) {
+  if (encoding == Encoding::GZIP) {
+    thread_local Deflater gzip{GZIP_WINDOW_BITS};
+    return gzip;
+  }
+  thread_local Deflater deflate{WINDOW_BITS};
+  return deflate;
+}
+
+std::string_view Trim(std::string_view text) {
+  constexpr std::string_view SPACES = " \t";
+  const auto begin = text.find_first_not_of(SPACES);
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  return text.substr(begin, text.find_last_not_of(SPACES) - begin + 1);
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    const auto lower = [](char c) {
+      return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    };
+    if (lower(a[i]) != lower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Значение q из параметров кодирования ("q=0.5"); 1, если его нет
+double ParseQuality(std::string_view params) {
+  while (!params.empty()) {
+    const auto end = params.find(';');
+    const std::string_view param = Trim(params.substr(0, end));
+    params = end == std::string_view::npos ? std::string_view{} : params.substr(end + 1);
+
+    if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=') {
+      continue;
+    }
+    // По RFC 9110 qvalue - не больше трёх знаков после точки, хватает простого разбора
+    double quality = 0;
+    double scale = 1;
+    bool fraction = false;
+    for (const char c : param.substr(2)) {
+      if (c == '.') {
+        fraction = true;
+      } else if (c >= '0' && c <= '9') {
+        if (fraction) {
+          scale /= 10;
+          quality += (c - '0') * scale;
+        } else {
+          quality = quality * 10 + (c - '0');
+        }
+      } else {
+        return 0;
+      }
+    }
+    return quality;
+  }
+  return 1;
+}
+
+}  // namespace
+
+Encoding ChooseEncoding(std::string_view accept_encoding) {
+  std::optional<double> gzip;
+  std::optional<double> deflate;
+  std::optional<double> any;
+
+  while (!accept_encoding.empty()) {
+    const auto end = accept_encoding.find(',');
+    const std::string_view item = accept_encoding.substr(0, end);
+    accept_encoding = end == std::string_view::npos ? std::string_view{}
+                                                    : accept_encoding.substr(end + 1);
+
+    const auto params = item.find(';');
+    const std::string_view coding = Trim(item.substr(0, params));
+    const double quality =
+        params == std::string_view::npos ? 1 : ParseQuality(item.substr(params + 1));
+
+    if (EqualsIgnoreCase(coding, "gzip") || EqualsIgnoreCase(coding, "x-gzip")) {
+      gzip = quality;
+    } else if (EqualsIgnoreCase(coding, "deflate")) {
+      deflate = quality;
+    } else if (coding == "*") {
+      any = quality;
+    }
+  }
+
+  // Явно не названные кодирования получают качество "*"
+  const double gzip_quality = gzip.value_or(any.value_or(0));
+  const double deflate_quality = deflate.value_or(any.value_or(0));
+  if (gzip_quality > 0 && gzip_quality >= deflate_quality) {
+    return Encoding::GZIP;
+  }
+  if (deflate_quality > 0) {
+    return Encoding::DEFLATE;
+  }
+  return Encoding::IDENTITY;
+}
+
+std::string_view EncodingName(Encoding encoding) {
+  switch (encoding) {
+    case Encoding::GZIP:
+      return "gzip";
+    case Encoding::DEFLATE:
+      return "deflate";
+    case Encoding::IDENTITY:
+      break;
+  }
+  return "identity";
+}
+
+std::string Compress(std::string_view data, Encoding encoding, int level) {
+  if (encoding == Encoding::IDENTITY) {
+    return std::string(data);
+  }
+  return ThreadDeflater(encoding).Compress(data, level);
+}
+
+const std::string& CachedBody::Get(Encoding encoding) {
+  if (encoding == Encoding::IDENTITY) {
+    return identity_;
+  }
+  auto& compressed = compressed_[encoding == Encoding::GZIP ? 0 : 1];
+  if (!compressed) {
+    compressed = Compress(identity_, encoding, BEST_LEVEL);
+  }
+  return *compressed;
+}
+
+}  // namespace compression
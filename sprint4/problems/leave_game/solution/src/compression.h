@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ * Сжатие тел HTTP-ответов (Content-Encoding: gzip или deflate).
+ *
+ * Контекст zlib дорого создавать: deflateInit2 выделяет около 256 КБ под окно и
+ * хеш-таблицы. Поэтому у каждого потока свой контекст на каждый формат, и между
+ * ответами он только сбрасывается.
+ */
+namespace compression {
+
+enum class Encoding { IDENTITY, GZIP, DEFLATE };
+
+// Тела короче этого порога отправляются как есть: они и так умещаются в один
+// TCP-сегмент, а сжатие стоит времени процессора
+inline constexpr std::size_t MIN_COMPRESSED_SIZE = 1400;
+
+// Уровни zlib: для ответов, которые сжимаются на каждый запрос, важнее скорость,
+// а неизменяемые тела сжимаются один раз, и для них выгоднее степень сжатия
+inline constexpr int FAST_LEVEL = 1;
+inline constexpr int BEST_LEVEL = 9;
+
+// Выбирает кодирование по заголовку Accept-Encoding с учётом q-значений.
+// gzip предпочтительнее deflate; IDENTITY, если клиент не принимает ни того, ни другого.
+Encoding ChooseEncoding(std::string_view accept_encoding);
+
+// Значение для заголовка Content-Encoding
+std::string_view EncodingName(Encoding encoding);
+
+// Сжимает данные контекстом текущего потока. Для IDENTITY возвращает копию.
+std::string Compress(std::string_view data, Encoding encoding, int level = FAST_LEVEL);
+
+// Неизменяемое сериализованное тело и его сжатые варианты. Каждый вариант сжимается
+// при первом запросе и затем переиспользуется. Не потокобезопасен: вызывающий код
+// обращается к телу из одного потока или strand.
+class CachedBody {
+ public:
+  CachedBody() = default;
+  explicit CachedBody(std::string identity) : identity_(std::move(identity)) {
+  }
+
+  const std::string& Identity() const noexcept {
+    return identity_;
+  }
+
+  // Тело в заданном кодировании
+  const std::string& Get(Encoding encoding);
+
+ private:
+  std::string identity_;
+  std::array<std::optional<std::string>, 2> compressed_;
+};
+
+}  // namespace compression
@@ -7,6 +7,8 @@
 #include <mutex>
 #include <condition_variable>
 
+#include "metrics.h"
+
 class ConnectionPool {
   using PoolType = ConnectionPool;
   using ConnectionPtr = std::shared_ptr<pqxx::connection>;
@@ -53,6 +55,7 @@ class ConnectionPool {
   }
 
   ConnectionWrapper GetConnection() {
+    metrics::ScopedTimer wait_timer{metrics::Server().db_pool_wait};
     std::unique_lock lock{mutex_};
     cond_var_.wait(lock, [this] { return !free_indices_.empty(); });
     size_t idx = free_indices_.top();
@@ -51,6 +51,7 @@ void Database::AddRetiredPlayer(const std::string& name, int score, double playT
   txn.exec_params("INSERT INTO retired_players (name, score, play_time) VALUES ($1, $2, $3)", name,
                   score, playTime);
   txn.commit();
+  version_.fetch_add(1, std::memory_order_release);
 }
 
 pqxx::result Database::GetRetiredPlayers(int start, int maxItems) {
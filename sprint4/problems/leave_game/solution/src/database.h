@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <pqxx/pqxx>
 #include <memory>
 #include <string>
@@ -17,8 +19,15 @@ class Database {
   void AddRetiredPlayer(const std::string& name, int score, double playTime);
   pqxx::result GetRetiredPlayers(int start = 0, int maxItems = 100);
 
+  // Растёт после каждой записи в retired_players. Пишет в таблицу только этот процесс,
+  // поэтому по совпадению версий можно понять, что закешированная выборка не устарела.
+  std::uint64_t GetVersion() const noexcept {
+    return version_.load(std::memory_order_acquire);
+  }
+
  private:
   ConnectionPool pool_;
+  std::atomic<std::uint64_t> version_{0};
 };
 
 }  // namespace db
@@ -0,0 +1,93 @@
+#include "sdk.h"
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <thread>
+
+#include "load_generator.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Args {
+  load::Config config;
+  unsigned duration = 30;
+  unsigned tick_period = 0;
+  std::string mode = "open";
+  std::string output;
+};
+
+[[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
+  namespace po = boost::program_options;
+
+  po::options_description desc{"All options"s};
+  Args args;
+  args.config.threads = std::max(1u, std::thread::hardware_concurrency());
+
+  desc.add_options()("help,h", "produce help message")(
+      "host", po::value(&args.config.host)->value_name("host"), "server host")(
+      "port,p", po::value(&args.config.port)->value_name("port"), "server port")(
+      "players,n", po::value(&args.config.players)->value_name("count"),
+      "number of players, each with its own connection")(
+      "map,m", po::value(&args.config.maps)->value_name("id")->composing(),
+      "map to join, may be repeated; all server maps by default")(
+      "mode", po::value(&args.mode)->value_name("open|closed"),
+      "open: requests follow a fixed schedule, latency counts from scheduled time; "
+      "closed: next request waits for the previous response")(
+      "action-rate", po::value(&args.config.action_rate)->value_name("rps"),
+      "player/action requests per second per player")(
+      "state-rate", po::value(&args.config.state_rate)->value_name("rps"),
+      "game/state requests per second per player")(
+      "tick-period,t", po::value(&args.tick_period)->value_name("milliseconds"),
+      "send game/tick with this period, for servers without auto tick")(
+      "duration,d", po::value(&args.duration)->value_name("seconds"), "test duration")(
+      "threads", po::value(&args.config.threads)->value_name("count"), "client threads")(
+      "seed", po::value(&args.config.seed)->value_name("number"), "random seed")(
+      "output,o", po::value(&args.output)->value_name("file"),
+      "write JSON report to file instead of stdout");
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+  po::notify(vm);
+
+  if (vm.contains("help"s)) {
+    std::cout << desc;
+    return std::nullopt;
+  }
+
+  if (args.mode != "open" && args.mode != "closed") {
+    throw std::runtime_error("Unknown mode: " + args.mode);
+  }
+  args.config.open_loop = args.mode == "open";
+  args.config.duration = std::chrono::seconds{args.duration};
+  args.config.tick_period = std::chrono::milliseconds{args.tick_period};
+  return args;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  try {
+    auto args = ParseCommandLine(argc, argv);
+    if (!args) {
+      return EXIT_SUCCESS;
+    }
+
+    load::LoadGenerator generator(std::move(args->config));
+    const auto report = boost::json::serialize(generator.Run());
+
+    if (args->output.empty()) {
+      std::cout << report << std::endl;
+    } else {
+      std::ofstream{args->output} << report << std::endl;
+    }
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,269 @@
+#include "game_recording.h"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <stdexcept>
+
+#include "serialization.h"
+
+namespace recording {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::array<char, 4> MAGIC = {'G', 'R', 'E', 'C'};
+constexpr std::uint8_t FORMAT_VERSION = 2;
+// Записи без частей игры: сервер без шардов до появления частей
+constexpr std::uint8_t SINGLE_PART_VERSION = 1;
+
+enum RecordType : std::uint8_t { JOIN = 1, ACTION = 2, TICK = 3 };
+
+// Строки длиннее не встречаются в командах игры; ограничение защищает от испорченных файлов
+constexpr std::uint64_t MAX_STRING_SIZE = 1 << 30;
+// Частей игры не больше, чем шардов на машине
+constexpr std::uint64_t MAX_PARTITIONS = 1 << 16;
+
+void WriteVarint(std::ostream& out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.put(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.put(static_cast<char>(value));
+}
+
+void WriteString(std::ostream& out, std::string_view value) {
+  WriteVarint(out, value.size());
+  out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+// Направление хранится одним байтом: буква команды или 0 для остановки
+char EncodeDirection(const std::string& direction) {
+  return direction.empty() ? '\0' : direction.front();
+}
+
+// Чтение с учётом конца файла: nullopt, если данные кончились
+std::optional<std::uint8_t> ReadByte(std::istream& in) {
+  const auto value = in.get();
+  if (value == std::char_traits<char>::eof()) {
+    return std::nullopt;
+  }
+  return static_cast<std::uint8_t>(value);
+}
+
+std::optional<std::uint64_t> ReadVarint(std::istream& in) {
+  std::uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    const auto byte = ReadByte(in);
+    if (!byte) {
+      return std::nullopt;
+    }
+    value |= static_cast<std::uint64_t>(*byte & 0x7F) << shift;
+    if ((*byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw std::runtime_error("Corrupted recording: varint is too long");
+}
+
+std::optional<std::string> ReadString(std::istream& in) {
+  const auto size = ReadVarint(in);
+  if (!size) {
+    return std::nullopt;
+  }
+  if (*size > MAX_STRING_SIZE) {
+    throw std::runtime_error("Corrupted recording: string is too long");
+  }
+  std::string value(*size, '\0');
+  if (!in.read(value.data(), static_cast<std::streamsize>(*size))) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+}  // namespace
+
+Recorder::Recorder(const std::filesystem::path& path, std::uint64_t seed,
+                   const std::vector<model::GamePart>& parts)
+    : out_(path, std::ios::binary | std::ios::trunc) {
+  if (!out_) {
+    throw std::runtime_error("Failed to open recording file: "s + path.string());
+  }
+
+  std::vector<model::SerGamePart> ser_parts;
+  for (const auto& part : parts) {
+    ser_parts.push_back(model::SerializeGamePart(part));
+  }
+  std::ostringstream snapshot;
+  model::SaveGameParts(std::move(ser_parts), snapshot);
+
+  out_.write(MAGIC.data(), MAGIC.size());
+  out_.put(static_cast<char>(FORMAT_VERSION));
+  for (unsigned i = 0; i < 8; ++i) {
+    out_.put(static_cast<char>((seed >> (i * 8)) & 0xFF));
+  }
+  WriteVarint(out_, parts.size());
+  WriteString(out_, snapshot.view());
+
+  for (const auto& part : parts) {
+    for (const auto& player : part.players.GetAllPlayers()) {
+      numbers_.emplace(player.GetToken(), next_number_++);
+    }
+  }
+  WriteVarint(out_, next_number_);
+  out_.flush();
+
+  last_record_time_ = Clock::now();
+}
+
+void Recorder::BeginRecord(std::uint8_t type, Clock::time_point time) {
+  // События разных частей приходят с тиком и могут опередить предыдущую запись
+  const auto elapsed = std::max(
+      std::chrono::duration_cast<std::chrono::microseconds>(time - last_record_time_),
+      std::chrono::microseconds{0});
+  last_record_time_ = std::max(time, last_record_time_);
+
+  out_.put(static_cast<char>(type));
+  WriteVarint(out_, static_cast<std::uint64_t>(elapsed.count()));
+}
+
+void Recorder::RecordEvent(const PlayerEvent& event) {
+  if (const auto* join = std::get_if<JoinEvent>(&event.data)) {
+    numbers_.emplace(event.token, next_number_++);
+    BeginRecord(JOIN, event.time);
+    WriteString(out_, join->map_id);
+    WriteString(out_, join->user_name);
+    WriteVarint(out_, join->partition);
+    return;
+  }
+
+  const auto it = numbers_.find(event.token);
+  if (it == numbers_.end()) {
+    // Игрок вошёл в обход записи; его действия повторить не получится
+    return;
+  }
+  BeginRecord(ACTION, event.time);
+  WriteVarint(out_, it->second);
+  out_.put(EncodeDirection(std::get<ActionEvent>(event.data).direction));
+}
+
+void Recorder::RecordTick(std::chrono::milliseconds delta, std::vector<PlayerEvent> events) {
+  // У каждой части события уже идут по времени; порядок между частями на повтор не влияет
+  std::stable_sort(events.begin(), events.end(),
+                   [](const auto& lhs, const auto& rhs) { return lhs.time < rhs.time; });
+  for (const auto& event : events) {
+    RecordEvent(event);
+  }
+
+  BeginRecord(TICK, Clock::now());
+  WriteVarint(out_, static_cast<std::uint64_t>(delta.count()));
+  out_.flush();
+}
+
+Reader::Reader(const std::filesystem::path& path) : in_(path, std::ios::binary) {
+  if (!in_) {
+    throw std::runtime_error("Failed to open recording file: "s + path.string());
+  }
+
+  std::array<char, MAGIC.size()> magic{};
+  const auto version = in_.read(magic.data(), magic.size()) ? ReadByte(in_) : std::nullopt;
+  if (magic != MAGIC || !version) {
+    throw std::runtime_error("Not a game recording: "s + path.string());
+  }
+  if (*version != FORMAT_VERSION && *version != SINGLE_PART_VERSION) {
+    throw std::runtime_error("Unsupported recording version "s + std::to_string(*version));
+  }
+  version_ = *version;
+
+  for (unsigned i = 0; i < 8; ++i) {
+    const auto byte = ReadByte(in_);
+    if (!byte) {
+      throw std::runtime_error("Recording header is truncated");
+    }
+    header_.seed |= static_cast<std::uint64_t>(*byte) << (i * 8);
+  }
+  if (version_ != SINGLE_PART_VERSION) {
+    const auto partitions = ReadVarint(in_);
+    if (!partitions) {
+      throw std::runtime_error("Recording header is truncated");
+    }
+    if (*partitions == 0 || *partitions > MAX_PARTITIONS) {
+      throw std::runtime_error("Corrupted recording: "s + std::to_string(*partitions) +
+                               " game parts");
+    }
+    header_.partitions = static_cast<unsigned>(*partitions);
+  }
+  auto snapshot = ReadString(in_);
+  const auto players = snapshot ? ReadVarint(in_) : std::nullopt;
+  if (!players) {
+    throw std::runtime_error("Recording header is truncated");
+  }
+  header_.snapshot = std::move(*snapshot);
+  header_.snapshot_players = static_cast<std::uint32_t>(*players);
+}
+
+std::optional<Event> Reader::Next() {
+  const auto type = ReadByte(in_);
+  if (!type) {
+    return std::nullopt;
+  }
+
+  // Обрыв внутри записи: всё прочитанное до неё остаётся в силе
+  const auto truncated = [this] {
+    truncated_ = true;
+    return std::nullopt;
+  };
+
+  const auto elapsed = ReadVarint(in_);
+  if (!elapsed) {
+    return truncated();
+  }
+  time_ += std::chrono::microseconds(*elapsed);
+
+  Event event{time_, {}};
+  switch (*type) {
+    case JOIN: {
+      auto map_id = ReadString(in_);
+      auto user_name = map_id ? ReadString(in_) : std::nullopt;
+      std::optional<std::uint64_t> partition = 0;
+      if (user_name && version_ != SINGLE_PART_VERSION) {
+        partition = ReadVarint(in_);
+      }
+      if (!user_name || !partition) {
+        return truncated();
+      }
+      if (*partition >= header_.partitions) {
+        throw std::runtime_error("Corrupted recording: join into game part "s +
+                                 std::to_string(*partition));
+      }
+      event.data = JoinEvent{std::move(*map_id), std::move(*user_name),
+                             static_cast<unsigned>(*partition)};
+      break;
+    }
+    case ACTION: {
+      const auto player = ReadVarint(in_);
+      const auto direction = player ? ReadByte(in_) : std::nullopt;
+      if (!direction) {
+        return truncated();
+      }
+      std::string move = *direction == 0 ? ""s : std::string(1, static_cast<char>(*direction));
+      event.data = ActionEvent{static_cast<std::uint32_t>(*player), std::move(move)};
+      break;
+    }
+    case TICK: {
+      const auto delta = ReadVarint(in_);
+      if (!delta) {
+        return truncated();
+      }
+      event.data = TickEvent{std::chrono::milliseconds(*delta)};
+      break;
+    }
+    default:
+      throw std::runtime_error("Corrupted recording: unknown record type "s +
+                               std::to_string(*type));
+  }
+  return event;
+}
+
+}  // namespace recording
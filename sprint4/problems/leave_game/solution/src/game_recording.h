@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "model.h"
+
+/*
+ * Запись входа игроков, их действий и тиков игры для повторного прогона.
+ *
+ * Формат файла (целые без знака - varint, строки - длина varint и байты):
+ *   "GREC", версия (1 байт), зерно (8 байт, little-endian), число частей игры (с версии 2),
+ *   снимок SaveGame на момент начала записи (строка), число игроков в снимке;
+ *   далее записи: тип (1 байт), время от предыдущей записи в микросекундах, данные.
+ *   Вход с версии 2 хранит и часть игры, в которую попал игрок.
+ *
+ * Игроки обозначаются порядковыми номерами: сначала игроки снимка по частям игры,
+ * в каждой в порядке Players::GetAllPlayers, затем вошедшие во время записи в порядке входа.
+ * Часть i повторяется с зерном model::PartitionSeed(зерно, i).
+ */
+namespace recording {
+
+using Clock = std::chrono::steady_clock;
+
+struct JoinEvent {
+  std::string map_id;
+  std::string user_name;
+  unsigned partition = 0;
+};
+
+struct ActionEvent {
+  std::uint32_t player = 0;
+  // "L", "R", "U", "D" или "" для остановки
+  std::string direction;
+};
+
+struct TickEvent {
+  std::chrono::milliseconds delta{0};
+};
+
+struct Event {
+  // Время от начала записи
+  std::chrono::microseconds time{0};
+  std::variant<JoinEvent, ActionEvent, TickEvent> data;
+};
+
+struct Header {
+  std::uint64_t seed = 0;
+  unsigned partitions = 1;
+  std::string snapshot;
+  std::uint32_t snapshot_players = 0;
+};
+
+// Вход или действие игрока, ещё не записанные в файл. Части игры копят их до тика:
+// в режиме шардов части работают в разных потоках, а файл пишет только поток тиков.
+struct PlayerEvent {
+  Clock::time_point time;
+  model::Token token;
+  // Номер игрока в ActionEvent проставляет Recorder
+  std::variant<JoinEvent, ActionEvent> data;
+};
+
+// Пишет события в файл. Вызывается из потока тиков игры.
+class Recorder {
+ public:
+  // Сохраняет в заголовок зерно и текущее состояние частей игры
+  Recorder(const std::filesystem::path& path, std::uint64_t seed,
+           const std::vector<model::GamePart>& parts);
+
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+
+  // Записывает события, накопленные частями игры до тика, в порядке времени, затем тик.
+  // Тик сбрасывает буфер файла, чтобы после аварии сохранилось всё до последнего тика.
+  void RecordTick(std::chrono::milliseconds delta, std::vector<PlayerEvent> events);
+
+ private:
+  void BeginRecord(std::uint8_t type, Clock::time_point time);
+  void RecordEvent(const PlayerEvent& event);
+
+  std::ofstream out_;
+  Clock::time_point last_record_time_;
+  // Номера игроков по токену. Номера ушедших игроков не освобождаются.
+  std::unordered_map<model::Token, std::uint32_t, util::TaggedHasher<model::Token>> numbers_;
+  std::uint32_t next_number_ = 0;
+};
+
+// Читает файл записи. Обрыв в середине последней записи считается концом файла.
+class Reader {
+ public:
+  explicit Reader(const std::filesystem::path& path);
+
+  const Header& GetHeader() const noexcept {
+    return header_;
+  }
+
+  // Следующее событие или nullopt в конце записи
+  std::optional<Event> Next();
+
+  // Запись оборвалась посреди события, например при аварийной остановке сервера
+  bool IsTruncated() const noexcept {
+    return truncated_;
+  }
+
+ private:
+  std::ifstream in_;
+  std::uint8_t version_ = 0;
+  Header header_;
+  std::chrono::microseconds time_{0};
+  bool truncated_ = false;
+};
+
+}  // namespace recording
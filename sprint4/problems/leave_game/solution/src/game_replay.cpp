@@ -0,0 +1,294 @@
+#include <boost/json.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <sstream>
+#include <vector>
+
+#include "game_recording.h"
+#include "json_loader.h"
+#include "serialization.h"
+
+using namespace std::literals;
+
+namespace {
+
+namespace json = boost::json;
+
+struct Args {
+  std::string config_file;
+  std::string recording;
+  std::string timings;
+  std::string output;
+  unsigned slowest = 10;
+};
+
+[[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
+  namespace po = boost::program_options;
+
+  po::options_description desc{"All options"s};
+  Args args;
+
+  desc.add_options()("help,h", "produce help message")(
+      "config-file,c", po::value(&args.config_file)->value_name("file")->required(),
+      "game config the recording was made with")(
+      "recording,r", po::value(&args.recording)->value_name("file")->required(),
+      "file written by game_server --record-file")(
+      "timings", po::value(&args.timings)->value_name("file"),
+      "write CSV with the duration of every tick")(
+      "slowest", po::value(&args.slowest)->value_name("count"),
+      "number of slowest ticks listed in the report")(
+      "output,o", po::value(&args.output)->value_name("file"),
+      "write JSON report to file instead of stdout");
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+
+  if (vm.contains("help"s)) {
+    std::cout << desc;
+    return std::nullopt;
+  }
+  po::notify(vm);
+  return args;
+}
+
+struct TickTiming {
+  std::uint64_t index = 0;
+  std::chrono::microseconds recorded_at{0};
+  std::chrono::milliseconds delta{0};
+  std::chrono::nanoseconds duration{0};
+};
+
+// Отпечаток состояния частей игры: два повтора одной записи должны дать одно и то же значение
+std::uint64_t StateDigest(const std::vector<const model::Game*>& games) {
+  std::uint64_t hash = 14695981039346656037ull;  // FNV-1a
+  const auto mix = [&hash](const auto& value) {
+    unsigned char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    for (const unsigned char byte : bytes) {
+      hash = (hash ^ byte) * 1099511628211ull;
+    }
+  };
+
+  for (const auto& session :
+       games | std::views::transform(&model::Game::GetGameSessions) | std::views::join) {
+    for (const auto& dog : session->GetDogs()) {
+      mix(dog.GetId());
+      mix(dog.GetPosition().x);
+      mix(dog.GetPosition().y);
+      mix(dog.GetScore());
+      mix(dog.GetBag().GetSize());
+    }
+    for (const auto& loot : session->GetLoots()) {
+      mix(loot.type);
+      mix(loot.position.x);
+      mix(loot.position.y);
+    }
+  }
+  return hash;
+}
+
+/*
+ * Повторяет запись в модели игры без HTTP-сервера: входы, действия и тики
+ * выполняются так же, как их выполняет Application, но подряд, без ожидания.
+ * Части игры повторяются в одном потоке: каждая зависит только от своих событий.
+ */
+class Replay {
+ public:
+  explicit Replay(const Args& args) : reader_{args.recording} {
+    const auto& header = reader_.GetHeader();
+    // Игра загружается так же, как на сервере, вместе с настройками генератора трофеев
+    const model::Game game = json_loader::LoadGamePackage(args.config_file).game;
+    for (unsigned i = 0; i < header.partitions; ++i) {
+      auto& part = *parts_.emplace_back(std::make_unique<Part>(game));
+      part.game.SetRandomSeed(model::PartitionSeed(header.seed, i));
+      part.players.SetTimeWaitDog(game.GetSettings().dog_retirement_time);
+    }
+
+    if (!header.snapshot.empty()) {
+      std::istringstream snapshot{header.snapshot};
+      model::LoadGameParts(GetGameParts(), snapshot);
+    }
+    for (const auto& part : parts_) {
+      for (const auto& player : part->players.GetAllPlayers()) {
+        tokens_.push_back({part.get(), player.GetToken()});
+      }
+    }
+    if (tokens_.size() != header.snapshot_players) {
+      throw std::runtime_error("Snapshot players do not match the recording header");
+    }
+  }
+
+  void Run() {
+    while (auto event = reader_.Next()) {
+      ++events_;
+      std::visit([this, &event](const auto& data) { Apply(data, event->time); }, event->data);
+    }
+  }
+
+  json::object Report(unsigned slowest_count) const {
+    std::vector<std::int64_t> durations;
+    durations.reserve(ticks_.size());
+    std::chrono::nanoseconds total{0};
+    for (const auto& tick : ticks_) {
+      durations.push_back(tick.duration.count());
+      total += tick.duration;
+    }
+    std::sort(durations.begin(), durations.end());
+    const auto quantile = [&durations](double q) -> std::int64_t {
+      if (durations.empty()) {
+        return 0;
+      }
+      const auto index = static_cast<size_t>(q * static_cast<double>(durations.size() - 1));
+      return durations[index];
+    };
+
+    std::vector<TickTiming> slowest = ticks_;
+    const size_t count = std::min<size_t>(slowest_count, slowest.size());
+    std::partial_sort(slowest.begin(), slowest.begin() + count, slowest.end(),
+                      [](const auto& lhs, const auto& rhs) { return lhs.duration > rhs.duration; });
+    json::array slowest_json;
+    for (size_t i = 0; i < count; ++i) {
+      slowest_json.push_back(json::object{{"tick", slowest[i].index},
+                                          {"recorded_at_us", slowest[i].recorded_at.count()},
+                                          {"delta_ms", slowest[i].delta.count()},
+                                          {"duration_ns", slowest[i].duration.count()}});
+    }
+
+    std::vector<const model::Game*> games;
+    for (const auto& part : parts_) {
+      games.push_back(&part->game);
+    }
+    std::ostringstream digest;
+    digest << std::hex << StateDigest(games);
+
+    return {{"events", events_},
+            {"joins", joins_},
+            {"actions", actions_},
+            {"ticks", ticks_.size()},
+            {"truncated", reader_.IsTruncated()},
+            {"seed", reader_.GetHeader().seed},
+            {"partitions", reader_.GetHeader().partitions},
+            {"tick_ns",
+             json::object{{"total", total.count()},
+                          {"p50", quantile(0.5)},
+                          {"p90", quantile(0.9)},
+                          {"p99", quantile(0.99)},
+                          {"max", durations.empty() ? 0 : durations.back()}}},
+            {"slowest_ticks", std::move(slowest_json)},
+            {"state_digest", digest.str()}};
+  }
+
+  void WriteTimings(std::ostream& out) const {
+    out << "tick,recorded_at_us,delta_ms,duration_ns\n";
+    for (const auto& tick : ticks_) {
+      out << tick.index << ',' << tick.recorded_at.count() << ',' << tick.delta.count() << ','
+          << tick.duration.count() << '\n';
+    }
+  }
+
+ private:
+  struct Part {
+    explicit Part(const model::Game& config) : game{config} {
+    }
+
+    model::Game game;
+    model::Players players;
+  };
+
+  // Токен игрока и часть игры, в которой он живёт
+  struct PlayerRef {
+    Part* part;
+    model::Token token;
+  };
+
+  std::vector<model::GamePart> GetGameParts() {
+    std::vector<model::GamePart> parts;
+    for (const auto& part : parts_) {
+      parts.push_back({part->game, part->players});
+    }
+    return parts;
+  }
+
+  void Apply(const recording::JoinEvent& join, std::chrono::microseconds) {
+    ++joins_;
+    Part& part = *parts_.at(join.partition);
+    const model::Player* player =
+        model::JoinGame(part.game, part.players, model::Map::Id{join.map_id}, join.user_name);
+    if (!player) {
+      throw std::runtime_error("Map " + join.map_id + " from the recording is not in the config");
+    }
+    tokens_.push_back({&part, player->GetToken()});
+  }
+
+  void Apply(const recording::ActionEvent& action, std::chrono::microseconds) {
+    ++actions_;
+    // Игрок мог уйти на покой; сервер в этом случае ответил бы ошибкой авторизации
+    if (action.player >= tokens_.size()) {
+      throw std::runtime_error("Action of unknown player " + std::to_string(action.player));
+    }
+    auto& [part, token] = tokens_[action.player];
+    if (model::Player* player = part->players.GetPlayerByToken(token)) {
+      part->players.ApplyAction(*player, action.direction);
+    }
+  }
+
+  void Apply(const recording::TickEvent& tick, std::chrono::microseconds time) {
+    const double delta = static_cast<double>(tick.delta.count()) / 1000.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& part : parts_) {
+      part->game.Tick(delta);
+      part->players.OnTick(delta);
+    }
+    const auto duration = std::chrono::steady_clock::now() - start;
+    ticks_.push_back({ticks_.size(), time, tick.delta,
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(duration)});
+  }
+
+  recording::Reader reader_;
+  std::vector<std::unique_ptr<Part>> parts_;
+  // Игроки по их номерам в записи
+  std::vector<PlayerRef> tokens_;
+  std::vector<TickTiming> ticks_;
+  std::uint64_t events_ = 0;
+  std::uint64_t joins_ = 0;
+  std::uint64_t actions_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  try {
+    auto args = ParseCommandLine(argc, argv);
+    if (!args) {
+      return EXIT_SUCCESS;
+    }
+
+    Replay replay{*args};
+    replay.Run();
+
+    if (!args->timings.empty()) {
+      std::ofstream timings{args->timings};
+      replay.WriteTimings(timings);
+    }
+
+    const auto report = json::serialize(replay.Report(args->slowest));
+    if (args->output.empty()) {
+      std::cout << report << std::endl;
+    } else {
+      std::ofstream{args->output} << report << std::endl;
+    }
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
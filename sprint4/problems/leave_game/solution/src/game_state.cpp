@@ -0,0 +1,168 @@
+#include "game_state.h"
+
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <string>
+#include <string_view>
+
+namespace game_state {
+
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+// Собаки и трофеи, попадающие в ответ: найденные сеткой в области интереса или все
+template <typename DogFn, typename LootFn>
+void ForEachObject(const model::GameSession& session,
+                   const std::optional<util::InterestArea>& area, DogFn&& add_dog,
+                   LootFn&& add_loot) {
+  if (area) {
+    session.ForEachDogIn(*area, add_dog);
+    session.ForEachLootIn(*area, add_loot);
+  } else {
+    for (const auto& dog : session.GetDogs()) {
+      add_dog(dog);
+    }
+    const auto& loots = session.GetLoots();
+    for (size_t i = 0; i < loots.size(); ++i) {
+      add_loot(loots.KeyAt(i), loots[i]);
+    }
+  }
+}
+
+// Длины частей JSON без создания значений. Ключи и строки ответа состоят из цифр
+// и латинских букв, поэтому не экранируются.
+class JsonSize {
+ public:
+  template <typename Int>
+  static std::size_t Integer(Int value) {
+    std::array<char, 24> buffer;
+    return std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr -
+           buffer.data();
+  }
+
+  // Ключ объекта с кавычками и двоеточием
+  template <typename Int>
+  static std::size_t IntegerKey(Int value) {
+    return Integer(value) + R"("":)"sv.size();
+  }
+
+  // Формат чисел с плавающей точкой задаёт Boost.JSON, поэтому длину считает его сериализатор,
+  // записывая число в буфер на стеке
+  std::size_t Double(double value) {
+    const json::value number = value;
+    serializer_.reset(&number);
+    std::array<char, 32> buffer;
+    std::size_t size = 0;
+    while (!serializer_.done()) {
+      size += serializer_.read(buffer.data(), buffer.size()).size();
+    }
+    return size;
+  }
+
+ private:
+  json::serializer serializer_;
+};
+
+// Длина SerializeDog(dog)
+std::size_t SerializedDogSize(const model::Dog& dog, JsonSize& json_size) {
+  const auto& state = dog.GetState();
+  // Направление записывается одной буквой
+  std::size_t size = R"({"pos":[,],"speed":[,],"dir":"U","bag":[],"score":})"sv.size();
+  size += json_size.Double(state.position.x) + json_size.Double(state.position.y);
+  size += json_size.Double(state.speed.x) + json_size.Double(state.speed.y);
+
+  const auto& bag_items = dog.GetBag().GetItems();
+  for (size_t i = 0; i < bag_items.size(); ++i) {
+    size += (i > 0 ? 1 : 0) + R"({"id":,"type":})"sv.size();
+    size += JsonSize::Integer(static_cast<int>(i)) +
+            JsonSize::Integer(static_cast<int>(bag_items[i]));
+  }
+  return size + JsonSize::Integer(dog.GetScore());
+}
+
+}  // namespace
+
+json::object SerializeDog(const model::Dog& dog) {
+  const auto& state = dog.GetState();
+
+  std::string direction;
+  switch (state.direction) {
+    case MoveInfo::Direction::NORTH:
+      direction = "U";
+      break;
+    case MoveInfo::Direction::SOUTH:
+      direction = "D";
+      break;
+    case MoveInfo::Direction::WEST:
+      direction = "L";
+      break;
+    case MoveInfo::Direction::EAST:
+      direction = "R";
+      break;
+    default:
+      assert(false && "Unexpected direction in MoveInfo::Direction");
+  }
+
+  json::array bag_json;
+  const auto& bag_items = dog.GetBag().GetItems();
+  for (size_t i = 0; i < bag_items.size(); ++i) {
+    bag_json.push_back(
+        json::object{{"id", static_cast<int>(i)}, {"type", static_cast<int>(bag_items[i])}});
+  }
+
+  return {
+      {"pos", json::array{state.position.x, state.position.y}},
+      {"speed", json::array{state.speed.x, state.speed.y}},
+      {"dir", direction},
+      {"bag", bag_json},
+      {"score", dog.GetScore()}  // Добавляем счет игрока
+  };
+}
+
+json::object SerializeSession(const model::GameSession& session,
+                              const std::optional<util::InterestArea>& area) {
+  json::object players_json;
+  json::object lost_objects_json;
+
+  const auto add_dog = [&players_json](const model::Dog& dog) {
+    players_json[std::to_string(dog.GetId())] = SerializeDog(dog);
+  };
+  // Идентификатор трофея сохраняется между тиками
+  const auto add_loot = [&lost_objects_json](model::GameSession::LootId loot_id,
+                                             const model::GameSession::Loot& loot) {
+    lost_objects_json[std::to_string(loot_id.Pack())] = {
+        {"type", loot.type}, {"pos", json::array{loot.position.x, loot.position.y}}};
+  };
+
+  ForEachObject(session, area, add_dog, add_loot);
+
+  return {{"players", std::move(players_json)}, {"lostObjects", std::move(lost_objects_json)}};
+}
+
+std::size_t SerializedSessionSize(const model::GameSession& session,
+                                  const std::optional<util::InterestArea>& area) {
+  JsonSize json_size;
+  std::size_t size = R"({"players":{},"lostObjects":{}})"sv.size();
+  // Запятые ставятся между элементами объекта
+  std::size_t dogs = 0;
+  std::size_t loots = 0;
+
+  const auto add_dog = [&](const model::Dog& dog) {
+    size += (dogs++ > 0 ? 1 : 0) + JsonSize::IntegerKey(dog.GetId());
+    size += SerializedDogSize(dog, json_size);
+  };
+  const auto add_loot = [&](model::GameSession::LootId loot_id,
+                            const model::GameSession::Loot& loot) {
+    size += (loots++ > 0 ? 1 : 0) + JsonSize::IntegerKey(loot_id.Pack());
+    size += R"({"type":,"pos":[,]})"sv.size() + JsonSize::Integer(loot.type);
+    size += json_size.Double(loot.position.x) + json_size.Double(loot.position.y);
+  };
+  ForEachObject(session, area, add_dog, add_loot);
+
+  return size;
+}
+
+}  // namespace game_state
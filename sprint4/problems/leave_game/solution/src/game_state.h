@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+#include <boost/json.hpp>
+
+#include "model.h"
+#include "spatial_grid.h"
+
+namespace game_state {
+
+// Состояние собаки для ответа /api/v1/game/state
+boost::json::object SerializeDog(const model::Dog& dog);
+
+// Собаки и трофеи сессии: {"players": ..., "lostObjects": ...}.
+// Если задана область интереса, в ответ попадает только найденное в ней сеткой сессии.
+boost::json::object SerializeSession(const model::GameSession& session,
+                                     const std::optional<util::InterestArea>& area);
+
+// Длина SerializeSession(session, area) в JSON для ответа на HEAD. Объекты ответа
+// не создаются: длина считается при обходе сессии.
+std::size_t SerializedSessionSize(const model::GameSession& session,
+                                  const std::optional<util::InterestArea>& area);
+
+}  // namespace game_state
@@ -4,11 +4,19 @@
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace http_server {
 
@@ -17,9 +25,87 @@ using tcp = net::ip::tcp;
 namespace beast = boost::beast;
 namespace http = beast::http;
 namespace sys = boost::system;
+using namespace std::literals;
 
 void ReportError(beast::error_code ec, std::string_view what);
 
+// Ограничения, которые сервер накладывает на каждое соединение
+struct ServerSettings {
+    // Время на чтение заголовков запроса после прихода первого байта
+    std::chrono::milliseconds header_read_timeout = 10s;
+    // Время на чтение тела запроса
+    std::chrono::milliseconds body_read_timeout = 30s;
+    // Сколько keep-alive соединение может простаивать между запросами
+    std::chrono::milliseconds keep_alive_timeout = 60s;
+    // Время на отправку одного ответа; сроки чтения на запись не влияют
+    std::chrono::milliseconds write_timeout = 30s;
+    // Максимальное число запросов одного соединения, ожидающих ответа
+    std::size_t max_pipelined_requests = 16;
+    // Максимальное число одновременно открытых соединений (0 - без ограничений)
+    std::size_t max_connections = 10000;
+    // SO_REUSEPORT: несколько Listener слушают один порт, ядро распределяет между ними соединения
+    bool reuse_port = false;
+};
+
+// Счётчик открытых соединений, общий для Listener и всех его сессий
+class ConnectionCounter : public std::enable_shared_from_this<ConnectionCounter> {
+public:
+    // RAII-билет: пока он жив, соединение учитывается в счётчике
+    class Ticket {
+    public:
+        Ticket() = default;
+        explicit Ticket(std::shared_ptr<ConnectionCounter> counter) noexcept
+            : counter_(std::move(counter)) {}
+
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+
+        Ticket(Ticket&& other) noexcept = default;
+        Ticket& operator=(Ticket&& other) noexcept {
+            if (this != &other) {
+                Release();
+                counter_ = std::move(other.counter_);
+            }
+            return *this;
+        }
+
+        ~Ticket() {
+            Release();
+        }
+
+    private:
+        void Release() noexcept {
+            if (counter_) {
+                counter_->active_.fetch_sub(1, std::memory_order_relaxed);
+                counter_.reset();
+            }
+        }
+
+        std::shared_ptr<ConnectionCounter> counter_;
+    };
+
+    explicit ConnectionCounter(std::size_t limit) : limit_(limit) {}
+
+    // Возвращает билет или std::nullopt, если лимит соединений исчерпан
+    std::optional<Ticket> TryAcquire() noexcept {
+        std::size_t current = active_.load(std::memory_order_relaxed);
+        do {
+            if (limit_ != 0 && current >= limit_) {
+                return std::nullopt;
+            }
+        } while (!active_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+        return Ticket{shared_from_this()};
+    }
+
+    std::size_t GetActive() const noexcept {
+        return active_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::size_t> active_{0};
+    std::size_t limit_;
+};
+
 class SessionBase {
 public:
     SessionBase(const SessionBase&) = delete;
@@ -28,36 +114,123 @@ public:
 
     void Run() {
         net::dispatch(strand_, [self = GetSharedThis()] {
-            self->Read();
+            self->WaitForRequest();
         });
     }
 
 protected:
     using HttpRequest = http::request<http::string_body>;
-
-    SessionBase(tcp::socket&& socket, net::strand<net::io_context::executor_type> strand)
-        : stream_(std::move(socket)), strand_(std::move(strand)) {}
-
+    using RequestSeq = std::uint64_t;
+
+    SessionBase(tcp::socket&& socket, net::strand<net::io_context::executor_type> strand,
+                ServerSettings settings, ConnectionCounter::Ticket&& ticket)
+        : stream_(std::move(socket))
+        , strand_(std::move(strand))
+        , read_timer_(strand_)
+        , settings_(settings)
+        , ticket_(std::move(ticket)) {}
+
+    // Ставит ответ на запрос с номером seq в очередь отправки.
+    // Ответы отправляются строго в порядке поступления запросов,
+    // даже если обработчики завершились в другом порядке.
     template <typename Body, typename Fields>
-    void Write(http::response<Body, Fields>&& response) {
+    void Write(RequestSeq seq, http::response<Body, Fields>&& response) {
         auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
-        auto self = GetSharedThis();
-        http::async_write(
-            stream_, *safe_response,
-            net::bind_executor(strand_,
-                [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                    self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                }));
+        net::dispatch(strand_, [self = GetSharedThis(), seq, safe_response] {
+            // Отложенная запись хранится внутри сессии, поэтому захватывает её
+            // по обычному указателю, чтобы не образовать цикл владения
+            self->OnResponseReady(seq, [session = self.get(), safe_response] {
+                // Таймер потока служит только записи, у чтения свой таймер
+                session->stream_.expires_after(session->settings_.write_timeout);
+                http::async_write(
+                    session->stream_, *safe_response,
+                    net::bind_executor(session->strand_,
+                        [self = session->GetSharedThis(), safe_response](
+                            beast::error_code ec, std::size_t bytes_written) {
+                            self->OnWrite(safe_response->need_eof(), ec, bytes_written);
+                        }));
+            });
+        });
     }
 
 private:
+    using PendingWrite = std::function<void()>;
+
+    // Размер порции, читаемой в ожидании следующего запроса keep-alive соединения
+    static constexpr std::size_t IDLE_READ_CHUNK = 4096;
+
     beast::tcp_stream stream_;
     net::strand<net::io_context::executor_type> strand_;
+    // Срок текущего чтения. Истёкший срок закрывает только приём, чтобы уже принятые
+    // запросы получили ответы.
+    net::steady_timer read_timer_;
+    ServerSettings settings_;
+    ConnectionCounter::Ticket ticket_;
     beast::flat_buffer buffer_;
-    HttpRequest request_;
+    std::optional<http::request_parser<http::string_body>> parser_;
+
+    // Ответы на запросы, принятые, но ещё не отправленные. Элемент с индексом i
+    // соответствует запросу с номером first_pending_seq_ + i; пустая функция
+    // означает, что обработчик ещё не вернул ответ.
+    std::deque<PendingWrite> pending_;
+    RequestSeq first_pending_seq_ = 0;
+    bool writing_ = false;
+    bool reading_ = false;
+    // Чтение прервано по истечении срока
+    bool read_timed_out_ = false;
+    // Клиент не хочет держать соединение, новые запросы не читаем
+    bool stop_reading_ = false;
+    // Запись в сокет завершилась ошибкой, ответы больше не отправляем
+    bool broken_ = false;
+
+    bool CanReadMore() const {
+        return !reading_ && !stop_reading_ && pending_.size() < settings_.max_pipelined_requests;
+    }
+
+    // Ожидание первого байта следующего запроса ограничено keep-alive таймаутом.
+    // Если в буфере уже лежат данные конвейерного запроса, сразу читаем заголовки.
+    void WaitForRequest() {
+        if (!CanReadMore()) {
+            return;
+        }
+        reading_ = true;
+        if (buffer_.size() > 0) {
+            return ReadHeader();
+        }
+
+        StartReadTimer(settings_.keep_alive_timeout);
+        stream_.async_read_some(
+            buffer_.prepare(IDLE_READ_CHUNK),
+            net::bind_executor(strand_,
+                [self = GetSharedThis()](beast::error_code ec, std::size_t bytes_read) {
+                    self->OnIdleRead(ec, bytes_read);
+                }));
+    }
+
+    void OnIdleRead(beast::error_code ec, std::size_t bytes_read) {
+        if (ec) return OnReadError(ec);
+        buffer_.commit(bytes_read);
+        ReadHeader();
+    }
+
+    void ReadHeader() {
+        parser_.emplace();
+        StartReadTimer(settings_.header_read_timeout);
+        http::async_read_header(stream_, buffer_, *parser_,
+            net::bind_executor(strand_,
+                [self = GetSharedThis()](beast::error_code ec, std::size_t bytes_read) {
+                    self->OnReadHeader(ec, bytes_read);
+                }));
+    }
+
+    void OnReadHeader(beast::error_code ec, std::size_t) {
+        if (ec) return OnReadError(ec);
+        if (parser_->is_done()) {
+            return OnRead({}, 0);
+        }
 
-    void Read() {
-        http::async_read(stream_, buffer_, request_,
+        StartReadTimer(settings_.body_read_timeout);
+        http::async_read(stream_, buffer_, *parser_,
             net::bind_executor(strand_,
                 [self = GetSharedThis()](beast::error_code ec, std::size_t bytes_read) {
                     self->OnRead(ec, bytes_read);
@@ -65,9 +238,79 @@ private:
     }
 
     void OnRead(beast::error_code ec, std::size_t) {
-        if (ec == http::error::end_of_stream) return Close();
-        if (ec) return ReportError(ec, "read");
-        HandleRequest(std::move(request_));
+        if (ec) return OnReadError(ec);
+        reading_ = false;
+        StopReadTimer();
+
+        HttpRequest request = parser_->release();
+        parser_.reset();
+        stop_reading_ = !request.keep_alive();
+
+        const RequestSeq seq = first_pending_seq_ + pending_.size();
+        pending_.emplace_back();
+        HandleRequest(std::move(request), seq);
+
+        // Пока обрабатывается этот запрос, читаем следующий (HTTP/1.1 pipelining)
+        WaitForRequest();
+    }
+
+    // Таймер потока на время чтения отключается: он ограничивает только запись
+    void StartReadTimer(std::chrono::milliseconds timeout) {
+        stream_.expires_never();
+        read_timer_.expires_after(timeout);
+        read_timer_.async_wait(
+            net::bind_executor(strand_, [self = GetSharedThis()](beast::error_code ec) {
+                self->OnReadTimer(ec);
+            }));
+    }
+
+    void StopReadTimer() {
+        read_timer_.expires_at(net::steady_timer::time_point::max());
+    }
+
+    void OnReadTimer(beast::error_code ec) {
+        // Таймер мог сработать, когда чтение уже завершилось или получило новый срок
+        if (ec == net::error::operation_aborted ||
+            read_timer_.expiry() > net::steady_timer::clock_type::now()) {
+            return;
+        }
+        // Закрытие приёма завершает ожидающее чтение, не мешая отправке ответов
+        read_timed_out_ = true;
+        beast::error_code ignored;
+        stream_.socket().shutdown(tcp::socket::shutdown_receive, ignored);
+    }
+
+    void OnReadError(beast::error_code ec) {
+        reading_ = false;
+        stop_reading_ = true;
+        StopReadTimer();
+        // Клиент закрыл соединение или молчал дольше допустимого - это не ошибка
+        if (!std::exchange(read_timed_out_, false) && ec != http::error::end_of_stream &&
+            ec != net::error::eof) {
+            ReportError(ec, "read");
+        }
+        // Новых запросов не будет. Принятые запросы получат ответы,
+        // после последнего из них OnWrite закроет соединение.
+        if (pending_.empty()) {
+            Close();
+        }
+    }
+
+    void OnResponseReady(RequestSeq seq, PendingWrite&& write) {
+        if (broken_) {
+            return;
+        }
+        pending_[seq - first_pending_seq_] = std::move(write);
+        WriteNext();
+    }
+
+    void WriteNext() {
+        if (writing_ || pending_.empty() || !pending_.front()) {
+            return;
+        }
+        writing_ = true;
+        auto write = std::move(pending_.front());
+        write();
     }
 
     void Close() {
@@ -76,12 +319,31 @@ private:
     }
 
     void OnWrite(bool close, beast::error_code ec, std::size_t) {
-        if (ec) return ReportError(ec, "write");
-        if (close) return Close();
-        Read();
+        writing_ = false;
+        stream_.expires_never();
+        pending_.pop_front();
+        ++first_pending_seq_;
+
+        if (ec) {
+            broken_ = true;
+            stop_reading_ = true;
+            pending_.clear();
+            return ReportError(ec, "write");
+        }
+        if (close) {
+            stop_reading_ = true;
+            return Close();
+        }
+        if (pending_.empty() && stop_reading_ && !reading_) {
+            return Close();
+        }
+
+        WriteNext();
+        // Очередь могла освободиться - возобновляем чтение
+        WaitForRequest();
     }
 
-    virtual void HandleRequest(HttpRequest&& request) = 0;
+    virtual void HandleRequest(HttpRequest&& request, RequestSeq seq) = 0;
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
 };
 
@@ -92,8 +354,10 @@ template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
 public:
     template <typename Handler>
-    Session(tcp::socket&& socket, net::strand<net::io_context::executor_type> strand, Handler&& request_handler)
-        : SessionBase(std::move(socket), std::move(strand))
+    Session(tcp::socket&& socket, net::strand<net::io_context::executor_type> strand,
+            ServerSettings settings, ConnectionCounter::Ticket&& ticket,
+            Handler&& request_handler)
+        : SessionBase(std::move(socket), std::move(strand), settings, std::move(ticket))
         , request_handler_(std::forward<Handler>(request_handler)) {}
 
 private:
@@ -103,9 +367,9 @@ private:
         return this->shared_from_this();
     }
 
-    void HandleRequest(HttpRequest&& request) override {
-        request_handler_(std::move(request), [self = this->shared_from_this()](auto&& response) {
-            self->Write(std::move(response));
+    void HandleRequest(HttpRequest&& request, RequestSeq seq) override {
+        request_handler_(std::move(request), [self = this->shared_from_this(), seq](auto&& response) {
+            self->Write(seq, std::move(response));
         });
     }
 };
@@ -115,16 +379,28 @@ private:
 template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
 public:
+    using Strand = net::strand<net::io_context::executor_type>;
+
+    // Если strand не задан, каждое соединение получает собственный strand в ioc
     template <typename Handler>
-    Listener(net::io_context& ioc, const tcp::endpoint& endpoint,
-             net::strand<net::io_context::executor_type> strand, Handler&& request_handler)
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, std::optional<Strand> strand,
+             const ServerSettings& settings, std::shared_ptr<ConnectionCounter> connections,
+             Handler&& request_handler)
         : ioc_(ioc)
         , acceptor_(net::make_strand(ioc))
-        , strand_(strand)
+        , strand_(std::move(strand))
+        , settings_(settings)
+        , connections_(std::move(connections))
         , request_handler_(std::forward<Handler>(request_handler)) {
 
         acceptor_.open(endpoint.protocol());
         acceptor_.set_option(net::socket_base::reuse_address(true));
+#ifdef SO_REUSEPORT
+        if (settings_.reuse_port) {
+            using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+            acceptor_.set_option(ReusePort(true));
+        }
+#endif
         acceptor_.bind(endpoint);
         acceptor_.listen(net::socket_base::max_listen_connections);
     }
@@ -136,7 +412,9 @@ public:
 private:
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
-    net::strand<net::io_context::executor_type> strand_;
+    std::optional<Strand> strand_;
+    ServerSettings settings_;
+    std::shared_ptr<ConnectionCounter> connections_;
     RequestHandler request_handler_;
 
     void DoAccept() {
@@ -146,13 +424,40 @@ private:
     }
 
     void OnAccept(sys::error_code ec, tcp::socket socket) {
-        if (ec) return ReportError(ec, "accept");
-        AsyncRunSession(std::move(socket));
+        if (ec) {
+            ReportError(ec, "accept");
+        } else if (auto ticket = connections_->TryAcquire()) {
+            AsyncRunSession(std::move(socket), std::move(*ticket));
+        } else {
+            RejectConnection(std::move(socket));
+        }
         DoAccept();
     }
 
-    void AsyncRunSession(tcp::socket&& socket) {
-        std::make_shared<Session<RequestHandler>>(std::move(socket), strand_, request_handler_)->Run();
+    void AsyncRunSession(tcp::socket&& socket, ConnectionCounter::Ticket&& ticket) {
+        std::make_shared<Session<RequestHandler>>(std::move(socket),
+                                                  strand_ ? *strand_ : net::make_strand(ioc_),
+                                                  settings_, std::move(ticket), request_handler_)
+            ->Run();
+    }
+
+    // Лимит соединений исчерпан: отвечаем заготовленным 503 без чтения запроса
+    // и сразу закрываем сокет. Запись неблокирующая, поэтому acceptor не ждёт клиента.
+    static void RejectConnection(tcp::socket&& socket) {
+        static constexpr std::string_view REJECT_RESPONSE =
+            "HTTP/1.1 503 Service Unavailable\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: 62\r\n"
+            "Retry-After: 1\r\n"
+            "Connection: close\r\n"
+            "\r\n"
+            R"({"code":"serviceUnavailable","message":"Too many connections"})";
+
+        sys::error_code ec;
+        socket.non_blocking(true, ec);
+        socket.write_some(net::buffer(REJECT_RESPONSE), ec);
+        socket.shutdown(tcp::socket::shutdown_both, ec);
+        socket.close(ec);
     }
 };
 
@@ -161,10 +466,26 @@ private:
 template <typename RequestHandler>
 void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint,
                net::strand<net::io_context::executor_type> strand,
-               RequestHandler&& handler) {
+               RequestHandler&& handler, const ServerSettings& settings = {}) {
     using MyListener = Listener<std::decay_t<RequestHandler>>;
-    std::make_shared<MyListener>(ioc, endpoint, strand, std::forward<RequestHandler>(handler))->Run();
+    std::make_shared<MyListener>(ioc, endpoint, strand, settings,
+                                 std::make_shared<ConnectionCounter>(settings.max_connections),
+                                 std::forward<RequestHandler>(handler))->Run();
+}
+
+// Сервер из нескольких шардов: в каждом io_context свой Listener на общем порту
+// (SO_REUSEPORT), и соединение целиком обслуживается потоком шарда, принявшего его.
+// Лимит соединений общий для всех шардов. Обработчик копируется в каждый Listener.
+template <typename RequestHandler>
+void ServeHttpSharded(const std::vector<net::io_context*>& shards, const tcp::endpoint& endpoint,
+                      const RequestHandler& handler, ServerSettings settings = {}) {
+    using MyListener = Listener<RequestHandler>;
+    settings.reuse_port = shards.size() > 1;
+    auto connections = std::make_shared<ConnectionCounter>(settings.max_connections);
+    for (net::io_context* ioc : shards) {
+        std::make_shared<MyListener>(*ioc, endpoint, std::nullopt, settings, connections, handler)
+            ->Run();
+    }
 }
 
 }  // namespace http_server
-  // namespace http_server
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace util {
+
+/*
+ * Выдаёт плотные идентификаторы 0, 1, 2, ...
+ * Освобождённые идентификаторы выдаются повторно (последний освобождённый первым),
+ * поэтому все выданные идентификаторы меньше GetNextId() и по ним можно
+ * индексировать массив размера GetNextId().
+ */
+class IdAllocator {
+ public:
+  using Id = std::uint32_t;
+
+  IdAllocator() = default;
+
+  // Восстанавливает состояние, сохранённое через GetNextId и GetFreeIds.
+  // Повторённый свободный идентификатор был бы выдан двум владельцам
+  IdAllocator(Id next_id, std::vector<Id> free_ids)
+      : next_id_(next_id), free_ids_(std::move(free_ids)) {
+    std::vector<bool> is_free(next_id_);
+    for (Id id : free_ids_) {
+      if (id >= next_id_) {
+        throw std::invalid_argument("Free id " + std::to_string(id) +
+                                    " is out of allocated range");
+      }
+      if (is_free[id]) {
+        throw std::invalid_argument("Free id " + std::to_string(id) + " is repeated");
+      }
+      is_free[id] = true;
+    }
+  }
+
+  Id Allocate() {
+    if (!free_ids_.empty()) {
+      const Id id = free_ids_.back();
+      free_ids_.pop_back();
+      return id;
+    }
+    return next_id_++;
+  }
+
+  void Release(Id id) {
+    assert(id < next_id_);
+    free_ids_.push_back(id);
+  }
+
+  Id GetNextId() const noexcept {
+    return next_id_;
+  }
+
+  const std::vector<Id>& GetFreeIds() const noexcept {
+    return free_ids_;
+  }
+
+ private:
+  Id next_id_ = 0;
+  std::vector<Id> free_ids_;
+};
+
+}  // namespace util
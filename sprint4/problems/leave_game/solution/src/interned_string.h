@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace util {
+
+/*
+ * Строка из общего пула: равные строки хранятся в одном экземпляре, а объект занимает
+ * один указатель со счётчиком ссылок. Строка уходит из пула вместе с последней ссылкой.
+ *
+ * Пул общий для всех потоков и защищён мьютексом. К нему обращаются только при создании
+ * строки и при удалении последней ссылки, копирование и чтение обходятся без блокировки.
+ */
+class InternedString {
+ public:
+  explicit InternedString(std::string_view value) : value_(Intern(value)) {
+  }
+
+  const std::string& Get() const noexcept {
+    return *value_;
+  }
+
+  // Равные строки пула - один и тот же экземпляр
+  bool operator==(const InternedString& other) const noexcept {
+    return value_ == other.value_;
+  }
+
+ private:
+  struct Pool {
+    std::mutex mutex;
+    // Ключ указывает в строку, на которую ссылается значение
+    std::unordered_map<std::string_view, std::weak_ptr<const std::string>> strings;
+  };
+
+  // Пул не разрушается при выходе, чтобы строки статических объектов могли пережить его
+  static Pool& GetPool() {
+    static Pool& pool = *new Pool;
+    return pool;
+  }
+
+  static std::shared_ptr<const std::string> Intern(std::string_view value) {
+    Pool& pool = GetPool();
+    std::lock_guard lock{pool.mutex};
+    if (const auto it = pool.strings.find(value); it != pool.strings.end()) {
+      if (auto existing = it->second.lock()) {
+        return existing;
+      }
+      // Последняя ссылка на прежнюю строку удаляется в другом потоке
+      pool.strings.erase(it);
+    }
+    std::shared_ptr<const std::string> interned{new std::string(value), &Release};
+    pool.strings.emplace(*interned, interned);
+    return interned;
+  }
+
+  static void Release(const std::string* value) {
+    Pool& pool = GetPool();
+    {
+      std::lock_guard lock{pool.mutex};
+      // Запись могла уже смениться записью новой строки с тем же значением
+      const auto it = pool.strings.find(*value);
+      if (it != pool.strings.end() && it->first.data() == value->data()) {
+        pool.strings.erase(it);
+      }
+    }
+    delete value;
+  }
+
+  std::shared_ptr<const std::string> value_;
+};
+
+}  // namespace util
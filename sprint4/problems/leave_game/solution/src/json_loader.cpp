@@ -1,4 +1,8 @@
 #include "json_loader.h"
+#include "log.h"
+#include "map_cache.h"
+#include <array>
+#include <cstdlib>
 #include <fstream>
 #include <boost/json.hpp>
 
@@ -8,13 +12,42 @@ namespace json = boost::json;
 using namespace json_keys;
 
 boost::json::value ParseJsonFromFile(const std::filesystem::path& json_path) {
-  std::ifstream file(json_path);
+  std::ifstream file(json_path, std::ios::binary);
   if (!file) {
     throw std::runtime_error("Failed to open file: " + json_path.string());
   }
-  std::string json_content((std::istreambuf_iterator<char>(file)),
-                           std::istreambuf_iterator<char>());
-  return json::parse(json_content);
+
+  // Файл разбирается по частям, не собираясь целиком в одну строку
+  json::stream_parser parser;
+  std::array<char, 64 * 1024> buffer;
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+    parser.write(buffer.data(), static_cast<std::size_t>(file.gcount()));
+  }
+  if (file.bad()) {
+    throw std::runtime_error("Failed to read file: " + json_path.string());
+  }
+  parser.finish();
+  return parser.release();
+}
+
+loot_gen::SpawnPolicy ParseSpawnPolicy(const json::object& config) {
+  const std::chrono::duration<double> period{config.at(PERIOD).as_double()};
+  const double probability = config.at(PROBABILITY).as_double();
+
+  const std::string_view policy =
+      config.contains(SPAWN_POLICY) ? std::string_view(config.at(SPAWN_POLICY).as_string()) : "rate";
+  if (policy == "rate") {
+    return loot_gen::SpawnPolicy::Rate(period, probability);
+  }
+  if (policy == "capped") {
+    return loot_gen::SpawnPolicy::Capped(period, probability,
+                                         static_cast<unsigned>(config.at(MAX_LOOT).as_int64()));
+  }
+  if (policy == "burst") {
+    return loot_gen::SpawnPolicy::Burst(period, probability);
+  }
+  throw std::invalid_argument("Unknown loot spawn policy: " + std::string(policy));
 }
 
 model::Map ParseMap(const json::object& map_obj, double default_speed, int default_bag_capacity) {
@@ -44,12 +77,16 @@ model::Map ParseMap(const json::object& map_obj, double default_speed, int defau
   } else {
     game_map.SetBagCapacity(default_bag_capacity);
   }
+  if (game_map.GetBagCapacity() > model::Bag::MAX_CAPACITY) {
+    throw std::invalid_argument("Bag capacity of map " + id + " exceeds the limit " +
+                                std::to_string(model::Bag::MAX_CAPACITY));
+  }
   return game_map;
 }
 
 void ParseRoads(model::Map& game_map, const json::array& roads) {
   for (const auto& road_json : roads) {
-    auto road_obj = road_json.as_object();
+    const auto& road_obj = road_json.as_object();
     int x0 = road_obj.at(X0).as_int64();
     int y0 = road_obj.at(Y0).as_int64();
     if (road_obj.contains(X1)) {
@@ -64,7 +101,7 @@ void ParseRoads(model::Map& game_map, const json::array& roads) {
 
 void ParseBuildings(model::Map& game_map, const json::array& buildings) {
   for (const auto& building_json : buildings) {
-    auto building_obj = building_json.as_object();
+    const auto& building_obj = building_json.as_object();
     int x = building_obj.at(X).as_int64();
     int y = building_obj.at(Y).as_int64();
     int w = building_obj.at(WIDTH).as_int64();
@@ -75,7 +112,7 @@ void ParseBuildings(model::Map& game_map, const json::array& buildings) {
 
 void ParseOffices(model::Map& game_map, const json::array& offices) {
   for (const auto& office_json : offices) {
-    auto office_obj = office_json.as_object();
+    const auto& office_obj = office_json.as_object();
     std::string office_id = office_obj.at(ID).as_string().c_str();
     int x = office_obj.at(X).as_int64();
     int y = office_obj.at(Y).as_int64();
@@ -88,7 +125,7 @@ void ParseOffices(model::Map& game_map, const json::array& offices) {
 model::Game LoadGame(const std::filesystem::path& json_path) {
   // Загружаем JSON из файла
   auto json_value = ParseJsonFromFile(json_path);
-  auto json_obj = json_value.as_object();
+  const auto& json_obj = json_value.as_object();
   model::Game game;
 
   // Устанавливаем глобальную скорость по умолчанию (1.0 если не задано)
@@ -123,7 +160,7 @@ model::Game LoadGame(const std::filesystem::path& json_path) {
 
 GamePackage LoadGamePackage(const std::filesystem::path& json_path) {
   auto json_value = ParseJsonFromFile(json_path);
-  auto json_obj = json_value.as_object();
+  auto& json_obj = json_value.as_object();
 
   GamePackage result;
   model::Game& game = result.game;
@@ -138,7 +175,7 @@ GamePackage LoadGamePackage(const std::filesystem::path& json_path) {
   }
   // Загрузка конфигурации генератора трофеев
   if (json_obj.contains(LOOT_GENERATOR_CONFIG)) {
-    auto config = json_obj.at(LOOT_GENERATOR_CONFIG).as_object();
+    const auto& config = json_obj.at(LOOT_GENERATOR_CONFIG).as_object();
 
     double period = config.at(PERIOD).as_double();
     game.GetSettings().period = period;
@@ -146,7 +183,7 @@ GamePackage LoadGamePackage(const std::filesystem::path& json_path) {
     double probability = config.at(PROBABILITY).as_double();
     game.GetSettings().probability = probability;
 
-    game.SetLootGeneratorConfig(period, probability);
+    game.SetSpawnPolicy(ParseSpawnPolicy(config));
   }
 
   if (json_obj.contains(DOG_RETIREMENT_TIME)) {
@@ -154,10 +191,17 @@ GamePackage LoadGamePackage(const std::filesystem::path& json_path) {
     game.GetSettings().dog_retirement_time = retirement_time;
   }
 
+  if (json_obj.contains(SESSION_CAPACITY)) {
+    game.GetSettings().session_capacity = json_obj.at(SESSION_CAPACITY).as_int64();
+  }
+  if (json_obj.contains(SESSION_GRACE_PERIOD)) {
+    game.GetSettings().session_grace_period = json_obj.at(SESSION_GRACE_PERIOD).as_double();
+  }
+
   // Загрузка карт
   if (json_obj.contains(MAPS)) {
-    for (const auto& map_json : json_obj.at(MAPS).as_array()) {
-      auto map_obj = map_json.as_object();
+    for (auto& map_json : json_obj.at(MAPS).as_array()) {
+      auto& map_obj = map_json.as_object();
       auto map = ParseMap(map_obj, game.GetDefaultDogSpeed(), game.GetDefaultBagCapacity());
 
       if (!map.IsDefaultDogSpeedValueConfigured()) {
@@ -166,23 +210,64 @@ GamePackage LoadGamePackage(const std::filesystem::path& json_path) {
 
       extra_data::MapsExtra& extra = result.extra_data;
 
-      if (map_obj.contains(LOOT_TYPES)) {
-        auto loot_types = map_obj.at(LOOT_TYPES);
+      if (auto* loot_types = map_obj.if_contains(LOOT_TYPES)) {
         std::vector<int> loot_values;
-        loot_values.reserve(loot_types.as_array().size());
+        loot_values.reserve(loot_types->as_array().size());
 
-        for (const auto& loot_type : loot_types.as_array()) {
+        for (const auto& loot_type : loot_types->as_array()) {
           loot_values.push_back(loot_type.as_object().at("value").as_int64());
         }
+        // Рюкзак хранит тип трофея байтом
+        if (loot_values.size() > model::Bag::MAX_LOOT_TYPES) {
+          throw std::invalid_argument("Too many loot types on map " + *map.GetId());
+        }
 
-        extra.AddMapData(map.GetId(), loot_types);
+        // Документ больше не нужен, описания трофеев забираются из него без копирования
+        extra.AddMapData(map.GetId(), std::move(*loot_types));
         map.SetLootValues(std::move(loot_values));
       }
 
+      // Карта может задать собственное правило появления трофеев
+      if (map_obj.contains(LOOT_GENERATOR_CONFIG)) {
+        map.SetSpawnPolicy(ParseSpawnPolicy(map_obj.at(LOOT_GENERATOR_CONFIG).as_object()));
+      }
+
+      if (map_obj.contains(SESSION_CAPACITY)) {
+        map.SetSessionCapacity(map_obj.at(SESSION_CAPACITY).as_int64());
+      }
+
       game.AddMap(std::move(map));
     }
   }
 
   return result;
 }
+
+GamePackage LoadGamePackage(const std::filesystem::path& json_path,
+                            const std::filesystem::path& cache_path) {
+  const std::uint64_t config_hash = map_cache::HashFile(json_path);
+  if (auto contents = map_cache::Load(cache_path, config_hash)) {
+    GamePackage result{std::move(contents->game), {}};
+    // Описания трофеев - короткие фрагменты, которые только отдаются клиентам
+    for (const auto& [map_id, loot_types] : contents->loot_types) {
+      result.extra_data.AddMapData(map_id, json::parse(loot_types));
+    }
+    return result;
+  }
+
+  GamePackage result = LoadGamePackage(json_path);
+  map_cache::LootTypes loot_types;
+  for (const auto& map : result.game.GetMaps()) {
+    loot_types.emplace_back(map.GetId(),
+                            json::serialize(result.extra_data.GetLootTypes(map.GetId())));
+  }
+  try {
+    map_cache::Save(cache_path, config_hash, result.game, loot_types);
+  } catch (const std::exception& ex) {
+    // Без кеша следующий запуск будет только медленнее
+    ServerErrorLog(EXIT_FAILURE, "failed to save " + cache_path.string() + ": " + ex.what(),
+                   "map cache");
+  }
+  return result;
+}
 }  // namespace json_loader
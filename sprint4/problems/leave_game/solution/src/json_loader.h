@@ -33,9 +33,13 @@ constexpr const char* DOG_RETIREMENT_TIME = "dogRetirementTime";
 constexpr const char* LOOT_GENERATOR_CONFIG = "lootGeneratorConfig";
 constexpr const char* PERIOD = "period";
 constexpr const char* PROBABILITY = "probability";
+constexpr const char* SPAWN_POLICY = "policy";
+constexpr const char* MAX_LOOT = "maxLoot";
 constexpr const char* LOOT_TYPES = "lootTypes";
 constexpr const char* DEFAULT_BAG_CAPACITY = "defaultBagCapacity";
 constexpr const char* BAG_CAPACITY = "bagCapacity";
+constexpr const char* SESSION_CAPACITY = "sessionCapacity";
+constexpr const char* SESSION_GRACE_PERIOD = "sessionGracePeriod";
 }  // namespace json_keys
 
 struct GamePackage {
@@ -50,6 +54,9 @@ boost::json::value ParseJsonFromFile(const std::filesystem::path& json_path);
 model::Map ParseMap(const boost::json::object& map_obj, double default_speed,
                     int default_bag_capacity);
 
+// Разбирает настройки генератора трофеев (lootGeneratorConfig)
+loot_gen::SpawnPolicy ParseSpawnPolicy(const boost::json::object& config);
+
 // Разбирает дороги и добавляет их в карту
 void ParseRoads(model::Map& game_map, const boost::json::array& roads);
 
@@ -63,4 +70,9 @@ void ParseOffices(model::Map& game_map, const boost::json::array& offices);
 model::Game LoadGame(const std::filesystem::path& json_path);
 GamePackage LoadGamePackage(const std::filesystem::path& json_path);
 
+// Загружает игру из двоичного кеша карт, если он собран для этого же файла конфигурации.
+// Иначе разбирает JSON и перезаписывает кеш.
+GamePackage LoadGamePackage(const std::filesystem::path& json_path,
+                            const std::filesystem::path& cache_path);
+
 }  // namespace json_loader
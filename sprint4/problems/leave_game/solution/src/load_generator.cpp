@@ -0,0 +1,439 @@
+#include "load_generator.h"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace load {
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = net::ip::tcp;
+using namespace std::literals;
+
+//---------------------------Stats---------------------------
+
+void Stats::Record(RequestKind kind, Clock::duration latency, unsigned status) {
+  auto& stats = kinds_[static_cast<std::size_t>(kind)];
+  stats.latency.Record(latency);
+  if (status >= 500) {
+    stats.status_5xx.fetch_add(1, std::memory_order_relaxed);
+  } else if (status >= 400) {
+    stats.status_4xx.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    stats.status_2xx.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Stats::RecordError(RequestKind kind) {
+  kinds_[static_cast<std::size_t>(kind)].io_errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+json::object Stats::ToJson(Clock::duration elapsed) const {
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  auto to_ms = [](std::uint64_t ns) {
+    return static_cast<double>(ns) / 1e6;
+  };
+
+  json::object result;
+  for (std::size_t i = 0; i < kinds_.size(); ++i) {
+    const auto& stats = kinds_[i];
+    const auto snapshot = stats.latency.TakeSnapshot();
+    if (snapshot.count == 0 && stats.io_errors == 0) {
+      continue;
+    }
+
+    json::object latency{
+        {"mean", snapshot.count ? to_ms(snapshot.sum / snapshot.count) : 0.0},
+        {"p50", to_ms(snapshot.ValueAtQuantile(0.5))},
+        {"p90", to_ms(snapshot.ValueAtQuantile(0.9))},
+        {"p99", to_ms(snapshot.ValueAtQuantile(0.99))},
+        {"p99.9", to_ms(snapshot.ValueAtQuantile(0.999))},
+        {"max", to_ms(snapshot.ValueAtQuantile(1.0))}};
+
+    result[REQUEST_KIND_NAMES[i]] = json::object{
+        {"count", snapshot.count},
+        {"throughput_rps", seconds > 0 ? static_cast<double>(snapshot.count) / seconds : 0.0},
+        {"status_2xx", stats.status_2xx.load()},
+        {"status_4xx", stats.status_4xx.load()},
+        {"status_5xx", stats.status_5xx.load()},
+        {"io_errors", stats.io_errors.load()},
+        {"latency_ms", std::move(latency)}};
+  }
+  return result;
+}
+
+//---------------------------Client---------------------------
+
+namespace {
+
+constexpr std::string_view DIRECTIONS[] = {"L", "R", "U", "D", ""};
+
+struct Shared {
+  const Config& config;
+  tcp::resolver::results_type endpoints;
+  Stats& stats;
+  std::atomic<bool> stopped{false};
+};
+
+/*
+ * Клиент с одним keep-alive соединением и не более чем одним запросом в полёте.
+ * Запрос отправляется в момент, назначенный наследником; задержка отсчитывается
+ * от этого момента, поэтому задержка очереди клиента тоже попадает в статистику.
+ */
+class Client : public std::enable_shared_from_this<Client> {
+ public:
+  Client(net::io_context& ioc, Shared& shared)
+      : shared_(shared), stream_(net::make_strand(ioc)), timer_(stream_.get_executor()) {
+  }
+
+  virtual ~Client() = default;
+
+  void Start() {
+    stream_.expires_after(10s);
+    stream_.async_connect(shared_.endpoints,
+                          beast::bind_front_handler(&Client::OnConnect, shared_from_this()));
+  }
+
+ protected:
+  using Request = http::request<http::string_body>;
+  using Response = http::response<http::string_body>;
+
+  // Вызывается после установки соединения и после каждого ответа
+  virtual void Next() = 0;
+  virtual void OnResponse(RequestKind kind, const Response& response) = 0;
+
+  bool IsStopped() const {
+    return shared_.stopped.load(std::memory_order_relaxed);
+  }
+
+  const Config& GetConfig() const {
+    return shared_.config;
+  }
+
+  // Отправляет запрос не раньше момента at. Задержка считается от at.
+  void SendAt(Clock::time_point at, RequestKind kind, http::verb verb, std::string_view target,
+              std::string body = {}) {
+    request_ = Request{verb, target, 11};
+    request_.set(http::field::host, shared_.config.host);
+    if (!token_.empty()) {
+      request_.set(http::field::authorization, "Bearer " + token_);
+    }
+    if (verb == http::verb::post) {
+      request_.set(http::field::content_type, "application/json");
+      request_.body() = std::move(body);
+    }
+    request_.prepare_payload();
+    request_.keep_alive(true);
+
+    kind_ = kind;
+    intended_start_ = at;
+
+    if (at <= Clock::now()) {
+      return Write();
+    }
+    timer_.expires_at(at);
+    timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+      if (!ec) {
+        self->Write();
+      }
+    });
+  }
+
+  std::string token_;
+
+ private:
+  void OnConnect(beast::error_code ec, const tcp::endpoint&) {
+    if (ec) {
+      // Сервер недоступен (например, перезапускается): клиент не выбывает, а пробует
+      // снова со всё большей паузой, чтобы предлагаемая нагрузка не таяла незаметно
+      shared_.stats.RecordError(kind_);
+      stream_.close();
+      timer_.expires_after(reconnect_delay_);
+      reconnect_delay_ = std::min(reconnect_delay_ * 2, MAX_RECONNECT_DELAY);
+      timer_.async_wait([self = shared_from_this()](beast::error_code wait_ec) {
+        if (!wait_ec) {
+          self->Reconnect();
+        }
+      });
+      return;
+    }
+    reconnect_delay_ = MIN_RECONNECT_DELAY;
+    Next();
+  }
+
+  void Write() {
+    if (IsStopped()) {
+      return;
+    }
+    // В закрытой модели отсчёт идёт от фактической отправки
+    if (!shared_.config.open_loop) {
+      intended_start_ = Clock::now();
+    }
+    stream_.expires_after(30s);
+    http::async_write(stream_, request_,
+                      beast::bind_front_handler(&Client::OnWrite, shared_from_this()));
+  }
+
+  void OnWrite(beast::error_code ec, std::size_t) {
+    if (ec) {
+      return OnError();
+    }
+    response_ = {};
+    http::async_read(stream_, buffer_, response_,
+                     beast::bind_front_handler(&Client::OnRead, shared_from_this()));
+  }
+
+  void OnRead(beast::error_code ec, std::size_t) {
+    if (ec) {
+      return OnError();
+    }
+    shared_.stats.Record(kind_, Clock::now() - intended_start_, response_.result_int());
+    OnResponse(kind_, response_);
+
+    if (response_.need_eof()) {
+      // Сервер закрывает соединение (например, после ответа 503) - переподключаемся
+      beast::error_code ignored;
+      stream_.socket().shutdown(tcp::socket::shutdown_both, ignored);
+      stream_.close();
+      return Reconnect();
+    }
+    if (!IsStopped()) {
+      Next();
+    }
+  }
+
+  void OnError() {
+    shared_.stats.RecordError(kind_);
+    stream_.close();
+    Reconnect();
+  }
+
+  void Reconnect() {
+    if (IsStopped()) {
+      return;
+    }
+    buffer_.clear();
+    stream_.expires_after(10s);
+    stream_.async_connect(shared_.endpoints,
+                          beast::bind_front_handler(&Client::OnConnect, shared_from_this()));
+  }
+
+  static constexpr Clock::duration MIN_RECONNECT_DELAY = 50ms;
+  static constexpr Clock::duration MAX_RECONNECT_DELAY = 2s;
+
+  Shared& shared_;
+  beast::tcp_stream stream_;
+  net::steady_timer timer_;
+  beast::flat_buffer buffer_;
+  Request request_;
+  Response response_;
+  RequestKind kind_ = RequestKind::JOIN;
+  Clock::time_point intended_start_;
+  Clock::duration reconnect_delay_ = MIN_RECONNECT_DELAY;
+};
+
+// Виртуальный игрок: входит в игру, затем двигается и опрашивает состояние
+class Player : public Client {
+ public:
+  static constexpr auto JOIN_RETRY_DELAY = 100ms;
+
+  Player(net::io_context& ioc, Shared& shared, std::string name, std::string map_id,
+         std::uint64_t seed)
+      : Client(ioc, shared), name_(std::move(name)), map_id_(std::move(map_id)), random_(seed) {
+    const auto& config = GetConfig();
+    action_interval_ = ToInterval(config.action_rate);
+    state_interval_ = ToInterval(config.state_rate);
+  }
+
+ private:
+  static Clock::duration ToInterval(double rate) {
+    return rate > 0 ? std::chrono::duration_cast<Clock::duration>(
+                          std::chrono::duration<double>(1.0 / rate))
+                    : Clock::duration::max();
+  }
+
+  void Next() override {
+    const auto now = Clock::now();
+    if (token_.empty()) {
+      // Неудачный вход повторяется с паузой, чтобы не нагружать сервер, отвечающий 503
+      const auto at = join_attempted_ ? now + JOIN_RETRY_DELAY : now;
+      join_attempted_ = true;
+      json::object body{{"userName", name_}, {"mapId", map_id_}};
+      return SendAt(at, RequestKind::JOIN, http::verb::post, "/api/v1/game/join",
+                    json::serialize(body));
+    }
+
+    if (!started_) {
+      // Случайная начальная фаза, чтобы игроки не отправляли запросы синхронно
+      started_ = true;
+      next_action_ = FirstRequestTime(now, action_interval_);
+      next_state_ = FirstRequestTime(now, state_interval_);
+    }
+    if (next_action_ == Clock::time_point::max() && next_state_ == Clock::time_point::max()) {
+      return;
+    }
+
+    if (next_action_ <= next_state_) {
+      const auto at = next_action_;
+      next_action_ = Advance(next_action_, action_interval_, now);
+      std::uniform_int_distribution<std::size_t> dir(0, std::size(DIRECTIONS) - 1);
+      json::object body{{"move", DIRECTIONS[dir(random_)]}};
+      SendAt(at, RequestKind::ACTION, http::verb::post, "/api/v1/game/player/action",
+             json::serialize(body));
+    } else {
+      const auto at = next_state_;
+      next_state_ = Advance(next_state_, state_interval_, now);
+      SendAt(at, RequestKind::STATE, http::verb::get, "/api/v1/game/state");
+    }
+  }
+
+  Clock::time_point FirstRequestTime(Clock::time_point now, Clock::duration interval) {
+    if (interval == Clock::duration::max()) {
+      return Clock::time_point::max();
+    }
+    std::uniform_real_distribution<double> phase(0.0, 1.0);
+    return now + std::chrono::duration_cast<Clock::duration>(interval * phase(random_));
+  }
+
+  // В открытой модели расписание не зависит от ответов сервера.
+  // В закрытой следующий запрос планируется от текущего момента (время на раздумье).
+  Clock::time_point Advance(Clock::time_point scheduled, Clock::duration interval,
+                            Clock::time_point now) const {
+    if (interval == Clock::duration::max()) {
+      return Clock::time_point::max();
+    }
+    return GetConfig().open_loop ? scheduled + interval : std::max(scheduled, now) + interval;
+  }
+
+  void OnResponse(RequestKind kind, const Response& response) override {
+    if (kind != RequestKind::JOIN || response.result() != http::status::ok) {
+      return;
+    }
+    try {
+      auto value = json::parse(response.body());
+      token_ = json::value_to<std::string>(value.as_object().at("authToken"));
+    } catch (const std::exception&) {
+      // Повторим вход при следующем вызове Next
+    }
+  }
+
+  std::string name_;
+  std::string map_id_;
+  std::mt19937_64 random_;
+  Clock::duration action_interval_;
+  Clock::duration state_interval_;
+  Clock::time_point next_action_;
+  Clock::time_point next_state_;
+  bool join_attempted_ = false;
+  bool started_ = false;
+};
+
+// Отправляет ручные тики с постоянным периодом
+class TickDriver : public Client {
+ public:
+  using Client::Client;
+
+ private:
+  void Next() override {
+    const auto period = GetConfig().tick_period;
+    const auto now = Clock::now();
+    if (next_tick_ == Clock::time_point{}) {
+      next_tick_ = now;
+    }
+    const auto at = next_tick_;
+    next_tick_ += period;
+
+    json::object body{{"timeDelta", period.count()}};
+    SendAt(at, RequestKind::TICK, http::verb::post, "/api/v1/game/tick", json::serialize(body));
+  }
+
+  void OnResponse(RequestKind, const Response&) override {
+  }
+
+  Clock::time_point next_tick_{};
+};
+
+}  // namespace
+
+//---------------------------LoadGenerator---------------------------
+
+LoadGenerator::LoadGenerator(Config config) : config_(std::move(config)) {
+}
+
+std::vector<std::string> LoadGenerator::FetchMaps(
+    const tcp::resolver::results_type& endpoints) {
+  beast::tcp_stream stream(ioc_);
+  stream.connect(endpoints);
+
+  http::request<http::string_body> request{http::verb::get, "/api/v1/maps", 11};
+  request.set(http::field::host, config_.host);
+  http::write(stream, request);
+
+  beast::flat_buffer buffer;
+  http::response<http::string_body> response;
+  http::read(stream, buffer, response);
+
+  beast::error_code ignored;
+  stream.socket().shutdown(tcp::socket::shutdown_both, ignored);
+
+  std::vector<std::string> maps;
+  for (const auto& map : json::parse(response.body()).as_array()) {
+    maps.push_back(json::value_to<std::string>(map.as_object().at("id")));
+  }
+  return maps;
+}
+
+json::object LoadGenerator::Run() {
+  tcp::resolver resolver(ioc_);
+  auto endpoints = resolver.resolve(config_.host, config_.port);
+
+  auto maps = config_.maps.empty() ? FetchMaps(endpoints) : config_.maps;
+  if (maps.empty()) {
+    throw std::runtime_error("Server has no maps");
+  }
+
+  Shared shared{config_, endpoints, stats_};
+  std::mt19937_64 seeds(config_.seed);
+
+  for (unsigned i = 0; i < config_.players; ++i) {
+    std::make_shared<Player>(ioc_, shared, "load-" + std::to_string(i), maps[i % maps.size()],
+                             seeds())
+        ->Start();
+  }
+  if (config_.tick_period.count() > 0) {
+    std::make_shared<TickDriver>(ioc_, shared)->Start();
+  }
+
+  const auto start = Clock::now();
+  net::steady_timer stop_timer(ioc_, config_.duration);
+  stop_timer.async_wait([this, &shared](beast::error_code) {
+    shared.stopped = true;
+    ioc_.stop();
+  });
+
+  std::vector<std::jthread> workers;
+  for (unsigned i = 1; i < std::max(1u, config_.threads); ++i) {
+    workers.emplace_back([this] {
+      ioc_.run();
+    });
+  }
+  ioc_.run();
+  workers.clear();
+
+  const auto elapsed = Clock::now() - start;
+  return json::object{{"mode", config_.open_loop ? "open" : "closed"},
+                      {"coordinated_omission_corrected", config_.open_loop},
+                      {"players", config_.players},
+                      {"duration_s", std::chrono::duration<double>(elapsed).count()},
+                      {"requests", stats_.ToJson(elapsed)}};
+}
+
+}  // namespace load
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "sdk.h"
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/json.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metrics.h"
+
+namespace load {
+
+namespace net = boost::asio;
+namespace json = boost::json;
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  std::string host = "127.0.0.1";
+  std::string port = "8080";
+  // Количество виртуальных игроков, у каждого своё keep-alive соединение
+  unsigned players = 100;
+  // Карты, по которым игроки распределяются по кругу. Пустой список - все карты сервера.
+  std::vector<std::string> maps;
+  // Открытая модель: запросы отправляются по расписанию независимо от ответов,
+  // задержка считается от запланированного момента отправки.
+  // Закрытая модель: следующий запрос игрока ждёт ответа на предыдущий.
+  bool open_loop = true;
+  // Частота запросов на одного игрока, в секунду
+  double action_rate = 1.0;
+  double state_rate = 2.0;
+  // Период ручных тиков. 0 - сервер тикает сам и /game/tick не вызывается.
+  std::chrono::milliseconds tick_period{0};
+  std::chrono::seconds duration{30};
+  unsigned threads = 1;
+  std::uint64_t seed = 1;
+};
+
+enum class RequestKind { JOIN, ACTION, STATE, TICK };
+inline constexpr std::array<std::string_view, 4> REQUEST_KIND_NAMES = {"join", "action", "state",
+                                                                       "tick"};
+
+// Статистика по видам запросов. Запись потокобезопасна.
+class Stats {
+ public:
+  void Record(RequestKind kind, Clock::duration latency, unsigned status);
+  void RecordError(RequestKind kind);
+
+  json::object ToJson(Clock::duration elapsed) const;
+
+ private:
+  struct KindStats {
+    metrics::Histogram latency;
+    std::atomic<std::uint64_t> status_2xx{0};
+    std::atomic<std::uint64_t> status_4xx{0};
+    std::atomic<std::uint64_t> status_5xx{0};
+    std::atomic<std::uint64_t> io_errors{0};
+  };
+
+  std::array<KindStats, REQUEST_KIND_NAMES.size()> kinds_;
+};
+
+/*
+ * Генератор нагрузки на игровой сервер.
+ * Игроки входят в игру на картах сервера, затем с заданной частотой
+ * отправляют player/action со случайным направлением и опрашивают game/state.
+ */
+class LoadGenerator {
+ public:
+  explicit LoadGenerator(Config config);
+
+  // Запускает игроков и возвращает отчёт по истечении config.duration
+  json::object Run();
+
+ private:
+  std::vector<std::string> FetchMaps(const net::ip::tcp::resolver::results_type& endpoints);
+
+  Config config_;
+  net::io_context ioc_;
+  Stats stats_;
+};
+
+}  // namespace load
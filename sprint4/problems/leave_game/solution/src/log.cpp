@@ -1,5 +1,16 @@
 #include "log.h"
 
+namespace {
+
+// Механизм ввода-вывода Asio, с которым собран сервер (см. GAME_SERVER_IO_URING в CMakeLists.txt)
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+constexpr std::string_view IO_BACKEND = "io_uring";
+#else
+constexpr std::string_view IO_BACKEND = "epoll";
+#endif
+
+}  // namespace
+
 void JsonFormatter(logging::record_view const& rec, logging::formatting_ostream& strm) {
     boost::json::object log_entry;
     auto ts = *rec[timestamp];
@@ -27,6 +38,7 @@ void ServerStartLog(unsigned port, boost::asio::ip::address ip) {
 
     data["port"] = port;
     data["address"] = ip.to_string();
+    data["io_backend"] = IO_BACKEND;
 
     BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, data) << "server started";
 }
@@ -50,3 +62,24 @@ void ServerErrorLog(unsigned err_code, std::string_view message, std::string_vie
 
     BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, data) << "error";
 }
+
+void MapsReloadLog(std::size_t maps, std::size_t sessions_kept, std::size_t sessions_migrated,
+                   std::size_t sessions_retired) {
+    boost::json::object data;
+
+    data["maps"] = maps;
+    data["sessions_kept"] = sessions_kept;
+    data["sessions_migrated"] = sessions_migrated;
+    data["sessions_retired"] = sessions_retired;
+
+    BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, data) << "maps reloaded";
+}
+
+void GameRecordingStoppedLog(std::string_view reason) {
+    boost::json::object data;
+
+    data["reason"] = std::string(reason);
+
+    BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, data)
+                            << "game recording stopped";
+}
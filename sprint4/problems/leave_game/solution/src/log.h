@@ -22,3 +22,9 @@ void StartLogging();
 void ServerStartLog(unsigned port, boost::asio::ip::address ip);
 void ServerStopLog(unsigned err_code, std::string_view ex);
 void ServerErrorLog(unsigned err_code, std::string_view message, std::string_view place);
+// sessions_* - сколько сессий осталось на тех же картах, перенесено на изменившиеся
+// и доигрывается на убранных из конфигурации
+void MapsReloadLog(std::size_t maps, std::size_t sessions_kept, std::size_t sessions_migrated,
+                   std::size_t sessions_retired);
+// Запись команд игры (--record-file) прекращена до остановки сервера
+void GameRecordingStoppedLog(std::string_view reason);
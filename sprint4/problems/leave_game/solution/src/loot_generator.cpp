@@ -19,4 +19,92 @@ unsigned LootGenerator::Generate(TimeInterval time_delta, unsigned loot_count,
     return generated_loot;
 }
 
+void SpawnBatch::Clear() {
+    for (auto* column : {&time_without_loot_, &base_interval_, &probability_, &log_keep_,
+                         &is_burst_, &shortage_, &random_, &generated_}) {
+        column->clear();
+    }
+}
+
+void SpawnBatch::Reserve(size_t count) {
+    for (auto* column : {&time_without_loot_, &base_interval_, &probability_, &log_keep_,
+                         &is_burst_, &shortage_, &random_, &generated_}) {
+        column->reserve(count);
+    }
+}
+
+void SpawnBatch::Add(const SpawnState& state, unsigned loot_count, unsigned looter_count,
+                     double random) {
+    const auto& policy = state.policy;
+    unsigned shortage = loot_count > looter_count ? 0u : looter_count - loot_count;
+    if (policy.kind == SpawnPolicy::Kind::CAPPED) {
+        shortage = std::min(shortage, loot_count >= policy.max_loot ? 0u : policy.max_loot - loot_count);
+    }
+
+    time_without_loot_.push_back(state.time_without_loot.count());
+    base_interval_.push_back(policy.base_interval.count());
+    probability_.push_back(policy.probability);
+    log_keep_.push_back(std::log1p(-std::min(policy.probability, 1.0)));
+    is_burst_.push_back(policy.kind == SpawnPolicy::Kind::BURST ? 1.0 : 0.0);
+    shortage_.push_back(shortage);
+    random_.push_back(random);
+    generated_.push_back(0.0);
+}
+
+namespace {
+
+constexpr double TIME_EPSILON = 1e-9;
+
+// Массивы передаются параметрами с __restrict: так компилятор знает, что они
+// не пересекаются, и может векторизовать циклы
+void GenerateSpawns(size_t size, double delta, double* __restrict time,
+                    const double* __restrict base, const double* __restrict probability,
+                    const double* __restrict log_keep, const double* __restrict is_burst,
+                    const double* __restrict shortage, const double* __restrict random,
+                    double* __restrict generated) {
+    // Вероятность того, что трофей так и не появился: (1 - p)^(t / base).
+    // Временно хранится в generated.
+    for (size_t i = 0; i < size; ++i) {
+        generated[i] = std::exp((time[i] + delta) / base[i] * log_keep[i]);
+    }
+
+    // Выбор по правилу сделан арифметикой, а не ветвлениями
+    for (size_t i = 0; i < size; ++i) {
+        const double elapsed = time[i] + delta;
+
+        // RATE и CAPPED, как в LootGenerator
+        const double rate_probability
+            = std::min(std::max((1.0 - generated[i]) * random[i], 0.0), 1.0);
+        const double rate_count = std::floor(shortage[i] * rate_probability + 0.5);
+
+        // BURST: один бросок за каждый истёкший базовый интервал.
+        // Допуск нужен, чтобы сумма шагов вроде 10 * 0.1 засчитывалась как целый интервал.
+        const double interval_passed = elapsed + TIME_EPSILON >= base[i];
+        const double burst_count = shortage[i] * interval_passed * (random[i] < probability[i]);
+
+        const double count = is_burst[i] * burst_count + (1.0 - is_burst[i]) * rate_count;
+        const double reset = is_burst[i] * interval_passed + (1.0 - is_burst[i]) * (count > 0.0);
+
+        generated[i] = count;
+        time[i] = elapsed * (1.0 - reset);
+    }
+}
+
+}  // namespace
+
+void SpawnBatch::Generate(std::chrono::duration<double> time_delta) {
+    GenerateSpawns(Size(), time_delta.count(), time_without_loot_.data(), base_interval_.data(),
+                   probability_.data(), log_keep_.data(), is_burst_.data(), shortage_.data(),
+                   random_.data(), generated_.data());
+}
+
+unsigned Generate(SpawnState& state, std::chrono::duration<double> time_delta,
+                  unsigned loot_count, unsigned looter_count, double random) {
+    SpawnBatch batch;
+    batch.Add(state, loot_count, looter_count, random);
+    batch.Generate(time_delta);
+    state.time_without_loot = batch.GetTimeWithoutLoot(0);
+    return batch.GetGenerated(0);
+}
+
 } // namespace loot_gen
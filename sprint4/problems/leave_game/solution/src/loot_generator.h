@@ -1,6 +1,9 @@
 #pragma once
 #include <chrono>
+#include <cstddef>
 #include <functional>
+#include <limits>
+#include <vector>
 
 namespace loot_gen {
 
@@ -45,4 +48,86 @@ private:
     RandomGenerator random_generator_;
 };
 
+/*
+ * Правило появления трофеев в игровой сессии.
+ * RATE - как у LootGenerator: вероятность появления растёт со временем без трофеев,
+ *        количество не превышает нехватку трофеев относительно мародёров.
+ * CAPPED - как RATE, но всего трофеев на карте не больше max_loot.
+ * BURST - раз в base_interval с вероятностью probability сразу восполняется вся нехватка.
+ */
+struct SpawnPolicy {
+    enum class Kind { RATE, CAPPED, BURST };
+
+    static SpawnPolicy Rate(std::chrono::duration<double> base_interval, double probability) {
+        return {Kind::RATE, base_interval, probability};
+    }
+
+    static SpawnPolicy Capped(std::chrono::duration<double> base_interval, double probability,
+                              unsigned max_loot) {
+        return {Kind::CAPPED, base_interval, probability, max_loot};
+    }
+
+    static SpawnPolicy Burst(std::chrono::duration<double> base_interval, double probability) {
+        return {Kind::BURST, base_interval, probability};
+    }
+
+    Kind kind = Kind::RATE;
+    std::chrono::duration<double> base_interval{1.0};
+    double probability = 0;
+    unsigned max_loot = std::numeric_limits<unsigned>::max();
+
+    bool operator==(const SpawnPolicy&) const = default;
+};
+
+// Состояние генератора одной игровой сессии
+struct SpawnState {
+    SpawnPolicy policy;
+    std::chrono::duration<double> time_without_loot{};
+};
+
+/*
+ * Генерация трофеев сразу для многих сессий.
+ * Состояния сессий раскладываются по отдельным массивам, и расчёт идёт
+ * одним проходом без ветвлений, который компилятор может векторизовать.
+ */
+class SpawnBatch {
+public:
+    void Clear();
+    void Reserve(size_t count);
+
+    // random - случайное число от 0 до 1 для этой сессии на текущем тике
+    void Add(const SpawnState& state, unsigned loot_count, unsigned looter_count, double random);
+
+    // Рассчитывает количество новых трофеев для всех добавленных сессий
+    void Generate(std::chrono::duration<double> time_delta);
+
+    size_t Size() const noexcept {
+        return time_without_loot_.size();
+    }
+
+    unsigned GetGenerated(size_t index) const noexcept {
+        return static_cast<unsigned>(generated_[index]);
+    }
+
+    // Новое значение SpawnState::time_without_loot после Generate
+    std::chrono::duration<double> GetTimeWithoutLoot(size_t index) const noexcept {
+        return std::chrono::duration<double>{time_without_loot_[index]};
+    }
+
+private:
+    // Все величины хранятся в double, чтобы цикл в Generate не смешивал типы
+    std::vector<double> time_without_loot_;
+    std::vector<double> base_interval_;
+    std::vector<double> probability_;
+    std::vector<double> log_keep_;  // ln(1 - probability)
+    std::vector<double> is_burst_;
+    std::vector<double> shortage_;  // сколько трофеев можно добавить
+    std::vector<double> random_;
+    std::vector<double> generated_;
+};
+
+// Генерация для одной сессии, обновляет state
+unsigned Generate(SpawnState& state, std::chrono::duration<double> time_delta,
+                  unsigned loot_count, unsigned looter_count, double random = 1.0);
+
 }  // namespace loot_gen
@@ -3,6 +3,7 @@
 #include <boost/asio/signal_set.hpp>
 #include <thread>
 #include <cstdlib>
+#include <functional>
 
 #include "json_loader.h"
 #include "request_handler.h"
@@ -10,6 +11,7 @@
 #include "request_logger.h"
 #include "command_line.h"
 #include "application.h"  // Add this include
+#include "shard.h"
 
 using namespace std::literals;
 namespace net = boost::asio;
@@ -52,13 +54,26 @@ int main(int argc, const char* argv[]) {
 
     // 2. Инициализируем io_context
     const unsigned num_threads = std::thread::hardware_concurrency();
-    net::io_context ioc(num_threads);
-    net::strand strand = net::make_strand(ioc);
+    // В режиме шардов каждый шард обслуживает свои соединения и свою часть игры,
+    // а шард 0 ещё и ведёт тики
+    const bool sharded = config->shards > 0;
+    shard::ShardSet shards{config->shards, 0};
+    net::io_context ioc(sharded ? 1 : num_threads);
+    net::io_context& game_ioc = sharded ? shards[0].GetIoContext() : ioc;
+    net::strand strand = net::make_strand(game_ioc);
 
     // 1. Загружаем карту из файла и построить модель игры
-    auto [game, maps_extra] = json_loader::LoadGamePackage(config->config_file);
+    const auto load_game_package = [config_file = config->config_file,
+                                    map_cache_file = config->map_cache_file] {
+      return map_cache_file.empty() ? json_loader::LoadGamePackage(config_file)
+                                    : json_loader::LoadGamePackage(config_file, map_cache_file);
+    };
+    auto [game, maps_extra] = load_game_package();
     app::Application app(std::move(game), std::move(maps_extra), GetAppConfigDbUrlFromEnv());
     app.SetGameSettings(config);
+    if (sharded) {
+      app.SplitIntoShards(shards);
+    }
     app.SetGameTicker(config, strand);
 
     app.SetSaveSettings(config);
@@ -67,7 +82,7 @@ int main(int argc, const char* argv[]) {
     if (!config->state_file.empty() && std::filesystem::exists(config->state_file)) {
       try {
         std::ifstream in(config->state_file);
-        model::LoadGame(app.GetGame(), app.GetPlayers(), in);
+        app.LoadState(in);
       } catch (const std::exception& ex) {
         std::cerr << "Failed to load state from file " << config->state_file << ": " << ex.what()
                   << std::endl;
@@ -75,32 +90,75 @@ int main(int argc, const char* argv[]) {
         return EXIT_FAILURE;
       }
     }
+    app.StartRecording(config);
 
     // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
-    net::signal_set signals(ioc, SIGINT, SIGTERM);
-    signals.async_wait([&ioc, &app](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+    net::signal_set signals(game_ioc, SIGINT, SIGTERM);
+    signals.async_wait([&ioc, &shards, sharded, &app](const sys::error_code& ec,
+                                                      [[maybe_unused]] int signal_number) {
       if (!ec) {
         ioc.stop();
-        app.SaveStateBeforeExit();
+        shards.Stop();
+        // Части игры в других шардах ещё работают: состояние сохраняется после их остановки
+        if (!sharded) {
+          app.SaveStateBeforeExit();
+        }
       }
     });
+    // SIGHUP перезагружает карты из файла конфигурации без перезапуска сервера
+    net::signal_set reload_signals(game_ioc, SIGHUP);
+    std::function<void()> wait_reload_signal = [&] {
+      reload_signals.async_wait([&](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        if (!ec) {
+          app.ReloadMapsAsync(strand, load_game_package);
+          wait_reload_signal();
+        }
+      });
+    };
+    wait_reload_signal();
+
     // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-    http_handler::RequestHandler handler{app, strand, config->www_root};
+    admission::EndpointLimits api_limits{
+        .max_in_flight = std::max(1u, config->max_inflight_requests),
+        .queue_budget = std::chrono::milliseconds(config->queue_budget)};
+    http_handler::RequestHandler handler{app, strand, config->www_root, api_limits,
+                                         sharded ? &shards : nullptr};
     LoggingRequestHandler logging_handler(handler);
 
     // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
     const auto address = net::ip::make_address("0.0.0.0");
     constexpr net::ip::port_type port = 8080;
 
-    http_server::ServeHttp(
-        ioc, {address, port}, strand, [&logging_handler](auto&& req, auto&& send) {
-          logging_handler(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
-        });
+    http_server::ServerSettings server_settings{
+        .header_read_timeout = std::chrono::milliseconds(config->header_timeout),
+        .body_read_timeout = std::chrono::milliseconds(config->body_timeout),
+        .keep_alive_timeout = std::chrono::milliseconds(config->idle_timeout),
+        .max_pipelined_requests = std::max(1u, config->max_pipelined_requests),
+        .max_connections = config->max_connections};
+
+    const auto serve = [&logging_handler](auto&& req, auto&& send) {
+      logging_handler(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
+    };
+    if (sharded) {
+      std::vector<net::io_context*> contexts;
+      for (unsigned i = 0; i < shards.Size(); ++i) {
+        contexts.push_back(&shards[i].GetIoContext());
+      }
+      http_server::ServeHttpSharded(contexts, {address, port}, serve, server_settings);
+    } else {
+      http_server::ServeHttp(ioc, {address, port}, strand, serve, server_settings);
+    }
 
     ServerStartLog(port, address);
 
     // 6. Запускаем обработку асинхронных операций
-    RunWorkers(std::max(1u, num_threads), [&ioc] { ioc.run(); });
+    if (sharded) {
+      // Шарды останавливаются по сигналу
+      shards.Start();
+      shards.Join();
+    } else {
+      RunWorkers(std::max(1u, num_threads), [&ioc] { ioc.run(); });
+    }
 
     app.SaveStateBeforeExit();
 
@@ -0,0 +1,322 @@
+#include "map_cache.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace map_cache {
+
+namespace {
+
+namespace bip = boost::interprocess;
+namespace fs = std::filesystem;
+
+constexpr std::array<char, 8> MAGIC = {'G', 'A', 'M', 'E', 'M', 'A', 'P', 'S'};
+// Увеличивается при любом изменении формата
+constexpr std::uint32_t FORMAT_VERSION = 1;
+// Сигнатура, версия, хеш конфигурации и размер остальной части файла
+constexpr std::size_t HEADER_SIZE =
+    MAGIC.size() + sizeof(FORMAT_VERSION) + 2 * sizeof(std::uint64_t);
+
+constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+class Writer {
+ public:
+  template <typename T>
+  void Put(T value) {
+    static_assert(std::is_arithmetic_v<T>);
+    data_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void PutString(std::string_view text) {
+    Put(static_cast<std::uint32_t>(text.size()));
+    data_.append(text);
+  }
+
+  const std::string& GetData() const noexcept {
+    return data_;
+  }
+
+ private:
+  std::string data_;
+};
+
+// Читает поля из отображённого файла; выход за его границу - исключение
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {
+  }
+
+  template <typename T>
+  T Get() {
+    static_assert(std::is_arithmetic_v<T>);
+    T value;
+    std::memcpy(&value, Take(sizeof(value)).data(), sizeof(value));
+    return value;
+  }
+
+  std::string_view GetString() {
+    return Take(Get<std::uint32_t>());
+  }
+
+  bool AtEnd() const noexcept {
+    return data_.empty();
+  }
+
+ private:
+  std::string_view Take(std::size_t size) {
+    if (size > data_.size()) {
+      throw std::out_of_range("Map cache is truncated");
+    }
+    const std::string_view result = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return result;
+  }
+
+  std::string_view data_;
+};
+
+void WriteSpawnPolicy(Writer& writer, const loot_gen::SpawnPolicy& policy) {
+  writer.Put(static_cast<std::uint8_t>(policy.kind));
+  writer.Put(policy.base_interval.count());
+  writer.Put(policy.probability);
+  writer.Put(policy.max_loot);
+}
+
+loot_gen::SpawnPolicy ReadSpawnPolicy(Reader& reader) {
+  loot_gen::SpawnPolicy policy;
+  policy.kind = static_cast<loot_gen::SpawnPolicy::Kind>(reader.Get<std::uint8_t>());
+  policy.base_interval = std::chrono::duration<double>{reader.Get<double>()};
+  policy.probability = reader.Get<double>();
+  policy.max_loot = reader.Get<unsigned>();
+  return policy;
+}
+
+template <typename T>
+void WriteOptional(Writer& writer, const std::optional<T>& value, auto&& write) {
+  writer.Put(static_cast<std::uint8_t>(value.has_value()));
+  if (value) {
+    write(*value);
+  }
+}
+
+void WriteMap(Writer& writer, const model::Map& map) {
+  writer.PutString(*map.GetId());
+  writer.PutString(map.GetName());
+  writer.Put(map.GetDefaultDogSpeed());
+  writer.Put(static_cast<std::uint64_t>(map.GetBagCapacity()));
+
+  writer.Put(static_cast<std::uint32_t>(map.GetLootValues().size()));
+  for (const int value : map.GetLootValues()) {
+    writer.Put(static_cast<std::int32_t>(value));
+  }
+  WriteOptional(writer, map.GetSpawnPolicy(),
+                [&writer](const auto& policy) { WriteSpawnPolicy(writer, policy); });
+  WriteOptional(writer, map.GetSessionCapacity(), [&writer](std::size_t capacity) {
+    writer.Put(static_cast<std::uint64_t>(capacity));
+  });
+
+  writer.Put(static_cast<std::uint32_t>(map.GetRoads().size()));
+  for (const auto& road : map.GetRoads()) {
+    for (const model::Coord coord :
+         {road.GetStart().x, road.GetStart().y, road.GetEnd().x, road.GetEnd().y}) {
+      writer.Put(static_cast<std::int32_t>(coord));
+    }
+  }
+
+  writer.Put(static_cast<std::uint32_t>(map.GetBuildings().size()));
+  for (const auto& building : map.GetBuildings()) {
+    const auto& bounds = building.GetBounds();
+    for (const model::Dimension value :
+         {bounds.position.x, bounds.position.y, bounds.size.width, bounds.size.height}) {
+      writer.Put(static_cast<std::int32_t>(value));
+    }
+  }
+
+  writer.Put(static_cast<std::uint32_t>(map.GetOffices().size()));
+  for (const auto& office : map.GetOffices()) {
+    writer.PutString(*office.GetId());
+    for (const model::Dimension value : {office.GetPosition().x, office.GetPosition().y,
+                                         office.GetOffset().dx, office.GetOffset().dy}) {
+      writer.Put(static_cast<std::int32_t>(value));
+    }
+  }
+}
+
+model::Map ReadMap(Reader& reader) {
+  model::Map::Id id{std::string(reader.GetString())};
+  model::Map map{std::move(id), std::string(reader.GetString())};
+  map.SetDefaultDogSpeed(reader.Get<double>());
+  map.SetBagCapacity(static_cast<int>(reader.Get<std::uint64_t>()));
+
+  // Размеры не используются для выделения памяти заранее: в повреждённом файле они
+  // могут оказаться любыми, а чтение за концом файла сразу остановит загрузку
+  std::vector<int> loot_values;
+  for (auto count = reader.Get<std::uint32_t>(); count > 0; --count) {
+    loot_values.push_back(reader.Get<std::int32_t>());
+  }
+  // Те же пределы рюкзака, что проверяет json_loader: кеш мог быть записан до их появления.
+  // Карта вне пределов делает кеш непригодным, и ошибку сообщит загрузка конфигурации.
+  if (map.GetBagCapacity() > model::Bag::MAX_CAPACITY ||
+      loot_values.size() > model::Bag::MAX_LOOT_TYPES) {
+    throw std::invalid_argument("Map " + *map.GetId() + " exceeds the bag limits");
+  }
+  map.SetLootValues(std::move(loot_values));
+  if (reader.Get<std::uint8_t>()) {
+    map.SetSpawnPolicy(ReadSpawnPolicy(reader));
+  }
+  if (reader.Get<std::uint8_t>()) {
+    map.SetSessionCapacity(reader.Get<std::uint64_t>());
+  }
+
+  for (auto count = reader.Get<std::uint32_t>(); count > 0; --count) {
+    const model::Point start{reader.Get<std::int32_t>(), reader.Get<std::int32_t>()};
+    const model::Point end{reader.Get<std::int32_t>(), reader.Get<std::int32_t>()};
+    if (start.y == end.y) {
+      map.AddRoad(model::Road{model::Road::HORIZONTAL, start, end.x});
+    } else {
+      map.AddRoad(model::Road{model::Road::VERTICAL, start, end.y});
+    }
+  }
+
+  for (auto count = reader.Get<std::uint32_t>(); count > 0; --count) {
+    const model::Point position{reader.Get<std::int32_t>(), reader.Get<std::int32_t>()};
+    const model::Size size{reader.Get<std::int32_t>(), reader.Get<std::int32_t>()};
+    map.AddBuilding(model::Building{{position, size}});
+  }
+
+  for (auto count = reader.Get<std::uint32_t>(); count > 0; --count) {
+    model::Office::Id office_id{std::string(reader.GetString())};
+    const model::Point position{reader.Get<std::int32_t>(), reader.Get<std::int32_t>()};
+    const model::Offset offset{reader.Get<std::int32_t>(), reader.Get<std::int32_t>()};
+    map.AddOffice(model::Office{std::move(office_id), position, offset});
+  }
+  return map;
+}
+
+void WriteGame(Writer& writer, const model::Game& game) {
+  const auto& settings = game.GetSettings();
+  writer.Put(settings.default_dog_speed_);
+  writer.Put(static_cast<std::int32_t>(settings.default_bag_capacity_));
+  writer.Put(settings.probability);
+  writer.Put(settings.period);
+  writer.Put(settings.dog_retirement_time);
+  writer.Put(static_cast<std::uint64_t>(settings.session_capacity));
+  writer.Put(settings.session_grace_period);
+  WriteSpawnPolicy(writer, game.GetDefaultSpawnPolicy());
+
+  writer.Put(static_cast<std::uint32_t>(game.GetMaps().size()));
+  for (const auto& map : game.GetMaps()) {
+    WriteMap(writer, map);
+  }
+}
+
+void ReadGame(Reader& reader, model::Game& game) {
+  auto& settings = game.GetSettings();
+  settings.default_dog_speed_ = reader.Get<double>();
+  settings.default_bag_capacity_ = reader.Get<std::int32_t>();
+  settings.probability = reader.Get<double>();
+  settings.period = reader.Get<double>();
+  settings.dog_retirement_time = reader.Get<double>();
+  settings.session_capacity = reader.Get<std::uint64_t>();
+  settings.session_grace_period = reader.Get<double>();
+  game.SetSpawnPolicy(ReadSpawnPolicy(reader));
+
+  for (auto count = reader.Get<std::uint32_t>(); count > 0; --count) {
+    game.AddMap(ReadMap(reader));
+  }
+}
+
+}  // namespace
+
+std::uint64_t HashFile(const fs::path& path) {
+  std::uint64_t hash = FNV_OFFSET;
+  // Пустой файл не отображается в память
+  if (fs::file_size(path) == 0) {
+    return hash;
+  }
+  const bip::file_mapping file(path.c_str(), bip::read_only);
+  const bip::mapped_region region(file, bip::read_only);
+  const auto* data = static_cast<const unsigned char*>(region.get_address());
+  for (std::size_t i = 0; i < region.get_size(); ++i) {
+    hash = (hash ^ data[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+void Save(const fs::path& cache_path, std::uint64_t config_hash, const model::Game& game,
+          const LootTypes& loot_types) {
+  Writer payload;
+  WriteGame(payload, game);
+  payload.Put(static_cast<std::uint32_t>(loot_types.size()));
+  for (const auto& [map_id, json] : loot_types) {
+    payload.PutString(*map_id);
+    payload.PutString(json);
+  }
+
+  Writer header;
+  for (const char c : MAGIC) {
+    header.Put(c);
+  }
+  header.Put(FORMAT_VERSION);
+  header.Put(config_hash);
+  header.Put(static_cast<std::uint64_t>(payload.GetData().size()));
+
+  const fs::path temp_path = cache_path.string() + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    out.write(header.GetData().data(), static_cast<std::streamsize>(header.GetData().size()));
+    out.write(payload.GetData().data(), static_cast<std::streamsize>(payload.GetData().size()));
+    if (!out.flush()) {
+      throw std::runtime_error("Failed to write map cache: " + temp_path.string());
+    }
+  }
+  fs::rename(temp_path, cache_path);
+}
+
+std::optional<Contents> Load(const fs::path& cache_path, std::uint64_t config_hash) {
+  std::error_code ec;
+  if (!fs::is_regular_file(cache_path, ec) || fs::file_size(cache_path, ec) == 0) {
+    return std::nullopt;
+  }
+
+  try {
+    const bip::file_mapping file(cache_path.c_str(), bip::read_only);
+    const bip::mapped_region region(file, bip::read_only);
+    Reader reader{{static_cast<const char*>(region.get_address()), region.get_size()}};
+
+    for (const char c : MAGIC) {
+      if (reader.Get<char>() != c) {
+        return std::nullopt;
+      }
+    }
+    if (reader.Get<std::uint32_t>() != FORMAT_VERSION ||
+        reader.Get<std::uint64_t>() != config_hash ||
+        reader.Get<std::uint64_t>() != region.get_size() - HEADER_SIZE) {
+      return std::nullopt;
+    }
+
+    Contents contents;
+    ReadGame(reader, contents.game);
+    for (auto count = reader.Get<std::uint32_t>(); count > 0; --count) {
+      model::Map::Id map_id{std::string(reader.GetString())};
+      contents.loot_types.emplace_back(std::move(map_id), std::string(reader.GetString()));
+    }
+    if (!reader.AtEnd()) {
+      return std::nullopt;
+    }
+    return contents;
+  } catch (const std::exception&) {
+    // Повреждённый кеш не ошибка: игра будет загружена из конфигурации
+    return std::nullopt;
+  }
+}
+
+}  // namespace map_cache
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "model.h"
+
+/*
+ * Двоичный кеш карт и настроек игры, собранных из файла конфигурации.
+ *
+ * Файл кеша отображается в память и читается полями фиксированного размера в порядке
+ * записи, без разбора текста. В заголовке хранятся версия формата и хеш содержимого
+ * конфигурации: кеш от другой конфигурации или другой сборки считается устаревшим.
+ * Числа пишутся в порядке байтов машины, поэтому кеш не переносится между архитектурами
+ * с разным порядком байтов - такой файл тоже окажется устаревшим.
+ */
+namespace map_cache {
+
+// Описания типов трофеев (lootTypes) карт в виде JSON-текста; они только отдаются клиентам
+using LootTypes = std::vector<std::pair<model::Map::Id, std::string>>;
+
+struct Contents {
+  model::Game game;
+  LootTypes loot_types;
+};
+
+// Хеш содержимого файла (FNV-1a, 64 бита)
+std::uint64_t HashFile(const std::filesystem::path& path);
+
+// Записывает кеш атомарно: во временный файл рядом, который затем переименовывается.
+// Сохраняются карты и настройки игры из конфигурации, но не сессии и не тикер.
+void Save(const std::filesystem::path& cache_path, std::uint64_t config_hash,
+          const model::Game& game, const LootTypes& loot_types);
+
+// nullopt, если файла нет, он собран для другой конфигурации или версии формата либо повреждён
+std::optional<Contents> Load(const std::filesystem::path& cache_path, std::uint64_t config_hash);
+
+}  // namespace map_cache
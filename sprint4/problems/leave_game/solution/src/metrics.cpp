@@ -0,0 +1,319 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace metrics {
+
+namespace detail {
+std::atomic<std::size_t> next_shard{0};
+}  // namespace detail
+
+//---------------------------Counter---------------------------
+
+std::uint64_t Counter::Value() const noexcept {
+  std::uint64_t total = 0;
+  for (const auto& cell : cells_) {
+    total += cell.value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+//---------------------------Histogram-------------------------
+
+Histogram::Snapshot Histogram::TakeSnapshot() const {
+  Snapshot snapshot;
+  snapshot.buckets.assign(BUCKETS, 0);
+  for (const auto& shard : shards_) {
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+      const auto value = shard.buckets[i].load(std::memory_order_relaxed);
+      snapshot.buckets[i] += value;
+      snapshot.count += value;
+    }
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+std::uint64_t Histogram::Snapshot::ValueAtQuantile(double q) const noexcept {
+  if (count == 0) {
+    return 0;
+  }
+  const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * count));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= std::max<std::uint64_t>(rank, 1)) {
+      return BucketUpperBound(i);
+    }
+  }
+  return BucketUpperBound(buckets.size() - 1);
+}
+
+std::uint64_t Histogram::Snapshot::CountAtOrBelow(std::uint64_t value) const noexcept {
+  std::uint64_t result = 0;
+  for (std::size_t i = 0; i < buckets.size() && BucketUpperBound(i) <= value; ++i) {
+    result += buckets[i];
+  }
+  return result;
+}
+
+void Histogram::Snapshot::Merge(const Snapshot& other) {
+  if (buckets.size() < other.buckets.size()) {
+    buckets.resize(other.buckets.size(), 0);
+  }
+  for (std::size_t i = 0; i < other.buckets.size(); ++i) {
+    buckets[i] += other.buckets[i];
+  }
+  count += other.count;
+  sum += other.sum;
+}
+
+HistogramOptions LatencyOptions() {
+  return {1e-9, {1e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1,
+                 0.25, 0.5, 1, 2.5, 5, 10}};
+}
+
+HistogramOptions CountOptions() {
+  return {1.0, {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000}};
+}
+
+//---------------------------Registry--------------------------
+
+namespace {
+
+std::string FormatLabels(const Labels& labels, std::string_view extra_name = {},
+                         std::string_view extra_value = {}) {
+  if (labels.empty() && extra_name.empty()) {
+    return {};
+  }
+  std::string result = "{";
+  auto append = [&result](std::string_view name, std::string_view value) {
+    if (result.size() > 1) {
+      result += ',';
+    }
+    result += name;
+    result += "=\"";
+    for (char c : value) {
+      if (c == '\\' || c == '"') {
+        result += '\\';
+        result += c;
+      } else if (c == '\n') {
+        result += "\\n";
+      } else {
+        result += c;
+      }
+    }
+    result += '"';
+  };
+  for (const auto& [name, value] : labels) {
+    append(name, value);
+  }
+  if (!extra_name.empty()) {
+    append(extra_name, extra_value);
+  }
+  result += '}';
+  return result;
+}
+
+std::string FormatDouble(double value) {
+  std::ostringstream out;
+  out.precision(9);
+  out << value;
+  return out.str();
+}
+
+}  // namespace
+
+Registry::Family& Registry::GetFamily(const std::string& name, const std::string& help,
+                                      Type type) {
+  auto [it, inserted] = families_.try_emplace(name);
+  if (inserted) {
+    it->second.help = help;
+    it->second.type = type;
+  } else if (it->second.type != type) {
+    throw std::invalid_argument("Metric " + name + " is registered with another type");
+  }
+  return it->second;
+}
+
+Counter& Registry::AddCounter(const std::string& name, const std::string& help, Labels labels) {
+  std::lock_guard lock{mutex_};
+  auto& series = GetFamily(name, help, Type::COUNTER).series.emplace_back();
+  series.labels = std::move(labels);
+  series.counter = std::make_unique<Counter>();
+  return *series.counter;
+}
+
+Gauge& Registry::AddGauge(const std::string& name, const std::string& help, Labels labels) {
+  std::lock_guard lock{mutex_};
+  auto& series = GetFamily(name, help, Type::GAUGE).series.emplace_back();
+  series.labels = std::move(labels);
+  series.gauge = std::make_unique<Gauge>();
+  return *series.gauge;
+}
+
+Histogram& Registry::AddHistogram(const std::string& name, const std::string& help,
+                                  const HistogramOptions& options, Labels labels) {
+  std::lock_guard lock{mutex_};
+  auto& family = GetFamily(name, help, Type::HISTOGRAM);
+  if (family.series.empty()) {
+    family.options = options;
+  }
+  auto& series = family.series.emplace_back();
+  series.labels = std::move(labels);
+  series.histogram = std::make_unique<Histogram>();
+  return *series.histogram;
+}
+
+std::string Registry::Serialize() const {
+  std::lock_guard lock{mutex_};
+  std::string out;
+
+  for (const auto& [name, family] : families_) {
+    out += "# HELP " + name + ' ' + family.help + '\n';
+    switch (family.type) {
+      case Type::COUNTER:
+        out += "# TYPE " + name + " counter\n";
+        for (const auto& series : family.series) {
+          out += name + FormatLabels(series.labels) + ' ' +
+                 std::to_string(series.counter->Value()) + '\n';
+        }
+        break;
+
+      case Type::GAUGE:
+        out += "# TYPE " + name + " gauge\n";
+        for (const auto& series : family.series) {
+          out += name + FormatLabels(series.labels) + ' ' +
+                 std::to_string(series.gauge->Value()) + '\n';
+        }
+        break;
+
+      case Type::HISTOGRAM:
+        out += "# TYPE " + name + " histogram\n";
+        for (const auto& series : family.series) {
+          const auto snapshot = series.histogram->TakeSnapshot();
+          const double scale = family.options.scale;
+          for (double bound : family.options.bounds) {
+            const auto raw_bound = static_cast<std::uint64_t>(bound / scale);
+            out += name + "_bucket" + FormatLabels(series.labels, "le", FormatDouble(bound)) +
+                   ' ' + std::to_string(snapshot.CountAtOrBelow(raw_bound)) + '\n';
+          }
+          out += name + "_bucket" + FormatLabels(series.labels, "le", "+Inf") + ' ' +
+                 std::to_string(snapshot.count) + '\n';
+          out += name + "_sum" + FormatLabels(series.labels) + ' ' +
+                 FormatDouble(static_cast<double>(snapshot.sum) * scale) + '\n';
+          out += name + "_count" + FormatLabels(series.labels) + ' ' +
+                 std::to_string(snapshot.count) + '\n';
+        }
+        break;
+    }
+  }
+
+  return out;
+}
+
+Registry& DefaultRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+//---------------------------RequestMetrics--------------------
+
+std::size_t RequestMetrics::Classify(std::string_view target) noexcept {
+  constexpr std::string_view MAP_PREFIX = "/api/v1/maps/";
+
+  const std::string_view path = target.substr(0, target.find('?'));
+  if (!path.starts_with("/api/") && path != "/metrics") {
+    return ENDPOINTS.size() - 1;
+  }
+  if (path.starts_with(MAP_PREFIX) && path.size() > MAP_PREFIX.size()) {
+    return 1;
+  }
+  for (std::size_t i = 0; i + 1 < ENDPOINTS.size(); ++i) {
+    if (ENDPOINTS[i] == path) {
+      return i;
+    }
+  }
+  // Неизвестные пути API учитываются вместе со статикой, чтобы
+  // произвольные URI не порождали новые ряды метрик
+  return ENDPOINTS.size() - 1;
+}
+
+void RequestMetrics::Record(std::size_t endpoint, unsigned status, Clock::duration latency) {
+  if (endpoint >= ENDPOINTS.size() || status >= MAX_STATUS) {
+    return;
+  }
+  Histogram* histogram = histograms_[endpoint][status].load(std::memory_order_acquire);
+  if (!histogram) {
+    histogram = &Create(endpoint, status);
+  }
+  histogram->Record(latency);
+}
+
+Histogram& RequestMetrics::Create(std::size_t endpoint, unsigned status) {
+  std::lock_guard lock{mutex_};
+  auto& slot = histograms_[endpoint][status];
+  if (Histogram* existing = slot.load(std::memory_order_relaxed)) {
+    return *existing;
+  }
+  Histogram& histogram = registry_.AddHistogram(
+      "http_request_duration_seconds", "HTTP request latency by endpoint and status",
+      LatencyOptions(),
+      {{"endpoint", std::string(ENDPOINTS[endpoint])}, {"status", std::to_string(status)}});
+  slot.store(&histogram, std::memory_order_release);
+  return histogram;
+}
+
+//---------------------------ServerMetrics---------------------
+
+namespace {
+
+Histogram& AddTickPhase(Registry& registry, const char* phase) {
+  return registry.AddHistogram("game_tick_phase_duration_seconds",
+                               "Duration of a game tick phase over all sessions",
+                               LatencyOptions(), {{"phase", phase}});
+}
+
+}  // namespace
+
+ServerMetrics::ServerMetrics(Registry& registry)
+    : tick_total(registry.AddHistogram("game_tick_duration_seconds", "Full game tick duration",
+                                       LatencyOptions()))
+    , tick_movement(AddTickPhase(registry, "movement"))
+    , tick_collisions(AddTickPhase(registry, "collisions"))
+    , tick_loot(AddTickPhase(registry, "loot"))
+    , tick_retirement(AddTickPhase(registry, "retirement"))
+    , tick_snapshot(AddTickPhase(registry, "snapshot"))
+    , tick_publish(AddTickPhase(registry, "publish"))
+    , tick_lateness(registry.AddHistogram("game_tick_lateness_seconds",
+                                          "Delay between a tick deadline and its start",
+                                          LatencyOptions()))
+    , tick_overruns(registry.AddCounter("game_tick_overruns_total",
+                                        "Fixed timestep ticks dropped by the catch-up limit"))
+    , strand_queue_depth(registry.AddGauge("game_strand_queue_depth",
+                                           "API requests waiting for the game strand"))
+    , sessions(registry.AddGauge("game_sessions", "Game sessions across all maps"))
+    , db_pool_wait(registry.AddHistogram("db_pool_wait_seconds",
+                                         "Time spent waiting for a DB connection",
+                                         LatencyOptions()))
+    , snapshot_duration(registry.AddHistogram("game_snapshot_duration_seconds",
+                                              "Time to save game state to file",
+                                              LatencyOptions()))
+    , session_dogs(registry.AddHistogram("game_session_dogs",
+                                         "Dogs per game session, sampled every tick",
+                                         CountOptions()))
+    , session_loot(registry.AddHistogram("game_session_loot",
+                                         "Lost objects per game session, sampled every tick",
+                                         CountOptions()))
+    , requests(registry) {
+}
+
+ServerMetrics& Server() {
+  static ServerMetrics server_metrics{DefaultRegistry()};
+  return server_metrics;
+}
+
+}  // namespace metrics
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace metrics {
+
+using Clock = std::chrono::steady_clock;
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+// Количество шардов у каждой метрики. Поток пишет только в свой шард,
+// поэтому потоки не борются за одну кэш-линию.
+inline constexpr std::size_t SHARDS = 16;
+// Последний шард общий для потоков, которым не хватило собственного
+inline constexpr std::size_t SHARED_SHARD = SHARDS - 1;
+
+namespace detail {
+extern std::atomic<std::size_t> next_shard;
+
+// У собственного шарда потока единственный писатель, поэтому достаточно
+// обычных чтения и записи без атомарного сложения
+inline void Increment(std::atomic<std::uint64_t>& cell, std::uint64_t value,
+                      std::size_t shard) noexcept {
+  if (shard != SHARED_SHARD) {
+    cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  } else {
+    cell.fetch_add(value, std::memory_order_relaxed);
+  }
+}
+}  // namespace detail
+
+// Номер шарда текущего потока, назначается при первом обращении
+inline std::size_t ThisThreadShard() noexcept {
+  thread_local const std::size_t shard =
+      std::min(detail::next_shard.fetch_add(1, std::memory_order_relaxed), SHARED_SHARD);
+  return shard;
+}
+
+class Counter {
+ public:
+  void Inc(std::uint64_t value = 1) noexcept {
+    const std::size_t shard = ThisThreadShard();
+    detail::Increment(cells_[shard].value, value, shard);
+  }
+
+  std::uint64_t Value() const noexcept;
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<std::uint64_t> value{0};
+  };
+  std::array<Cell, SHARDS> cells_;
+};
+
+class Gauge {
+ public:
+  void Set(std::int64_t value) noexcept {
+    value_.store(value, std::memory_order_relaxed);
+  }
+
+  void Add(std::int64_t delta) noexcept {
+    value_.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  std::int64_t Value() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::int64_t> value_{0};
+};
+
+/*
+ * Гистограмма в духе HdrHistogram: значения от 0 до 2^40 раскладываются
+ * по логарифмическим интервалам, каждый из которых поделён на 16 равных частей.
+ * Относительная погрешность не превышает 1/16, запись значения - это
+ * вычисление номера корзины и два сложения в шарде потока.
+ */
+class Histogram {
+ public:
+  static constexpr unsigned SUB_BUCKET_BITS = 4;
+  static constexpr std::uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static constexpr unsigned MAX_EXPONENT = 40;
+  static constexpr std::size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  struct Snapshot {
+    std::vector<std::uint64_t> buckets;
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+
+    // Значение, не меньше которого оказалась доля q (от 0 до 1) записей
+    std::uint64_t ValueAtQuantile(double q) const noexcept;
+    // Количество записей со значением не больше value
+    std::uint64_t CountAtOrBelow(std::uint64_t value) const noexcept;
+    void Merge(const Snapshot& other);
+  };
+
+  static constexpr std::size_t BucketIndex(std::uint64_t value) noexcept {
+    if (value < SUB_BUCKETS) {
+      return static_cast<std::size_t>(value);
+    }
+    const unsigned exponent = 63 - std::countl_zero(value);
+    if (exponent >= MAX_EXPONENT) {
+      return BUCKETS - 1;
+    }
+    const unsigned shift = exponent - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+  }
+
+  // Наименьшее значение, попадающее в корзину
+  static constexpr std::uint64_t BucketLowerBound(std::size_t index) noexcept {
+    if (index < SUB_BUCKETS) {
+      return index;
+    }
+    const std::size_t shift = index / SUB_BUCKETS - 1;
+    return (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+  }
+
+  // Наибольшее значение, попадающее в корзину
+  static constexpr std::uint64_t BucketUpperBound(std::size_t index) noexcept {
+    if (index < SUB_BUCKETS) {
+      return index;
+    }
+    const std::size_t shift = index / SUB_BUCKETS - 1;
+    return ((SUB_BUCKETS + index % SUB_BUCKETS + 1) << shift) - 1;
+  }
+
+  void Record(std::uint64_t value) noexcept {
+    const std::size_t index = ThisThreadShard();
+    Shard& shard = shards_[index];
+    detail::Increment(shard.buckets[BucketIndex(value)], 1, index);
+    detail::Increment(shard.sum, value, index);
+  }
+
+  void Record(Clock::duration duration) noexcept {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    Record(static_cast<std::uint64_t>(ns > 0 ? ns : 0));
+  }
+
+  Snapshot TakeSnapshot() const;
+
+ private:
+  struct alignas(64) Shard {
+    std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+    std::atomic<std::uint64_t> sum{0};
+  };
+  std::array<Shard, SHARDS> shards_;
+};
+
+// Записывает в гистограмму время жизни объекта в наносекундах
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram& histogram) noexcept
+      : histogram_(histogram), start_(Clock::now()) {
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  ~ScopedTimer() {
+    histogram_.Record(Clock::now() - start_);
+  }
+
+ private:
+  Histogram& histogram_;
+  Clock::time_point start_;
+};
+
+struct HistogramOptions {
+  // Множитель, переводящий записанные значения в единицы экспорта
+  // (например, 1e-9 для наносекунд, экспортируемых в секундах)
+  double scale = 1.0;
+  // Границы корзин le в единицах экспорта
+  std::vector<double> bounds;
+};
+
+// Границы для длительностей, записанных в наносекундах: от 10 мкс до 10 с
+HistogramOptions LatencyOptions();
+// Границы для количеств: от 1 до 10000
+HistogramOptions CountOptions();
+
+/*
+ * Реестр метрик. Регистрация и экспорт защищены мьютексом,
+ * запись в метрики идёт напрямую через полученные ссылки.
+ * Адреса метрик стабильны всё время жизни реестра.
+ */
+class Registry {
+ public:
+  Counter& AddCounter(const std::string& name, const std::string& help, Labels labels = {});
+  Gauge& AddGauge(const std::string& name, const std::string& help, Labels labels = {});
+  Histogram& AddHistogram(const std::string& name, const std::string& help,
+                          const HistogramOptions& options, Labels labels = {});
+
+  // Текстовый формат экспорта Prometheus (version 0.0.4)
+  std::string Serialize() const;
+
+ private:
+  enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+  struct Series {
+    Labels labels;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+  };
+
+  struct Family {
+    std::string help;
+    Type type;
+    HistogramOptions options;
+    std::vector<Series> series;
+  };
+
+  Family& GetFamily(const std::string& name, const std::string& help, Type type);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Family> families_;
+};
+
+Registry& DefaultRegistry();
+
+/*
+ * Гистограммы времени ответа по эндпоинту и коду статуса.
+ * Гистограмма для пары создаётся при первом запросе, дальше
+ * запись идёт без блокировок.
+ */
+class RequestMetrics {
+ public:
+  static constexpr std::array<std::string_view, 10> ENDPOINTS = {
+      "/api/v1/maps",        "/api/v1/maps/{id}",          "/api/v1/game/join",
+      "/api/v1/game/players", "/api/v1/game/state",         "/api/v1/game/player/action",
+      "/api/v1/game/tick",    "/api/v1/game/records",       "/metrics",
+      "static"};
+  static constexpr std::size_t MAX_STATUS = 600;
+
+  explicit RequestMetrics(Registry& registry) : registry_(registry) {
+  }
+
+  // Номер эндпоинта для URI запроса
+  static std::size_t Classify(std::string_view target) noexcept;
+
+  void Record(std::size_t endpoint, unsigned status, Clock::duration latency);
+
+ private:
+  Histogram& Create(std::size_t endpoint, unsigned status);
+
+  Registry& registry_;
+  std::mutex mutex_;
+  std::array<std::array<std::atomic<Histogram*>, MAX_STATUS>, ENDPOINTS.size()> histograms_{};
+};
+
+// Метрики игрового сервера в реестре по умолчанию
+struct ServerMetrics {
+  explicit ServerMetrics(Registry& registry);
+
+  Histogram& tick_total;
+  Histogram& tick_movement;
+  Histogram& tick_collisions;
+  Histogram& tick_loot;
+  Histogram& tick_retirement;
+  Histogram& tick_snapshot;
+  Histogram& tick_publish;
+  Histogram& tick_lateness;
+  Counter& tick_overruns;
+  Gauge& strand_queue_depth;
+  Gauge& sessions;
+  Histogram& db_pool_wait;
+  Histogram& snapshot_duration;
+  Histogram& session_dogs;
+  Histogram& session_loot;
+  RequestMetrics requests;
+};
+
+ServerMetrics& Server();
+
+}  // namespace metrics
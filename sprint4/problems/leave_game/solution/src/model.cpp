@@ -1,6 +1,8 @@
 #include "model.h"
 #include "move_info.h"
 
+#include <algorithm>
+#include <cassert>
 #include <chrono>
 #include <stdexcept>
 
@@ -33,6 +35,10 @@ const Map::Offices& Map::GetOffices() const noexcept {
 }
 
 void Map::AddRoad(const Road& road) {
+  const Point start = road.GetStart();
+  const Point end = road.GetEnd();
+  road_graph_.AddRoad({static_cast<double>(start.x), static_cast<double>(start.y)},
+                      {static_cast<double>(end.x), static_cast<double>(end.y)});
   roads_.emplace_back(road);
 }
 
@@ -67,18 +73,22 @@ bool Map::IsDefaultDogSpeedValueConfigured() const {
   return default_dog_speed_ != 1;
 }
 
+bool Map::operator==(const Map& other) const {
+  return id_ == other.id_ && name_ == other.name_ && roads_ == other.roads_ &&
+         buildings_ == other.buildings_ && offices_ == other.offices_ &&
+         default_dog_speed_ == other.default_dog_speed_ && loot_values_ == other.loot_values_ &&
+         spawn_policy_ == other.spawn_policy_ && session_capacity_ == other.session_capacity_ &&
+         bag_capacity_ == other.bag_capacity_;
+}
+
 //****************************************************************
 //------------------------------Dog--------------------------------
 
-Dog::Dog(std::string_view name, size_t bag_capacity)
-    : name_(name), id_(boost::hash<std::string>()(std::string(name))), bag_(bag_capacity) {
+Dog::Dog(std::string_view name, size_t bag_capacity) : name_(name), bag_(bag_capacity) {
 }
 
 Dog::Dog(std::string_view name, MoveInfo state, size_t bag_capacity)
-    : name_(name),
-      id_(boost::hash<std::string>()(std::string(name))),
-      state_(std::move(state)),
-      bag_(bag_capacity) {
+    : name_(name), state_(std::move(state)), bag_(bag_capacity) {
 }
 
 Dog::Dog(std::string_view name, size_t dog_id, MoveInfo state, size_t bag_capacity)
@@ -86,7 +96,7 @@ Dog::Dog(std::string_view name, size_t dog_id, MoveInfo state, size_t bag_capaci
 }
 
 const std::string& Dog::GetName() const {
-  return name_;
+  return name_.Get();
 }
 
 const MoveInfo::Position& Dog::GetPosition() const noexcept {
@@ -105,37 +115,29 @@ const MoveInfo& Dog::GetState() const noexcept {
   return state_;
 }
 
-void Dog::SetDefaultDogSpeed(double speed) {
-  default_dog_speed_ = speed;
-}
-
 void Dog::SetDogSpeed(double x, double y) {
   state_.speed.x = x;
   state_.speed.y = y;
 }
 
-void Dog::SetDogDirSpeed(std::string dir) {
+void Dog::SetDogDirSpeed(std::string_view dir, double speed) {
   if (dir == "") {
     SetDogSpeed(0, 0);
   } else if (dir == "L") {
-    SetDogSpeed(-default_dog_speed_, 0);
+    SetDogSpeed(-speed, 0);
     state_.direction = MoveInfo::Direction::WEST;
   } else if (dir == "R") {
-    SetDogSpeed(default_dog_speed_, 0);
+    SetDogSpeed(speed, 0);
     state_.direction = MoveInfo::Direction::EAST;
   } else if (dir == "U") {
-    SetDogSpeed(0, -default_dog_speed_);
+    SetDogSpeed(0, -speed);
     state_.direction = MoveInfo::Direction::NORTH;
   } else if (dir == "D") {
-    SetDogSpeed(0, default_dog_speed_);
+    SetDogSpeed(0, speed);
     state_.direction = MoveInfo::Direction::SOUTH;
   }
 }
 
-const double Dog::GetDefaultDogSpeed() const {
-  return default_dog_speed_;
-}
-
 void Dog::StopDog() {
   SetDogSpeed(0, 0);
 }
@@ -167,32 +169,118 @@ void Dog::AddScore(int value) {
 //************************************************************
 //---------------------------GameSession----------------------
 
-GameSession::GameSession(const Map& map) : map_(map), id_(GenerateId()) {
-  InitializeRegions();
+GameSession::GameSession(std::shared_ptr<const Map> map)
+    : map_(std::move(map)), id_(GenerateId()) {
 }
 
-GameSession::GameSession(Dogs dogs, const Map& map, Id id, std::vector<Loot> loots)
-    : dogs_(std::move(dogs)), map_(map), id_(std::move(id)), loots_(std::move(loots)) {
-  InitializeRegions();
+GameSession::GameSession(const Map& map)
+    // Указатель без владения: за время жизни карты отвечает вызывающий
+    : GameSession(std::shared_ptr<const Map>(std::shared_ptr<const Map>{}, &map)) {
+}
+
+GameSession::GameSession(std::vector<Dog> dogs, std::shared_ptr<const Map> map, Id id,
+                         std::vector<Loot> loots, util::IdAllocator dog_ids)
+    : map_(std::move(map)), id_(std::move(id)), dog_ids_(std::move(dog_ids)) {
+  dogs_.reserve(dogs.size());
+  dog_keys_.resize(dog_ids_.GetNextId());
+  for (auto& dog : dogs) {
+    const Dog::Id dog_id = dog.GetId();
+    if (dog_id >= dog_keys_.size() || dog_keys_[dog_id]) {
+      throw std::invalid_argument("Invalid or duplicate dog id "s + std::to_string(dog_id));
+    }
+    dog_grid_.Insert(static_cast<util::SpatialGrid::Id>(dog_id), ToPoint(dog.GetPosition()));
+    dog_keys_[dog_id] = dogs_.Insert(std::move(dog));
+  }
+  for (const auto free_id : dog_ids_.GetFreeIds()) {
+    if (dog_keys_[free_id]) {
+      throw std::invalid_argument("Dog id "s + std::to_string(free_id) + " is both used and free"s);
+    }
+  }
+  loots_.reserve(loots.size());
+  for (const auto& loot : loots) {
+    InsertLoot(loot);
+  }
 }
 
 Map::Id GameSession::GetMapId() const {
-  return map_.GetId();
+  return map_->GetId();
+}
+
+void GameSession::RebindMap(std::shared_ptr<const Map> map) {
+  assert(*map == *map_);
+  map_ = std::move(map);
+}
+
+void GameSession::MigrateToMap(std::shared_ptr<const Map> map) {
+  assert(map->GetId() == map_->GetId());
+  map_ = std::move(map);
+  const auto& road_graph = map_->GetRoadGraph();
+
+  for (auto& dog : dogs_) {
+    // Сегмент ищется по позиции на первом шаге, как после восстановления из снимка
+    dog.SetRoadSegment(road_graph::NO_SEGMENT);
+    if (road_graph.FindSegment(ToPoint(dog.GetPosition())) == road_graph::NO_SEGMENT) {
+      dog.MoveDog(FindStartingPosition());
+      dog.StopDog();
+      dog_grid_.Update(static_cast<util::SpatialGrid::Id>(dog.GetId()), ToPoint(dog.GetPosition()));
+    }
+    dog.SetBagCapacity(map_->GetBagCapacity());
+  }
+
+  const auto& loot_values = map_->GetLootValues();
+  std::vector<LootId> lost;
+  for (size_t i = 0; i < loots_.size(); ++i) {
+    Loot& loot = loots_[i];
+    if (loot.type >= loot_values.size() ||
+        road_graph.FindSegment(ToPoint(loot.position)) == road_graph::NO_SEGMENT) {
+      lost.push_back(loots_.KeyAt(i));
+    } else {
+      loot.value = loot_values[loot.type];
+    }
+  }
+  for (const auto loot_id : lost) {
+    EraseLoot(loot_id);
+  }
 }
 
-void GameSession::AddDog(std::shared_ptr<Dog> dog) {
-  auto start = FindStartingPosition();
-  dog->MoveDog(start);
+Dog& GameSession::AddDog(Dog dog) {
+  dog.MoveDog(FindStartingPosition());
+
+  const Dog::Id dog_id = dog_ids_.Allocate();
+  dog.id_ = dog_id;
+  if (dog_id >= dog_keys_.size()) {
+    dog_keys_.resize(dog_id + 1);
+  }
 
-  dogs_.insert({dog->GetId(), dog});
+  dog_grid_.Insert(static_cast<util::SpatialGrid::Id>(dog_id), ToPoint(dog.GetPosition()));
+  const auto key = dogs_.Insert(std::move(dog));
+  dog_keys_[dog_id] = key;
+  return *dogs_.Find(key);
 }
 
 const GameSession::Dogs& GameSession::GetDogs() const {
   return dogs_;
 }
 
-bool GameSession::HasDog(Dog::Id id) {
-  return dogs_.count(id) > 0;
+bool GameSession::HasDog(Dog::Id id) const {
+  return id < dog_keys_.size() && dog_keys_[id].has_value();
+}
+
+Dog* GameSession::FindDog(Dog::Id dog_id) {
+  return HasDog(dog_id) ? dogs_.Find(*dog_keys_[dog_id]) : nullptr;
+}
+
+const Dog* GameSession::FindDog(Dog::Id dog_id) const {
+  return HasDog(dog_id) ? dogs_.Find(*dog_keys_[dog_id]) : nullptr;
+}
+
+void GameSession::DeleteDog(Dog::Id dog_id) {
+  if (HasDog(dog_id)) {
+    dogs_.Erase(*dog_keys_[dog_id]);
+    dog_keys_[dog_id].reset();
+    dog_grid_.Erase(static_cast<util::SpatialGrid::Id>(dog_id));
+    dog_ids_.Release(static_cast<util::IdAllocator::Id>(dog_id));
+  }
 }
 
 const GameSession::Id GameSession::GetSessionId() const {
@@ -201,8 +289,8 @@ const GameSession::Id GameSession::GetSessionId() const {
 
 const std::vector<std::string> GameSession::GetPlayersNames() const {
   std::vector<std::string> names;
-  for (const auto& [dog_id, dog] : dogs_) {
-    names.push_back(dog->GetName());
+  for (const auto& dog : dogs_) {
+    names.push_back(dog.GetName());
   }
 
   return names;
@@ -210,60 +298,105 @@ const std::vector<std::string> GameSession::GetPlayersNames() const {
 
 const std::vector<MoveInfo> GameSession::GetPlayersUnitStates() const {
   std::vector<MoveInfo> dogs;
-  for (const auto& [dog_id, dog] : dogs_) {
-    dogs.push_back(dog->GetState());
+  for (const auto& dog : dogs_) {
+    dogs.push_back(dog.GetState());
   }
 
   return dogs;
 }
 
 double GameSession::GetMapDefaultSpeed() const {
-  return map_.GetDefaultDogSpeed();
+  return map_->GetDefaultDogSpeed();
 }
 
 void GameSession::MovePlayer(Dog::Id id, double delta_time) {
-  auto& dog = dogs_[id];
-  auto new_position = CalculateNewPosition(dog->GetPosition(), dog->GetSpeed(), delta_time);
+  if (Dog* dog = FindDog(id)) {
+    MoveDog(*dog, delta_time);
+  }
+}
 
-  if (IsWithinAnyRegion(new_position, regions_)) {
-    dog->MoveDog(new_position);
-  } else {
-    MoveInfo::Position max_pos = AdjustPositionToMaxRegion(dog);
-    dog->MoveDog(max_pos);
-    dog->StopDog();
+void GameSession::MoveDog(Dog& dog, double delta_time) {
+  const MoveInfo::Speed& speed = dog.GetSpeed();
+  const auto result = map_->GetRoadGraph().Move(
+      ToPoint(dog.GetPosition()), dog.GetRoadSegment(),
+      {speed.x * delta_time, speed.y * delta_time});
+
+  dog.MoveDog({result.position.x, result.position.y});
+  dog.SetRoadSegment(result.segment);
+  if (result.stopped) {
+    dog.StopDog();
+  }
+
+  dog_grid_.Update(static_cast<util::SpatialGrid::Id>(dog.GetId()), ToPoint(dog.GetPosition()));
+}
+
+GameSession::LootId GameSession::InsertLoot(const Loot& loot) {
+  const LootId loot_id = loots_.Insert(loot);
+  loot_grid_.Insert(loot_id.index, ToPoint(loot.position));
+  return loot_id;
+}
+
+void GameSession::EraseLoot(LootId loot_id) {
+  if (loots_.Erase(loot_id)) {
+    loot_grid_.Erase(loot_id.index);
   }
 }
 
 void GameSession::StopPlayer(Dog::Id id) {
-  if (HasDog(id)) {
-    dogs_.at(id)->StopDog();
+  if (Dog* dog = FindDog(id)) {
+    dog->StopDog();
   }
 }
 
 void GameSession::ProcessCollisions(double delta_time) {
-  GameItemGathererProvider provider(*this, delta_time);
-  auto events = collision_detector::FindGatherEvents(provider);
+  // Трофеи и собаки нумеруются по позиции в хранилищах, сначала идут трофеи, затем базы.
+  // Номера предметов в событиях относятся к порядку трофеев до начала сбора,
+  // а удаление трофея этот порядок меняет. Поэтому запоминаем ключи заранее.
+  const auto& offices = map_->GetOffices();
+  collision_items_.Clear();
+  collision_items_.Reserve(loots_.size() + offices.size());
+  auto& loot_ids = collision_loot_ids_;
+  loot_ids.clear();
+  for (size_t i = 0; i < loots_.size(); ++i) {
+    collision_items_.Add({ToPoint(loots_[i].position), LOOT_WIDTH});
+    loot_ids.push_back(loots_.KeyAt(i));
+  }
+  for (const auto& office : offices) {
+    const Point position = office.GetPosition();
+    collision_items_.Add(
+        {{static_cast<double>(position.x), static_cast<double>(position.y)}, OFFICE_WIDTH});
+  }
 
-  std::sort(events.begin(), events.end(),
-            [](const auto& e1, const auto& e2) { return e1.time < e2.time; });
+  collision_gatherers_.Clear();
+  collision_gatherers_.Reserve(dogs_.size());
+  for (size_t i = 0; i < dogs_.size(); ++i) {
+    const MoveInfo& state = dogs_[i].GetState();
+    collision_gatherers_.Add({ToPoint(state.position),
+                              {state.position.x + state.speed.x * delta_time,
+                               state.position.y + state.speed.y * delta_time},
+                              DOG_WIDTH});
+  }
 
-  for (const auto& event : events) {
-    auto dog_it = dogs_.find(static_cast<Dog::Id>(event.gatherer_id));
-    if (dog_it == dogs_.end())
-      continue;
+  // События уже упорядочены по времени
+  const auto events =
+      collision_detector::FindGatherEvents(collision_items_.View(), collision_gatherers_.View());
 
-    auto& dog = dog_it->second;
+  for (const auto& event : events) {
+    // Собаки во время сбора не добавляются и не удаляются, номер события совпадает с позицией
+    Dog* dog = &dogs_[event.gatherer_id];
     auto& bag = dog->GetBag();
 
-    if (event.item_id < loots_.size()) {
-      // Сбор предмета
-      if (!bag.IsFull()) {
-        bag.AddLoot(loots_[event.item_id].type);
-        loots_.erase(loots_.begin() + event.item_id);
+    if (event.item_id < loot_ids.size()) {
+      // Сбор предмета. Трофей достаётся первой собаке, остальные найдут его удалённым.
+      const auto loot_id = loot_ids[event.item_id];
+      const Loot* loot = loots_.Find(loot_id);
+      if (loot && !bag.IsFull()) {
+        bag.AddLoot(loot->type);
+        EraseLoot(loot_id);
       }
     } else {
       // Сдача предметов на базу
-      const auto& loot_values = map_.GetLootValues();
+      const auto& loot_values = map_->GetLootValues();
       for (size_t loot_type : bag.GetItems()) {
         if (loot_type < loot_values.size()) {
           dog->AddScore(loot_values[loot_type]);  // Начисляем очки собаке
@@ -276,59 +409,24 @@ void GameSession::ProcessCollisions(double delta_time) {
 
 void GameSession::Tick(double delta_time) {
   // Сначала перемещаем всех игроков
-  for (auto& [id, dog] : dogs_) {
-    MovePlayer(id, delta_time);
-  }
+  MoveDogs(delta_time);
 
   // Затем обрабатываем коллизии
   ProcessCollisions(delta_time);
 }
 
-void GameSession::InitializeRegions() {
-  for (const auto& road : map_.GetRoads()) {
-    if (road.IsHorizontal()) {
-      double left_x = road.GetStart().x;
-      double right_x = road.GetEnd().x;
-      if (left_x > right_x) {
-        std::swap(left_x, right_x);
-      }
-      regions_.emplace(regions_.size(), Region{left_x - 0.4, right_x + 0.4, road.GetStart().y - 0.4,
-                                               road.GetStart().y + 0.4});
-    } else if (road.IsVertical()) {
-      double lower_y = road.GetStart().y;
-      double upper_y = road.GetEnd().y;
-      if (lower_y > upper_y) {
-        std::swap(lower_y, upper_y);
-      }
-      regions_.emplace(regions_.size(), Region{road.GetStart().x - 0.4, road.GetStart().x + 0.4,
-                                               lower_y - 0.4, upper_y + 0.4});
-    }
-  }
-}
-
-MoveInfo::Position GameSession::CalculateNewPosition(const MoveInfo::Position& position,
-                                                     const MoveInfo::Speed& speed,
-                                                     double delta_time) {
-  MoveInfo::Position result{};
-
-  result.x = position.x + speed.x * delta_time;
-  result.y = position.y + speed.y * delta_time;
-
-  return result;
+void GameSession::UpdateEmptyTime(double delta_time) {
+  empty_time_ = dogs_.empty() ? empty_time_ + delta_time : 0;
 }
 
-bool GameSession::IsWithinAnyRegion(const MoveInfo::Position& pos,
-                                    const std::unordered_map<int, Region>& regions) {
-  for (const auto& [id, region] : regions) {
-    if (region.Contains(pos)) {
-      return true;
-    }
+void GameSession::MoveDogs(double delta_time) {
+  for (auto& dog : dogs_) {
+    MoveDog(dog, delta_time);
   }
-  return false;
 }
 
 MoveInfo::Position GameSession::FindStartingPosition() const {
-  const auto& roads = map_.GetRoads();
+  const auto& roads = map_->GetRoads();
   if (roads.empty()) {
     return {0.0, 0.0};
   }
@@ -339,71 +437,19 @@ MoveInfo::Position GameSession::FindStartingPosition() const {
   return MoveInfo::Position{static_cast<double>(start.x), static_cast<double>(start.y)};
 }
 
-MoveInfo::Position GameSession::AdjustPositionToMaxRegion(const std::shared_ptr<Dog>& dog) {
-  MoveInfo::Position max_pos = dog->GetPosition();
-  double max_diff = 0;
-
-  for (const auto& [region_id, region] : regions_) {
-    if (region.Contains(dog->GetPosition())) {
-      MoveInfo::Position possible_max_pos =
-          MaxValueOfRegion(region, dog->GetDirection(), dog->GetPosition());
-      MoveInfo::Position max_distance_pos =
-          MoveOnMaxDistance(dog->GetPosition(), possible_max_pos, max_diff);
-
-      double dx = max_distance_pos.x - dog->GetPosition().x;
-      double dy = max_distance_pos.y - dog->GetPosition().y;
-      double distance = std::sqrt(dx * dx + dy * dy);
-
-      if (distance > max_diff) {
-        max_diff = distance;
-        max_pos = max_distance_pos;
-      }
-    }
-  }
-
-  return max_pos;
-}
-
-MoveInfo::Position GameSession::MaxValueOfRegion(Region reg, MoveInfo::Direction dir,
-                                                 MoveInfo::Position current_pos) {
-  MoveInfo::Position result = current_pos;
-  if (dir == MoveInfo::Direction::EAST) {
-    result.x = reg.max_x;
-  } else if (dir == MoveInfo::Direction::WEST) {
-    result.x = reg.min_x;
-  } else if (dir == MoveInfo::Direction::SOUTH) {
-    result.y = reg.max_y;
-  } else if (dir == MoveInfo::Direction::NORTH) {
-    result.y = reg.min_y;
-  }
-
-  return result;
-}
-
-MoveInfo::Position GameSession::MoveOnMaxDistance(const MoveInfo::Position& current,
-                                                  const MoveInfo::Position& possible,
-                                                  double current_max) {
-  double dx = current.x - possible.x;
-  double dy = current.y - possible.y;
-  double dist = std::sqrt(dx * dx + dy * dy);
-
-  if (dist > current_max) {
-    return possible;
-  }
-
-  return current;
-}
-
 //***********************************************************
 //--------------------------Game----------------------------
 
 void Game::AddMap(Map map) {
-  const size_t index = maps_.size();
+  const size_t index = maps_->size();
   if (auto [it, inserted] = map_id_to_index_.emplace(map.GetId(), index); !inserted) {
     throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
   } else {
     try {
-      maps_.emplace_back(std::move(map));
+      if (maps_.use_count() > 1) {
+        maps_ = std::make_shared<Maps>(*maps_);
+      }
+      maps_->emplace_back(std::move(map));
     } catch (...) {
       map_id_to_index_.erase(it);
       throw;
@@ -412,20 +458,64 @@ void Game::AddMap(Map map) {
 }
 
 const Game::Maps& Game::GetMaps() const noexcept {
-  return maps_;
+  return *maps_;
 }
 
-std::shared_ptr<GameSession> Game::FindGameSession(Map::Id map_id) {
-  if (!FindMap(map_id)) {
+std::shared_ptr<const Map> Game::GetMapPtr(size_t index) const {
+  return {maps_, &(*maps_)[index]};
+}
+
+Game::MapsReload Game::ReloadMaps(Game&& loaded) {
+  maps_ = std::move(loaded.maps_);
+  map_id_to_index_ = std::move(loaded.map_id_to_index_);
+  spawn_policy_ = loaded.spawn_policy_;
+
+  MapsReload result;
+  for (const auto& session : sessions_) {
+    const auto it = map_id_to_index_.find(session->GetMapId());
+    if (it == map_id_to_index_.end()) {
+      // Сессия доигрывается на прежней карте, новые игроки в неё не попадают
+      ++result.retired;
+      continue;
+    }
+
+    auto map = GetMapPtr(it->second);
+    if (*map == session->GetMap()) {
+      session->RebindMap(std::move(map));
+      ++result.kept;
+    } else {
+      session->MigrateToMap(std::move(map));
+      ++result.migrated;
+    }
+    session->GetSpawnState().policy = GetSpawnPolicy(session->GetMap());
+  }
+  return result;
+}
+
+std::shared_ptr<GameSession> Game::FindSessionForJoin(const Map::Id& map_id) {
+  const Map* map = FindMap(map_id);
+  if (!map) {
     return nullptr;
   }
 
-  auto it = map_id_to_session_id_.find(map_id);
-  if (it != map_id_to_session_id_.end()) {
-    return FindGameSessionBySessionId(it->second);
+  // Новые игроки дополняют самую заполненную сессию: так сессий остаётся
+  // как можно меньше, а лишние быстрее пустеют и удаляются
+  const size_t capacity = GetSessionCapacity(*map);
+  std::shared_ptr<GameSession> best;
+  if (auto it = map_id_to_session_ids_.find(map_id); it != map_id_to_session_ids_.end()) {
+    for (const auto session_id : it->second) {
+      auto session = FindGameSession(session_id);
+      const size_t dogs = session->GetDogs().size();
+      if (capacity != 0 && dogs >= capacity) {
+        continue;
+      }
+      if (!best || dogs > best->GetDogs().size()) {
+        best = std::move(session);
+      }
+    }
   }
 
-  return CreateGameSession(map_id);
+  return best ? best : CreateGameSession(map_id);
 }
 
 std::shared_ptr<GameSession> Game::CreateGameSession(Map::Id map_id) {
@@ -434,15 +524,17 @@ std::shared_ptr<GameSession> Game::CreateGameSession(Map::Id map_id) {
     return nullptr;
   }
 
-  const Map& map = maps_[map_it->second];
+  auto map = GetMapPtr(map_it->second);
   auto session = std::make_shared<GameSession>(map);
   GameSession::Id session_id = session->GetSessionId();
 
   game_sessions_id_to_index_[session_id] = sessions_.size();
   sessions_.push_back(session);
-  map_id_to_session_id_[map_id] = session_id;
+  map_id_to_session_ids_[map_id].push_back(session_id);
 
   session->SetRandomSpawnMode(settings_.random_spawn);
+  session->GetSpawnState().policy = GetSpawnPolicy(*map);
+  session->SeedRandom(session_seeds_());
 
   return session;
 }
@@ -453,7 +545,14 @@ const Game::GameSessions& Game::GetGameSessions() const {
 
 const Map* Game::FindMap(const Map::Id& id) const noexcept {
   if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end()) {
-    return &maps_.at(it->second);
+    return &maps_->at(it->second);
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const Map> Game::FindSharedMap(const Map::Id& id) const {
+  if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end()) {
+    return GetMapPtr(it->second);
   }
   return nullptr;
 }
@@ -474,8 +573,33 @@ Game::Settings& Game::GetSettings() {
 }
 
 void Game::SetLootGeneratorConfig(double period, double probability) {
-  loot_generator_ = std::make_unique<loot_gen::LootGenerator>(
-      std::chrono::milliseconds(static_cast<int>(period * 1000)), probability);
+  SetSpawnPolicy(loot_gen::SpawnPolicy::Rate(std::chrono::duration<double>(period), probability));
+}
+
+void Game::SetSpawnPolicy(loot_gen::SpawnPolicy policy) {
+  spawn_policy_ = policy;
+}
+
+void Game::SetRandomSeed(std::uint64_t seed) {
+  spawn_random_.seed(static_cast<std::mt19937::result_type>(seed));
+  session_seeds_.seed(seed);
+}
+
+size_t Game::GetSessionCapacity(const Map& map) const {
+  return map.GetSessionCapacity().value_or(settings_.session_capacity);
+}
+
+loot_gen::SpawnPolicy Game::GetSpawnPolicy(const Map& map) const {
+  return map.GetSpawnPolicy().value_or(spawn_policy_);
+}
+
+double Game::GetSpawnRandom(const loot_gen::SpawnPolicy& policy) {
+  // Для RATE и CAPPED множитель равен 1, как у LootGenerator по умолчанию:
+  // появление трофеев зависит только от времени и остаётся предсказуемым
+  if (policy.kind != loot_gen::SpawnPolicy::Kind::BURST) {
+    return 1.0;
+  }
+  return std::uniform_real_distribution<double>{0.0, 1.0}(spawn_random_);
 }
 
 void Game::SetDefaultBagCapacity(int capacity) {
@@ -486,7 +610,7 @@ int Game::GetDefaultBagCapacity() const {
   return settings_.default_bag_capacity_;
 }
 
-std::shared_ptr<GameSession> Game::FindGameSessionBySessionId(GameSession::Id session_id) {
+std::shared_ptr<GameSession> Game::FindGameSession(GameSession::Id session_id) {
   if (auto it = game_sessions_id_to_index_.find(session_id);
       it != game_sessions_id_to_index_.end()) {
     return sessions_.at(it->second);
@@ -494,123 +618,253 @@ std::shared_ptr<GameSession> Game::FindGameSessionBySessionId(GameSession::Id se
   return nullptr;
 }
 
+void Game::ReclaimEmptySessions() {
+  for (size_t i = 0; i < sessions_.size();) {
+    const auto& session = *sessions_[i];
+    // Карте из конфигурации остаётся хотя бы одна сессия, а карте, убранной из неё, - нет
+    if (session.GetEmptyTime() < settings_.session_grace_period ||
+        (map_id_to_index_.contains(session.GetMapId()) &&
+         map_id_to_session_ids_.at(session.GetMapId()).size() <= 1)) {
+      ++i;
+      continue;
+    }
+    RemoveGameSession(i);  // На место i встаёт последняя сессия
+  }
+}
+
+void Game::RemoveGameSession(size_t index) {
+  const GameSession::Id session_id = sessions_[index]->GetSessionId();
+  auto& map_sessions = map_id_to_session_ids_.at(sessions_[index]->GetMapId());
+  map_sessions.erase(std::find(map_sessions.begin(), map_sessions.end(), session_id));
+  game_sessions_id_to_index_.erase(session_id);
+
+  if (index + 1 != sessions_.size()) {
+    sessions_[index] = std::move(sessions_.back());
+    game_sessions_id_to_index_[sessions_[index]->GetSessionId()] = index;
+  }
+  sessions_.pop_back();
+}
+
 void Game::Tick(double delta_time) {
+  TickMovement(delta_time);
+  TickCollisions(delta_time);
+  TickLoot(delta_time);
+}
+
+void Game::TickMovement(double delta_time) {
   for (const auto& session : sessions_) {
-    session->Tick(delta_time);
+    session->MoveDogs(delta_time);
+    session->UpdateEmptyTime(delta_time);
+  }
+  ReclaimEmptySessions();
+}
 
-    if (loot_generator_) {
-      auto loot_count = session->GetLoots().size();
-      auto looter_count = session->GetDogs().size();
+void Game::TickCollisions(double delta_time) {
+  for (const auto& session : sessions_) {
+    session->ProcessCollisions(delta_time);
+  }
+}
 
-      // Конвертируем delta_time (в секундах) в миллисекунды
-      auto time_delta_ms = static_cast<int>(delta_time * 1000);
-      auto new_loot_count = loot_generator_->Generate(
-          loot_gen::LootGenerator::TimeInterval(time_delta_ms), loot_count, looter_count);
+void Game::TickLoot(double delta_time) {
+  // Состояния всех сессий собираются в один пакет и рассчитываются одним проходом
+  spawn_batch_.Clear();
+  spawn_batch_.Reserve(sessions_.size());
+  for (const auto& session : sessions_) {
+    const auto loot_count = static_cast<unsigned>(session->GetLoots().size());
+    const auto looter_count = static_cast<unsigned>(session->GetDogs().size());
 
-      if (new_loot_count > 0) {
-        const auto* map = FindMap(session->GetMapId());
-        if (map) {
-          session->GenerateLoot(new_loot_count, map->GetLootTypesCount());
-        }
-      }
+    const auto& spawn_state = session->GetSpawnState();
+    spawn_batch_.Add(spawn_state, loot_count, looter_count, GetSpawnRandom(spawn_state.policy));
+  }
+
+  spawn_batch_.Generate(std::chrono::duration<double>(delta_time));
+
+  for (size_t i = 0; i < sessions_.size(); ++i) {
+    auto& session = *sessions_[i];
+    session.GetSpawnState().time_without_loot = spawn_batch_.GetTimeWithoutLoot(i);
+    if (const unsigned new_loot_count = spawn_batch_.GetGenerated(i); new_loot_count > 0) {
+      session.GenerateLoot(new_loot_count, session.GetMap().GetLootTypesCount());
     }
   }
 }
 
 //------------------------Player-------------------------------------
-Player::Player(std::shared_ptr<model::Dog> dog, std::shared_ptr<model::GameSession> game_session,
-               double time)
-    : dog_(dog), game_session_(game_session), join_game_(time) {
-  size_t bag_capacity = game_session->GetMap().GetBagCapacity();
-  dog_->SetBagCapacity(bag_capacity);
-  game_session->AddDog(dog_);
+Player::Player(Dog::Id dog_id, GameSession& game_session, double time)
+    : dog_id_(dog_id), game_session_(&game_session), join_game_(time) {
 }
 
-const model::Dog::Id Player::GetDogId() const {
-  return dog_->GetId();
+Dog& Player::GetDog() const {
+  Dog* dog = game_session_->FindDog(dog_id_);
+  assert(dog && "Player's dog must stay in the session while the player exists");
+  return *dog;
 }
 
 void Player::MovePlayer(std::string direction) {
-  dog_->SetDogDirSpeed(direction);
+  GetDog().SetDogDirSpeed(direction, game_session_->GetMapDefaultSpeed());
+}
+
+//******************************************************************
+//--------------------------PlayerTokens----------------------------
+
+const Player& Players::AddPlayer(Dog dog, GameSession& game_session) {
+  dog.SetBagCapacity(game_session.GetMap().GetBagCapacity());
+  const Dog& added = game_session.AddDog(std::move(dog));
+
+  Player player{added.GetId(), game_session, server_uptime_};
+  player.token_ = player_tokens_.GenerateToken();
+  return Register(std::move(player));
 }
 
-const std::shared_ptr<model::GameSession> Player::GetGameSession() const {
-  return game_session_;
+const Player& Players::AddPlayer(Token token, Dog::Id dog_id, GameSession& game_session) {
+  Player player{dog_id, game_session, server_uptime_};
+  player.token_ = std::move(token);
+  return Register(std::move(player));
 }
 
-const std::shared_ptr<Dog> Player::GetDogPlayer() const {
-  return dog_;
+Player* Players::GetPlayerByToken(const Token& token) {
+  auto handle = player_tokens_.FindPlayerByToken(token);
+  return handle ? players_.Find(*handle) : nullptr;
 }
 
-//******************************************************************
-//--------------------------PlayerTokens----------------------------
+Player* Players::FindByDog(GameSession::Id session_id, Dog::Id dog_id) {
+  auto it = dog_to_player_.find({session_id, dog_id});
+  return it != dog_to_player_.end() ? players_.Find(it->second) : nullptr;
+}
 
-Token Players::AddPlayer(std::shared_ptr<Dog> dog, std::shared_ptr<GameSession> game_session) {
-  std::shared_ptr<Player> player = std::make_shared<Player>(dog, game_session, server_uptime_);
-  Token token = player_tokens_.AddPlayer(player);
-  players_[{dog->GetId(), *(game_session->GetMapId())}] =
-      std::make_shared<Player>(dog, game_session);
+const Player& Players::Register(Player player) {
+  const PlayerHandle handle = players_.Insert(std::move(player));
+  Player& registered = *players_.Find(handle);
+  registered.handle_ = handle;
 
-  return token;
+  player_tokens_.AddToken(registered.GetToken(), handle);
+  dog_to_player_[{registered.GetGameSession().GetSessionId(), registered.GetDogId()}] = handle;
+
+  // Только что вошедший игрок стоит на месте
+  StartIdle(registered);
+  return registered;
 }
 
-void Players::OnTick(double delta, db::Database* database) {
-  server_uptime_ += delta;
+void Players::OnPlayerAction(Player& player, bool moving) {
+  if (moving) {
+    if (player.idle_since_) {
+      player.idle_since_.reset();
+      ++player.idle_version_;
+    }
+  } else if (!player.idle_since_) {
+    StartIdle(player);
+  }
+}
 
-  std::vector<Token> to_remove;
-  for (auto& [token, player] : player_tokens_.GetTokenToPlayer()) {
-    player->CheckActivityDog(delta);
-    auto dog = player->GetDogPlayer();
+void Players::ApplyAction(Player& player, const std::string& direction) {
+  // Движение сбрасывает отсчёт бездействия, остановка запускает его
+  OnPlayerAction(player, !direction.empty());
+  player.MovePlayer(direction);
+}
 
-    if (dog->GetSpeed() == MoveInfo::Speed{} && player->GetStopTime() >= time_wait_) {
-      // Сохраняем рекорд перед удалением
-      auto play_time = server_uptime_ - player->GetJoinTime();
+void Players::StartIdle(Player& player) {
+  player.idle_since_ = server_uptime_;
+  ++player.idle_version_;
+  retirement_queue_.push({server_uptime_ + time_wait_, player.idle_version_, player.handle_});
+}
 
-      if (database) {
-        database->AddRetiredPlayer(dog->GetName(), dog->GetScore(), play_time);
-      }
+void Players::OnTick(double delta, const RetireHandler& on_retire) {
+  server_uptime_ += delta;
 
-      to_remove.push_back(token);
+  while (!retirement_queue_.empty() && retirement_queue_.top().deadline <= server_uptime_) {
+    const RetirementDeadline entry = retirement_queue_.top();
+    retirement_queue_.pop();
+
+    const Player* player = players_.Find(entry.player);
+    if (!player || player->idle_version_ != entry.idle_version) {
+      continue;  // Игрок уже ушёл или с тех пор двигался
     }
-  }
 
-  // Удаляем пенсионеров
-  for (const auto& token : to_remove) {
-    auto player = player_tokens_.FindPlayerByToken(token);
-    if (player) {
-      auto dog_id = player->GetDogId();
-      auto map_id = player->GetGameSession()->GetMapId();
-      players_.erase({dog_id, *map_id});
-      player->GetGameSession()->DeleteDog(dog_id);
+    // Сохраняем рекорд перед удалением
+    if (on_retire) {
+      on_retire(player->GetDog(), server_uptime_ - player->GetJoinTime());
     }
-    player_tokens_.GetTokenToPlayer().erase(token);
+    Retire(entry.player);
   }
 }
 
-Token PlayerTokens::AddPlayer(std::shared_ptr<Player> player) {
-  Token token = GenerateToken();
-  AddToken(player, token);
+void Players::Retire(PlayerHandle handle) {
+  const Player& player = *players_.Find(handle);
+  GameSession& session = player.GetGameSession();
 
-  return token;
+  dog_to_player_.erase({session.GetSessionId(), player.GetDogId()});
+  player_tokens_.RemoveToken(player.GetToken());
+  session.DeleteDog(player.GetDogId());
+  players_.Erase(handle);
 }
 
-void PlayerTokens::AddToken(std::shared_ptr<Player> player, Token token) {
+void PlayerTokens::AddToken(const Token& token, PlayerHandle player) {
   token_to_player_[token] = player;
 }
 
-std::shared_ptr<Player> PlayerTokens::FindPlayerByToken(const Token& token) {
+void PlayerTokens::RemoveToken(const Token& token) {
+  token_to_player_.erase(token);
+}
+
+std::optional<PlayerHandle> PlayerTokens::FindPlayerByToken(const Token& token) const {
   auto player = token_to_player_.find(token);
   if (player != token_to_player_.end())
     return player->second;
 
-  return nullptr;
+  return std::nullopt;
 }
 
 Token PlayerTokens::GenerateToken() {
-  std::ostringstream ss;
-  ss << std::hex << std::setw(16) << std::setfill('0') << generator1_() << std::setw(16)
-     << std::setfill('0') << generator2_();
-  return Token{ss.str()};
+  // Токены чужих частей отбрасываются: в среднем partition_count_ попыток на токен
+  while (true) {
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << generator1_() << std::setw(16)
+       << std::setfill('0') << generator2_();
+    Token token{ss.str()};
+    if (partition_count_ <= 1 || TokenPartition(token, partition_count_) == partition_) {
+      return token;
+    }
+  }
+}
+
+const Player* JoinGame(Game& game, Players& players, const Map::Id& map_id,
+                       const std::string& user_name) {
+  auto session = game.FindSessionForJoin(map_id);
+  if (!session) {
+    return nullptr;
+  }
+
+  return &players.AddPlayer(Dog{user_name}, *session);
+}
+
+namespace {
+
+// FNV-1a: в отличие от std::hash, одинакова во всех сборках, поэтому части карт
+// и токенов совпадают у сервера и у повтора его записи
+std::uint64_t StableHash(std::string_view value) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (const char c : value) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+unsigned MapPartition(const Map::Id& map_id, unsigned partitions) {
+  return static_cast<unsigned>(StableHash(*map_id) % partitions);
+}
+
+unsigned TokenPartition(const Token& token, unsigned partitions) {
+  return static_cast<unsigned>(StableHash(*token) % partitions);
+}
+
+unsigned SessionPartition(const Game& game, const Map::Id& map_id, GameSession::Id session_id,
+                          unsigned partitions) {
+  const Map* map = game.FindMap(map_id);
+  if (map && game.GetSessionCapacity(*map) == 0) {
+    return MapPartition(map_id, partitions);
+  }
+  return static_cast<unsigned>(session_id % partitions);
 }
 
 //*******************************************************************
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <chrono>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <limits>
+#include <queue>
 #include <random>
+#include <span>
+#include <stdexcept>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -21,7 +30,11 @@
 #include "ticker.h"
 #include "loot_generator.h"
 #include "collision_detector.h"
-#include "database.h"
+#include "id_allocator.h"
+#include "interned_string.h"
+#include "road_graph.h"
+#include "slot_map.h"
+#include "spatial_grid.h"
 
 namespace model {
 
@@ -36,28 +49,27 @@ using Token = util::Tagged<std::string, detail::TokenTag>;
 
 struct Point {
   Coord x, y;
+
+  bool operator==(const Point&) const = default;
 };
 
 struct Size {
   Dimension width, height;
+
+  bool operator==(const Size&) const = default;
 };
 
 struct Rectangle {
   Point position;
   Size size;
+
+  bool operator==(const Rectangle&) const = default;
 };
 
 struct Offset {
   Dimension dx, dy;
-};
 
-struct Region {
-  double min_x, max_x;
-  double min_y, max_y;
-
-  bool Contains(const MoveInfo::Position& pos) const {
-    return pos.x >= min_x && pos.x <= max_x && pos.y >= min_y && pos.y <= max_y;
-  }
+  bool operator==(const Offset&) const = default;
 };
 
 class Road {
@@ -103,6 +115,8 @@ class Road {
     return std::minmax(start_.y, end_.y);
   }
 
+  bool operator==(const Road&) const = default;
+
  private:
   Point start_;
   Point end_;
@@ -117,6 +131,8 @@ class Building {
     return bounds_;
   }
 
+  bool operator==(const Building&) const = default;
+
  private:
   Rectangle bounds_;
 };
@@ -141,39 +157,14 @@ class Office {
     return offset_;
   }
 
+  bool operator==(const Office&) const = default;
+
  private:
   Id id_;
   Point position_;
   Offset offset_;
 };
 
-class RoadIndex {
- public:
-  void AddRoad(const Road& road) {
-    if (road.IsHorizontal()) {
-      horizontal_roads_[road.GetStart().y].push_back(road);
-    } else if (road.IsVertical()) {
-      vertical_roads_[road.GetStart().x].push_back(road);
-    }
-  }
-
-  const std::vector<Road>& GetHorizontalRoads(double y) const {
-    static std::vector<Road> empty;
-    auto it = horizontal_roads_.find(y);
-    return it != horizontal_roads_.end() ? it->second : empty;
-  }
-
-  const std::vector<Road>& GetVerticalRoads(double x) const {
-    static std::vector<Road> empty;
-    auto it = vertical_roads_.find(x);
-    return it != vertical_roads_.end() ? it->second : empty;
-  }
-
- private:
-  std::unordered_map<double, std::vector<Road>> horizontal_roads_;
-  std::unordered_map<double, std::vector<Road>> vertical_roads_;
-};
-
 class Map {
  public:
   using Id = util::Tagged<std::string, Map>;
@@ -190,6 +181,7 @@ class Map {
   const Roads& GetRoads() const noexcept;
   const Offices& GetOffices() const noexcept;
 
+  // Дорога сразу попадает в граф дорог, по которому двигаются собаки
   void AddRoad(const Road& road);
   void AddBuilding(const Building& building);
   void AddOffice(Office office);
@@ -222,12 +214,38 @@ class Map {
     return bag_capacity_;
   }
 
+  // Правило появления трофеев, заменяющее общее правило игры
+  const std::optional<loot_gen::SpawnPolicy>& GetSpawnPolicy() const {
+    return spawn_policy_;
+  }
+
+  void SetSpawnPolicy(loot_gen::SpawnPolicy policy) {
+    spawn_policy_ = policy;
+  }
+
+  // Наибольшее число собак в одной сессии карты, заменяющее общее ограничение игры
+  const std::optional<size_t>& GetSessionCapacity() const {
+    return session_capacity_;
+  }
+
+  void SetSessionCapacity(size_t capacity) {
+    session_capacity_ = capacity;
+  }
+
+  const road_graph::RoadGraph& GetRoadGraph() const noexcept {
+    return road_graph_;
+  }
+
+  // Карты равны, если совпадает всё, что влияет на игру; граф дорог строится по дорогам
+  bool operator==(const Map& other) const;
+
  private:
   using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
 
   Id id_;
   std::string name_;
   Roads roads_;
+  road_graph::RoadGraph road_graph_;
   Buildings buildings_;
 
   OfficeIdToIndex warehouse_id_to_index_;
@@ -235,57 +253,77 @@ class Map {
 
   double default_dog_speed_ = 1.0;
   std::vector<int> loot_values_;
+  std::optional<loot_gen::SpawnPolicy> spawn_policy_;
+  std::optional<size_t> session_capacity_;
 
-  size_t bag_capacity_;
+  size_t bag_capacity_ = 0;
 };
 
+// Рюкзак хранит предметы в себе, без выделения памяти: вместимость и число типов
+// трофеев ограничены, и json_loader отвергает карты, которые в эти пределы не помещаются
 class Bag {
  public:
-  explicit Bag(size_t capacity) : capacity_(capacity) {
+  // Тип трофея - индекс в списке типов карты
+  using Item = std::uint8_t;
+
+  // При такой вместимости рюкзак вместе со счётчиками занимает 16 байт
+  static constexpr size_t MAX_CAPACITY = 14;
+  static constexpr size_t MAX_LOOT_TYPES = size_t{std::numeric_limits<Item>::max()} + 1;
+
+  explicit Bag(size_t capacity) : capacity_(CheckCapacity(capacity)) {
   }
 
   bool AddLoot(size_t loot_type) {
-    if (items_.size() >= capacity_) {
+    assert(loot_type < MAX_LOOT_TYPES);
+    if (size_ >= capacity_) {
       return false;  // Рюкзак полон
     }
-    items_.push_back(loot_type);
+    items_[size_++] = static_cast<Item>(loot_type);
     return true;
   }
 
   bool IsFull() const {
-    return items_.size() >= capacity_;
+    return size_ >= capacity_;
   }
 
   void Clear() {
-    items_.clear();
+    size_ = 0;
   }
 
   size_t GetSize() const {
-    return items_.size();
+    return size_;
   }
 
   size_t GetCapacity() const {
     return capacity_;
   }
 
-  const std::vector<size_t>& GetItems() const {
-    return items_;
+  std::span<const Item> GetItems() const {
+    return {items_.data(), size_};
   }
 
   void SetCapacity(size_t new_capacity) {
-    capacity_ = new_capacity;
-    if (items_.size() > capacity_) {
-      items_.resize(capacity_);
-    }
+    capacity_ = CheckCapacity(new_capacity);
+    size_ = std::min(size_, capacity_);
   }
 
  private:
-  std::vector<size_t> items_;
-  size_t capacity_;
+  static std::uint8_t CheckCapacity(size_t capacity) {
+    if (capacity > MAX_CAPACITY) {
+      throw std::invalid_argument("Bag capacity " + std::to_string(capacity) +
+                                  " exceeds the limit " + std::to_string(MAX_CAPACITY));
+    }
+    return static_cast<std::uint8_t>(capacity);
+  }
+
+  std::array<Item, MAX_CAPACITY> items_{};
+  std::uint8_t size_ = 0;
+  std::uint8_t capacity_;
 };
 
 class Dog {
  public:
+  // Идентификатор выдаёт сессия при добавлении собаки; он уникален в пределах сессии
   using Id = std::size_t;
 
   explicit Dog(std::string_view name, size_t bag_capacity = 3);
@@ -303,11 +341,9 @@ class Dog {
   const MoveInfo::Direction& GetDirection() const noexcept;
   const MoveInfo& GetState() const noexcept;
 
-  void SetDefaultDogSpeed(double speed);
   void SetDogSpeed(double x, double y);
-  void SetDogDirSpeed(std::string dir);
-
-  const double GetDefaultDogSpeed() const;
+  // Скорость - общая для всех собак карты, поэтому собака её не хранит
+  void SetDogDirSpeed(std::string_view dir, double speed);
 
   void StopDog();
   MoveInfo::Position MoveDog(MoveInfo::Position other_pos);
@@ -319,20 +355,35 @@ class Dog {
   int GetScore() const;
   void AddScore(int value);
 
+  // Сегмент графа дорог, на котором собака стояла после последнего шага.
+  // Не сохраняется: после восстановления сегмент ищется по позиции.
+  road_graph::SegmentId GetRoadSegment() const noexcept {
+    return road_segment_;
+  }
+
+  void SetRoadSegment(road_graph::SegmentId segment) noexcept {
+    road_segment_ = segment;
+  }
+
  private:
-  std::string name_;
-  Id id_;
-  int score_ = 0;
+  friend class GameSession;
 
+  // Поля упорядочены так, чтобы между ними не было выравнивания
+  util::InternedString name_;
+  Id id_ = 0;
   MoveInfo state_;
-  double default_dog_speed_ = 1.0;
+  int score_ = 0;
+  road_graph::SegmentId road_segment_ = road_graph::NO_SEGMENT;
   Bag bag_;
 };
 
 class GameSession {
  public:
   using Id = size_t;
-  using Dogs = std::unordered_map<Dog::Id, std::shared_ptr<Dog>>;
+  // Собаки сессии хранятся подряд; ссылки на них действительны до добавления
+  // или удаления собаки, поэтому снаружи собаку запоминают по Dog::Id.
+  // Идентификаторы собак плотные и служат индексом в таблице ключей.
+  using Dogs = util::SlotMap<Dog>;
 
   struct Loot {
     size_t type;  // индекс типа трофея
@@ -340,24 +391,38 @@ class GameSession {
     MoveInfo::Position position;
   };
 
-  GameSession(const Map& map);
-  GameSession(Dogs dogs, const Map& map, Id id, std::vector<Loot> loots);
-
-  const std::vector<Loot>& GetLoots() const {
+  // Идентификатор трофея не меняется, пока трофей лежит на карте
+  using Loots = util::SlotMap<Loot>;
+  using LootId = Loots::Key;
+
+  // Ширины объектов при поиске столкновений
+  static constexpr double LOOT_WIDTH = 0.0;
+  static constexpr double OFFICE_WIDTH = 0.5;
+  static constexpr double DOG_WIDTH = 0.6;
+
+  // Сессия владеет своей картой: карта, убранная из игры при перезагрузке
+  // конфигурации, живёт, пока на ней играют
+  explicit GameSession(std::shared_ptr<const Map> map);
+  // Карта должна жить дольше сессии
+  explicit GameSession(const Map& map);
+  // Восстанавливает сессию вместе с состоянием выдачи идентификаторов собак
+  GameSession(std::vector<Dog> dogs, std::shared_ptr<const Map> map, Id id,
+              std::vector<Loot> loots, util::IdAllocator dog_ids);
+
+  const Loots& GetLoots() const {
     return loots_;
   }
 
   void GenerateLoot(unsigned count, size_t loot_types_count) {
-    const auto& roads = map_.GetRoads();
+    const auto& roads = map_->GetRoads();
     if (roads.empty())
       return;
 
-    const auto& loot_values = map_.GetLootValues();
+    const auto& loot_values = map_->GetLootValues();
     if (loot_values.empty())
       return;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    auto& gen = random_;
     std::uniform_int_distribution<size_t> type_dist(0, loot_types_count - 1);
     std::uniform_int_distribution<size_t> road_dist(0, roads.size() - 1);
 
@@ -377,16 +442,17 @@ class GameSession {
         loot.position = {static_cast<double>(road.GetStart().x), static_cast<double>(y_dist(gen))};
       }
 
-      loots_.push_back(loot);
+      InsertLoot(loot);
     }
   }
 
   Map::Id GetMapId() const;
   const Id GetSessionId() const;
 
-  void AddDog(std::shared_ptr<Dog> dog);
+  // Выдаёт собаке идентификатор и ставит её в начальную точку карты
+  Dog& AddDog(Dog dog);
   const Dogs& GetDogs() const;
-  bool HasDog(Dog::Id id);
+  bool HasDog(Dog::Id id) const;
 
   const std::vector<std::string> GetPlayersNames() const;
   const std::vector<MoveInfo> GetPlayersUnitStates() const;
@@ -397,13 +463,30 @@ class GameSession {
   void StopPlayer(Dog::Id id);
   void Tick(double delta_time);
 
+  void MoveDogs(double delta_time);
+  void UpdateEmptyTime(double delta_time);
+
   void ProcessCollisions(double delta_time);
 
   const Map& GetMap() const {
-    return map_;
+    return *map_;
+  }
+
+  // Переводит сессию на такую же карту из нового набора, не меняя состояния сессии
+  void RebindMap(std::shared_ptr<const Map> map);
+  // Переносит сессию на изменившуюся карту с тем же идентификатором. Собаки, оказавшиеся
+  // вне дорог, переходят в начальную точку и останавливаются. Пропадают трофеи вне дорог
+  // и трофеи типов, которых на карте больше нет, а рюкзаки уменьшаются до вместимости карты.
+  void MigrateToMap(std::shared_ptr<const Map> map);
+
+  // Состояние генератора трофеев этой сессии
+  loot_gen::SpawnState& GetSpawnState() {
+    return spawn_state_;
   }
 
-  void InitializeRegions();
+  const loot_gen::SpawnState& GetSpawnState() const {
+    return spawn_state_;
+  }
 
   void SetRandomSpawnMode(bool enable) {
     random_spawn_mode_ = enable;
@@ -413,123 +496,176 @@ class GameSession {
     return random_spawn_mode_;
   }
 
-  void AddLoot(const Loot& loot) {
-    loots_.push_back(loot);
+  // Генератор случайных чисел сессии; игра задаёт зерно, чтобы прогоны повторялись
+  void SeedRandom(std::uint64_t seed) {
+    random_.seed(static_cast<std::mt19937::result_type>(seed));
   }
 
-  std::shared_ptr<Dog> FindDog(Dog::Id dog_id) {
-    auto ptr = dogs_.find(dog_id);
-    if (ptr == dogs_.end()) {
-      return nullptr;  // Элемент не найден
-    }
-    return ptr->second;  // Возвращаем shared_ptr<Dog>
+  LootId AddLoot(const Loot& loot) {
+    return InsertLoot(loot);
+  }
+
+  // Обходит собак в области интереса. Позиции собак попадают в сетку
+  // при добавлении собаки и на каждом тике.
+  template <typename Fn>
+  void ForEachDogIn(const util::InterestArea& area, Fn&& fn) const {
+    dog_grid_.ForEachIn(area, [this, &fn](util::SpatialGrid::Id dog_id, geom::Point2D) {
+      fn(*FindDog(dog_id));
+    });
+  }
+
+  // Обходит трофеи в области интереса, fn(LootId, const Loot&)
+  template <typename Fn>
+  void ForEachLootIn(const util::InterestArea& area, Fn&& fn) const {
+    loot_grid_.ForEachIn(area, [this, &fn](util::SpatialGrid::Id slot, geom::Point2D) {
+      const LootId loot_id = *loots_.KeyOfSlot(slot);
+      fn(loot_id, *loots_.Find(loot_id));
+    });
   }
 
-  void DeleteDog(Dog::Id dog_id) {
-    dogs_.erase(dog_id);
+  Dog* FindDog(Dog::Id dog_id);
+  const Dog* FindDog(Dog::Id dog_id) const;
+
+  // Идентификатор удалённой собаки может достаться следующей
+  void DeleteDog(Dog::Id dog_id);
+
+  const util::IdAllocator& GetDogIdAllocator() const {
+    return dog_ids_;
+  }
+
+  // Сколько времени подряд в сессии нет ни одной собаки
+  double GetEmptyTime() const {
+    return empty_time_;
   }
 
  private:
   static Id GenerateId() {
-    static boost::uuids::random_generator gen;
+    // Сессии создаются в потоках всех шардов, поэтому генератор у каждого потока свой
+    thread_local boost::uuids::random_generator gen;
     boost::uuids::uuid uuid = gen();
     return boost::hash<boost::uuids::uuid>()(uuid);
   }
 
-  MoveInfo::Position CalculateNewPosition(const MoveInfo::Position& position,
-                                          const MoveInfo::Speed& speed, double delta_time);
+  // Размер ячейки сеток области интереса, в единицах карты
+  static constexpr double INTEREST_GRID_CELL_SIZE = 10.0;
 
-  bool IsWithinAnyRegion(const MoveInfo::Position& pos,
-                         const std::unordered_map<int, Region>& regions);
+  static geom::Point2D ToPoint(const MoveInfo::Position& position) {
+    return {position.x, position.y};
+  }
+
+  LootId InsertLoot(const Loot& loot);
+  void EraseLoot(LootId loot_id);
 
   MoveInfo::Position FindStartingPosition() const;
-  MoveInfo::Position AdjustPositionToMaxRegion(const std::shared_ptr<Dog>& dog);
-  MoveInfo::Position MaxValueOfRegion(Region reg, MoveInfo::Direction dir,
-                                      MoveInfo::Position current_pos);
-  MoveInfo::Position MoveOnMaxDistance(const MoveInfo::Position& current,
-                                       const MoveInfo::Position& possible, double current_max);
+  // Шаг собаки по графу дорог карты; упёршаяся в край дороги собака останавливается
+  void MoveDog(Dog& dog, double delta_time);
+
   Dogs dogs_;
-  const Map& map_;
+  util::IdAllocator dog_ids_;
+  // Ключ собаки в dogs_ по её идентификатору, пусто для свободных идентификаторов
+  std::vector<std::optional<Dogs::Key>> dog_keys_;
+  std::shared_ptr<const Map> map_;
   Id id_;
 
-  RoadIndex road_index_;
-  std::unordered_map<int, Region> regions_;
-
   bool random_spawn_mode_ = false;
-  std::vector<Loot> loots_;
+  std::mt19937 random_{std::random_device{}()};
+  Loots loots_;
+  loot_gen::SpawnState spawn_state_;
+  double empty_time_ = 0;
+
+  // Собаки по идентификатору и трофеи по номеру слота в loots_
+  util::SpatialGrid dog_grid_{INTEREST_GRID_CELL_SIZE};
+  util::SpatialGrid loot_grid_{INTEREST_GRID_CELL_SIZE};
+
+  // Буферы поиска столкновений, память переиспользуется от тика к тику
+  collision_detector::ItemsBatch collision_items_;
+  collision_detector::GatherersBatch collision_gatherers_;
+  std::vector<LootId> collision_loot_ids_;
 };
 
+// Игрок ссылается на свою сессию и собаку в ней. Сессия удаляется
+// (Game::ReclaimEmptySessions), только когда в ней не осталось игроков, а собака
+// удаляется из сессии только вместе с игроком, поэтому обе ссылки действительны,
+// пока жив игрок.
 class Player {
  public:
   Player() = delete;
-  Player(std::shared_ptr<Dog> dog, std::shared_ptr<GameSession> game_session, double time = 0);
+  Player(Dog::Id dog_id, GameSession& game_session, double time = 0);
 
-  const Dog::Id GetDogId() const;
-  const std::shared_ptr<GameSession> GetGameSession() const;
-  const std::shared_ptr<Dog> GetDogPlayer() const;
-
-  void MovePlayer(std::string direction = "");
-
-  void CheckActivityDog(double delta) {
-    if (!trying_to_move_ && dog_->GetSpeed() == MoveInfo::Speed{}) {
-      inactive_time += delta;  // не двигается и не пытается — бездействие
-    } else {
-      live_time += delta;  // либо двигается, либо пытается двигаться — активность
-    }
+  Dog::Id GetDogId() const {
+    return dog_id_;
   }
 
-  double GetStopTime() const {
-    return inactive_time;
+  GameSession& GetGameSession() const {
+    return *game_session_;
   }
 
+  Dog& GetDog() const;
+
+  void MovePlayer(std::string direction = "");
+
   double GetJoinTime() const {
     return join_game_;
   }
 
-  void SetStopTime(double time) {
-    inactive_time = time;
+  // Время сервера, с которого игрок бездействует, или nullopt, если он пытается двигаться.
+  // Длительности считаются по требованию как разность с текущим временем сервера.
+  std::optional<double> GetIdleSince() const {
+    return idle_since_;
   }
 
-  void SetTryingToMove(bool flag) {
-    trying_to_move_ = flag;
+  bool IsTryingToMove() const {
+    return !idle_since_;
   }
 
-  bool IsTryingToMove() const {
-    return trying_to_move_;
+  const Token& GetToken() const {
+    return token_;
   }
 
  private:
-  std::shared_ptr<Dog> dog_;
-  std::shared_ptr<GameSession> game_session_;
+  friend class Players;
 
-  double inactive_time{0};
-  double join_game_{0};
-  double live_time{0};
+  Dog::Id dog_id_;
+  GameSession* game_session_;
+  Token token_{""};
+  util::SlotMap<Player>::Key handle_;
 
-  bool trying_to_move_{false};
+  double join_game_{0};
+  std::optional<double> idle_since_;
+  // Меняется при каждом изменении idle_since_, чтобы отличать устаревшие сроки в очереди
+  std::uint64_t idle_version_{0};
 };
 
+// Все игроки хранятся в одном плотном массиве и адресуются ключами
+using PlayerStorage = util::SlotMap<Player>;
+using PlayerHandle = PlayerStorage::Key;
+
 class PlayerTokens {
  public:
   using TokenHasher = util::TaggedHasher<Token>;
   PlayerTokens() = default;
 
-  Token AddPlayer(std::shared_ptr<Player> player);
-
-  std::shared_ptr<Player> FindPlayerByToken(const Token& token);
+  // Новый токен; его часть игры (TokenPartition) совпадает с заданной SetPartition
+  Token GenerateToken();
 
-  void AddToken(std::shared_ptr<Player> player, Token token);
+  std::optional<PlayerHandle> FindPlayerByToken(const Token& token) const;
 
-  std::unordered_map<Token, std::shared_ptr<Player>, TokenHasher>& GetTokenToPlayer() {
-    return token_to_player_;
+  void SetPartition(unsigned index, unsigned count) {
+    partition_ = index;
+    partition_count_ = count;
   }
 
+  void AddToken(const Token& token, PlayerHandle player);
+  void RemoveToken(const Token& token);
+
   void Clear() {
     token_to_player_.clear();  // Очищаем словарь токенов
   }
 
  private:
-  std::unordered_map<Token, std::shared_ptr<Player>, TokenHasher> token_to_player_;
+  std::unordered_map<Token, PlayerHandle, TokenHasher> token_to_player_;
+  unsigned partition_ = 0;
+  unsigned partition_count_ = 1;
 
   std::random_device random_device_;
   std::mt19937_64 generator1_{[this] {
@@ -540,30 +676,35 @@ class PlayerTokens {
     std::uniform_int_distribution<std::mt19937_64::result_type> dist;
     return dist(random_device_);
   }()};
-
-  Token GenerateToken();
 };
 
 class Players {
  public:
-  using AllPlayers = std::unordered_map<std::pair<Dog::Id, std::string>, std::shared_ptr<Player>,
-                                        boost::hash<std::pair<Dog::Id, std::string>>>;
+  // Вызывается для каждой собаки, уходящей на покой, с её временем в игре
+  using RetireHandler = std::function<void(const Dog& dog, double play_time)>;
 
-  Token AddPlayer(std::shared_ptr<Dog> dog, std::shared_ptr<GameSession> game_session);
+  // Добавляет собаку в сессию и создаёт для неё игрока с новым токеном.
+  // Ссылка действительна до следующего добавления или удаления игрока.
+  const Player& AddPlayer(Dog dog, GameSession& game_session);
+  // Регистрирует восстановленного игрока, собака которого уже есть в сессии
+  const Player& AddPlayer(Token token, Dog::Id dog_id, GameSession& game_session);
 
-  std::shared_ptr<Player> GetPlayerByToken(Token token) {
-    return player_tokens_.FindPlayerByToken(token);
-  }
+  Player* GetPlayerByToken(const Token& token);
+  Player* FindByDog(GameSession::Id session_id, Dog::Id dog_id);
 
-  std::shared_ptr<Player> FindByDogAndMapId(Dog::Id dog_id, Map::Id map_id) {
-    return players_[{dog_id, *map_id}];
+  const PlayerStorage& GetAllPlayers() const {
+    return players_;
   }
 
-  PlayerTokens& GetPlayerTokens() {
-    return player_tokens_;
-  }
+  // Обрабатывает только игроков, срок бездействия которых истёк
+  void OnTick(double delta, const RetireHandler& on_retire = {});
 
-  void OnTick(double delta, db::Database* database);
+  // Учитывает действие игрока: движение снимает его с отсчёта бездействия,
+  // остановка начинает отсчёт, если он ещё не идёт
+  void OnPlayerAction(Player& player, bool moving);
+
+  // Команда игрока из /api/v1/game/player/action: направление или "" для остановки
+  void ApplyAction(Player& player, const std::string& direction);
 
   double GetServerUptime() const {
     return server_uptime_;
@@ -571,23 +712,50 @@ class Players {
 
   void ClearAll() {
     player_tokens_.Clear();  // Очищаем токены
+    dog_to_player_.clear();
     players_.clear();        // Очищаем всех игроков
   }
 
-  AllPlayers& GetAllPlayers() {
-    return players_;
-  }
-
   void SetTimeWaitDog(double time) {
     time_wait_ = time;
   }
 
+  // Игроки части игры index из count получают токены, по которым запросы попадают в неё
+  void SetPartition(unsigned index, unsigned count) {
+    player_tokens_.SetPartition(index, count);
+  }
+
  private:
+  // Идентификаторы собак уникальны только внутри сессии
+  using DogToPlayer = std::unordered_map<std::pair<GameSession::Id, Dog::Id>, PlayerHandle,
+                                         boost::hash<std::pair<GameSession::Id, Dog::Id>>>;
+
+  struct RetirementDeadline {
+    double deadline;
+    std::uint64_t idle_version;
+    PlayerHandle player;
+
+    bool operator>(const RetirementDeadline& other) const {
+      return deadline > other.deadline;
+    }
+  };
+
+  const Player& Register(Player player);
+  void StartIdle(Player& player);
+  void Retire(PlayerHandle handle);
+
   double server_uptime_{0};
   double time_wait_{60};
 
+  // Единственное хранилище игроков; остальные индексы ссылаются на него ключами
+  PlayerStorage players_;
   PlayerTokens player_tokens_;
-  AllPlayers players_;
+  DogToPlayer dog_to_player_;
+
+  // Сроки ухода на покой, ближайший сверху. Запись устаревает, если игрок
+  // с тех пор двигался; такие записи отбрасываются при извлечении.
+  std::priority_queue<RetirementDeadline, std::vector<RetirementDeadline>, std::greater<>>
+      retirement_queue_;
 };
 
 class Game {
@@ -608,18 +776,38 @@ class Game {
 
     double dog_retirement_time = 60;
 
+    // Наибольшее число собак в сессии, 0 - без ограничения.
+    // Когда все сессии карты заполнены, для неё создаётся ещё одна.
+    size_t session_capacity = 0;
+    // Через сколько секунд опустевшая сессия удаляется, если у карты есть другие
+    double session_grace_period = 60;
+
     bool IsAutoTickEnabled() const {
       return ticker != nullptr;
     }
   };
 
+  // Итоги перезагрузки карт: сколько сессий осталось на тех же картах, сколько перенесено
+  // на изменившиеся карты и сколько доигрывается на картах, убранных из конфигурации
+  struct MapsReload {
+    size_t kept = 0;
+    size_t migrated = 0;
+    size_t retired = 0;
+  };
+
   void AddMap(Map map);
   const Maps& GetMaps() const noexcept;
   const Map* FindMap(const Map::Id& id) const noexcept;
+  // То же с владением: так карту держат сессии
+  std::shared_ptr<const Map> FindSharedMap(const Map::Id& id) const;
 
   std::shared_ptr<GameSession> CreateGameSession(Map::Id map_id);
-  std::shared_ptr<GameSession> FindGameSession(Map::Id map_id);
+  // Сессия карты для нового игрока: самая заполненная из тех, где есть место.
+  // Если места нет нигде, создаётся новая сессия.
+  std::shared_ptr<GameSession> FindSessionForJoin(const Map::Id& map_id);
+  std::shared_ptr<GameSession> FindGameSession(GameSession::Id session_id);
   const GameSessions& GetGameSessions() const;
+  size_t GetSessionCapacity(const Map& map) const;
 
   const Settings& GetSettings() const;
   Settings& GetSettings();
@@ -629,16 +817,37 @@ class Game {
   void SetDefaultBagCapacity(int capacity);
   int GetDefaultBagCapacity() const;
 
+  // Выполняет фазы тика по порядку
   void Tick(double delta_time);
+  // Фазы тика, каждая - для всех сессий сразу, чтобы длительность каждой
+  // можно было измерить отдельно. Опустевшие сессии удаляются после движения.
+  void TickMovement(double delta_time);
+  void TickCollisions(double delta_time);
+  void TickLoot(double delta_time);
 
   void SetLootGeneratorConfig(double period, double probability);
+  // Общее правило появления трофеев для карт, не задавших своего
+  void SetSpawnPolicy(loot_gen::SpawnPolicy policy);
+  const loot_gen::SpawnPolicy& GetDefaultSpawnPolicy() const noexcept {
+    return spawn_policy_;
+  }
+
+  // Заменяет карты и общее правило появления трофеев взятыми из игры, загруженной
+  // из новой конфигурации. Вызывается между тиками. Новые игроки попадают на новые карты,
+  // а прежний набор карт освобождается, когда на его картах не остаётся сессий.
+  MapsReload ReloadMaps(Game&& loaded);
+
+  // Делает случайные события игры повторяемыми: генерацию трофеев и зёрна
+  // сессий, созданных или восстановленных после вызова
+  void SetRandomSeed(std::uint64_t seed);
 
   const std::unordered_map<Map::Id, size_t, MapIdHasher>& GetMapIdToIndex() const {
     return map_id_to_index_;
   }
 
-  const std::unordered_map<Map::Id, GameSession::Id, MapIdHasher>& GetMapIdToSessionId() const {
-    return map_id_to_session_id_;
+  const std::unordered_map<Map::Id, std::vector<GameSession::Id>, MapIdHasher>&
+  GetMapIdToSessionIds() const {
+    return map_id_to_session_ids_;
   }
 
   const std::unordered_map<GameSession::Id, size_t>& GetGameSessionsIdToIndex() const {
@@ -648,31 +857,78 @@ class Game {
   void LoadGameSession(std::shared_ptr<GameSession>&& session) {
     GameSession::Id session_id = session->GetSessionId();
     auto map_id = session->GetMap().GetId();
+    session->GetSpawnState().policy = GetSpawnPolicy(session->GetMap());
+    session->SeedRandom(session_seeds_());
 
     game_sessions_id_to_index_[session_id] = sessions_.size();
-    map_id_to_session_id_[map_id] = session_id;
+    map_id_to_session_ids_[map_id].push_back(session_id);
     sessions_.push_back(std::move(session));  // Один раз!
   }
 
  private:
-  std::shared_ptr<GameSession> FindGameSessionBySessionId(GameSession::Id session_id);
-
-  Maps maps_;
+  // Удаляет сессии, пустующие дольше session_grace_period, оставляя каждой карте хотя бы одну
+  void ReclaimEmptySessions();
+  void RemoveGameSession(size_t index);
+  // Карта из текущего набора; указатель продлевает жизнь всего набора
+  std::shared_ptr<const Map> GetMapPtr(size_t index) const;
+  loot_gen::SpawnPolicy GetSpawnPolicy(const Map& map) const;
+  double GetSpawnRandom(const loot_gen::SpawnPolicy& policy);
+
+  // Набор карт не меняется, пока на него ссылаются сессии: AddMap в этом случае копирует его
+  std::shared_ptr<Maps> maps_ = std::make_shared<Maps>();
   GameSessions sessions_;
   Settings settings_;
 
   std::unordered_map<Map::Id, size_t, MapIdHasher> map_id_to_index_;
-  std::unordered_map<Map::Id, GameSession::Id, MapIdHasher> map_id_to_session_id_;
+  std::unordered_map<Map::Id, std::vector<GameSession::Id>, MapIdHasher> map_id_to_session_ids_;
   std::unordered_map<GameSession::Id, size_t> game_sessions_id_to_index_;
 
-  std::unique_ptr<loot_gen::LootGenerator> loot_generator_;
+  // Правило по умолчанию: трофеи не появляются
+  loot_gen::SpawnPolicy spawn_policy_;
+  loot_gen::SpawnBatch spawn_batch_;
+  std::mt19937 spawn_random_{std::random_device{}()};
+  // Зёрна генераторов новых и восстановленных сессий
+  std::mt19937_64 session_seeds_{std::random_device{}()};
+};
+
+// Вход в игру: собака с именем user_name попадает в сессию карты, выбранную игрой.
+// Возвращает nullptr, если такой карты нет.
+const Player* JoinGame(Game& game, Players& players, const Map::Id& map_id,
+                       const std::string& user_name);
+
+/*
+ * Части игры. В режиме шардов у каждого шарда своя игра (Game) со своими сессиями
+ * и игроками; карты у частей общие. Игрок живёт в части своей сессии, и запросы
+ * с его токеном выполняются в ней.
+ */
+struct GamePart {
+  Game& game;
+  Players& players;
 };
 
+// Часть, в которой живут сессии карты без ограничения числа собак: у такой карты одна
+// сессия, и все её игроки должны попасть в одну часть. Не зависит от сборки и запуска.
+unsigned MapPartition(const Map::Id& map_id, unsigned partitions);
+
+// Часть, к которой относится токен, выданный после запуска сервера
+unsigned TokenPartition(const Token& token, unsigned partitions);
+
+// Часть, в которую попадает сессия из снимка: сессия карты без ограничения числа собак -
+// в часть карты, остальные распределяются по идентификатору
+unsigned SessionPartition(const Game& game, const Map::Id& map_id, GameSession::Id session_id,
+                          unsigned partitions);
+
+// Зерно случайных событий части игры; часть 0 получает зерно игры без шардов
+inline std::uint64_t PartitionSeed(std::uint64_t seed, unsigned partition) {
+  return seed + partition;
+}
+
+// Адаптер сессии для collision_detector, которым пользуются тесты и замеры. Сама сессия
+// заполняет структуры массивов напрямую (GameSession::ProcessCollisions) в том же порядке:
+// трофеи и собаки нумеруются по позиции в хранилищах сессии, сначала идут трофеи, затем базы.
 class GameItemGathererProvider : public collision_detector::ItemGathererProvider {
  public:
-  GameItemGathererProvider(const GameSession& session) : session_(session) {
-  }
-  GameItemGathererProvider(const GameSession& session, double delta_time)
+  GameItemGathererProvider(const GameSession& session, double delta_time = 0)
       : session_(session), delta_time_(delta_time) {
   }
 
@@ -688,7 +944,7 @@ class GameItemGathererProvider : public collision_detector::ItemGathererProvider
       // Это предмет (loot)
       return {
           {loots[idx].position.x, loots[idx].position.y},
-          0.0  // Ширина предмета 0
+          GameSession::LOOT_WIDTH
       };
     } else {
       // Это офис (база)
@@ -697,7 +953,7 @@ class GameItemGathererProvider : public collision_detector::ItemGathererProvider
       return {
           {static_cast<double>(office.GetPosition().x),
            static_cast<double>(office.GetPosition().y)},
-          0.5  // Ширина базы 0.5
+          GameSession::OFFICE_WIDTH
       };
     }
   }
@@ -707,18 +963,20 @@ class GameItemGathererProvider : public collision_detector::ItemGathererProvider
   }
 
   collision_detector::Gatherer GetGatherer(size_t idx) const override {
-    auto it = session_.GetDogs().begin();
-    std::advance(it, idx);
-    const auto& dog = *it->second;
+    const auto& dog = session_.GetDogs()[idx];
 
     return {
         {dog.GetState().position.x, dog.GetState().position.y},  // start_pos
         {dog.GetState().position.x + dog.GetState().speed.x * delta_time_,
          dog.GetState().position.y + dog.GetState().speed.y * delta_time_},  // end_pos
-        0.6                                                                  // Ширина игрока 0.6
+        GameSession::DOG_WIDTH
     };
   }
 
+  const Dog& GetDog(size_t gatherer_idx) const {
+    return session_.GetDogs()[gatherer_idx];
+  }
+
  private:
   const GameSession& session_;
   double delta_time_;  // Добавляем поле для хранения времени тика
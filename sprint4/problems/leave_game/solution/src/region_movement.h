@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "model.h"
+
+namespace model {
+
+/*
+ * Прежний способ перемещения собак: перебор прямоугольников всех дорог карты
+ * на каждом шаге. Сервер двигает собак по графу дорог (road_graph.h), а этот
+ * вариант оставлен как эталон для сравнительных тестов и бенчмарков.
+ */
+class RegionMovement {
+ public:
+  struct Region {
+    double min_x, max_x;
+    double min_y, max_y;
+
+    bool Contains(const MoveInfo::Position& pos) const {
+      return pos.x >= min_x && pos.x <= max_x && pos.y >= min_y && pos.y <= max_y;
+    }
+  };
+
+  explicit RegionMovement(const Map& map) {
+    for (const auto& road : map.GetRoads()) {
+      if (road.IsHorizontal()) {
+        double left_x = road.GetStart().x;
+        double right_x = road.GetEnd().x;
+        if (left_x > right_x) {
+          std::swap(left_x, right_x);
+        }
+        regions_.push_back(Region{left_x - 0.4, right_x + 0.4, road.GetStart().y - 0.4,
+                                  road.GetStart().y + 0.4});
+      } else if (road.IsVertical()) {
+        double lower_y = road.GetStart().y;
+        double upper_y = road.GetEnd().y;
+        if (lower_y > upper_y) {
+          std::swap(lower_y, upper_y);
+        }
+        regions_.push_back(Region{road.GetStart().x - 0.4, road.GetStart().x + 0.4,
+                                  lower_y - 0.4, upper_y + 0.4});
+      }
+    }
+  }
+
+  // Сдвигает собаку на её скорость за delta_time; вышедшая за дороги собака
+  // ставится на дальний край дороги, на которой стоит, и останавливается
+  void MoveDog(Dog& dog, double delta_time) const {
+    const MoveInfo::Position& position = dog.GetPosition();
+    const MoveInfo::Position new_position{position.x + dog.GetSpeed().x * delta_time,
+                                          position.y + dog.GetSpeed().y * delta_time};
+
+    if (IsWithinAnyRegion(new_position)) {
+      dog.MoveDog(new_position);
+    } else {
+      dog.MoveDog(AdjustPositionToMaxRegion(dog));
+      dog.StopDog();
+    }
+  }
+
+ private:
+  bool IsWithinAnyRegion(const MoveInfo::Position& pos) const {
+    return std::any_of(regions_.begin(), regions_.end(),
+                       [&pos](const Region& region) { return region.Contains(pos); });
+  }
+
+  MoveInfo::Position AdjustPositionToMaxRegion(const Dog& dog) const {
+    const MoveInfo::Position& current = dog.GetPosition();
+    MoveInfo::Position max_pos = current;
+    double max_diff = 0;
+
+    for (const auto& region : regions_) {
+      if (!region.Contains(current)) {
+        continue;
+      }
+      const MoveInfo::Position possible = MaxValueOfRegion(region, dog.GetDirection(), current);
+      const double dx = possible.x - current.x;
+      const double dy = possible.y - current.y;
+      const double distance = std::sqrt(dx * dx + dy * dy);
+      if (distance > max_diff) {
+        max_diff = distance;
+        max_pos = possible;
+      }
+    }
+
+    return max_pos;
+  }
+
+  static MoveInfo::Position MaxValueOfRegion(const Region& reg, MoveInfo::Direction dir,
+                                             MoveInfo::Position current_pos) {
+    MoveInfo::Position result = current_pos;
+    if (dir == MoveInfo::Direction::EAST) {
+      result.x = reg.max_x;
+    } else if (dir == MoveInfo::Direction::WEST) {
+      result.x = reg.min_x;
+    } else if (dir == MoveInfo::Direction::SOUTH) {
+      result.y = reg.max_y;
+    } else if (dir == MoveInfo::Direction::NORTH) {
+      result.y = reg.min_y;
+    }
+    return result;
+  }
+
+  std::vector<Region> regions_;
+};
+
+}  // namespace model
@@ -1,7 +1,37 @@
 #include "request_handler.h"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+
 namespace http_handler {
 
+namespace {
+
+// Длина сериализованного значения. Строка тела не создаётся: сериализатор
+// пишет по частям в буфер на стеке
+std::size_t SerializedSize(const json::value& value) {
+  json::serializer serializer;
+  serializer.reset(&value);
+  std::array<char, 4096> buffer;
+  std::size_t size = 0;
+  while (!serializer.done()) {
+    size += serializer.read(buffer.data(), buffer.size()).size();
+  }
+  return size;
+}
+
+// Значение Content-Length ответа без тела; 0, если заголовка нет
+std::size_t ContentLength(const StringResponse& response) {
+  const std::string_view value = response[http::field::content_length];
+  std::size_t length = 0;
+  std::from_chars(value.data(), value.data() + value.size(), length);
+  return length;
+}
+
+}  // namespace
+
 // BaseHandler implementation
 StringResponse BaseHandler::MakeStringResponse(http::status status, std::string_view body,
                                                unsigned http_version, bool keep_alive,
@@ -15,27 +45,44 @@ StringResponse BaseHandler::MakeStringResponse(http::status status, std::string_
 }
 
 StringResponse BaseHandler::MakeJsonResponse(http::status status, const json::value& body,
-                                             unsigned http_version, bool keep_alive) {
-  auto response = MakeStringResponse(status, json::serialize(body), http_version, keep_alive,
-                                     ContentType::APP_JSON);
+                                             unsigned http_version, bool keep_alive,
+                                             bool head_only) {
+  if (head_only) {
+    return MakeJsonHeadResponse(status, SerializedSize(body), http_version, keep_alive);
+  }
+  return MakeSerializedJsonResponse(status, json::serialize(body), http_version, keep_alive);
+}
+
+StringResponse BaseHandler::MakeSerializedJsonResponse(http::status status, std::string_view body,
+                                                       unsigned http_version, bool keep_alive,
+                                                       bool head_only) {
+  if (head_only) {
+    return MakeJsonHeadResponse(status, body.size(), http_version, keep_alive);
+  }
+  auto response =
+      MakeStringResponse(status, body, http_version, keep_alive, ContentType::APP_JSON);
   response.set(http::field::cache_control, "no-cache");
   return response;
 }
 
-StringResponse BaseHandler::MakeErrorResponse(
-    http::status status, std::string_view code, std::string_view message,
-    const std::vector<std::string_view>& allowed_methods) {
+StringResponse BaseHandler::MakeJsonHeadResponse(http::status status, std::size_t content_length,
+                                                 unsigned http_version, bool keep_alive) {
+  StringResponse response(status, http_version);
+  response.set(http::field::content_type, ContentType::APP_JSON);
+  response.set(http::field::cache_control, "no-cache");
+  // prepare_payload здесь не подходит: он выставил бы длину пустого тела
+  response.content_length(content_length);
+  response.keep_alive(keep_alive);
+  return response;
+}
+
+StringResponse BaseHandler::MakeErrorResponse(http::status status, std::string_view code,
+                                              std::string_view message, std::string_view allow) {
   json::value error = {{"code", code}, {"message", message}};
   auto response = MakeJsonResponse(status, error, 11, false);
 
-  if (status == http::status::method_not_allowed && !allowed_methods.empty()) {
-    std::string allow_header;
-    for (const auto& method : allowed_methods) {
-      if (!allow_header.empty())
-        allow_header += ", ";
-      allow_header += method;
-    }
-    response.set(http::field::allow, allow_header);
+  if (status == http::status::method_not_allowed && !allow.empty()) {
+    response.set(http::field::allow, allow);
   }
 
   return response;
@@ -49,10 +96,71 @@ StringResponse BaseHandler::MakeBadRequestError(std::string_view message) {
   return MakeErrorResponse(http::status::bad_request, "badRequest", message);
 }
 
-StringResponse BaseHandler::MakeMethodNotAllowedError(
-    const std::vector<std::string_view>& allowed_methods) {
+StringResponse BaseHandler::MakeMethodNotAllowedError(std::string_view allow) {
   return MakeErrorResponse(http::status::method_not_allowed, "invalidMethod", "Invalid method",
-                           allowed_methods);
+                           allow);
+}
+
+StringResponse BaseHandler::MakeServiceUnavailableError(std::chrono::seconds retry_after) {
+  auto response = MakeErrorResponse(http::status::service_unavailable, "serviceUnavailable",
+                                    "Server is overloaded, try again later");
+  response.set(http::field::retry_after, std::to_string(retry_after.count()));
+  return response;
+}
+
+ApiHandler::ApiHandler(app::Application& app, Strand& strand,
+                       const admission::EndpointLimits& limits, shard::ShardSet* shards)
+    : app_(app), strand_(strand), shards_(shards), admission_(limits) {
+  // Запросы рекордов ждут соединение из пула БД, поэтому их очередь короче
+  admission::EndpointLimits records_limits = limits;
+  records_limits.max_in_flight = std::min<std::size_t>(limits.max_in_flight, 16);
+  admission_.SetLimits(std::string(RECORDS_ENDPOINT), records_limits);
+
+  // Остальные эндпоинты получают собственные счётчики, чтобы перегрузка
+  // одного из них не отклоняла запросы к другим
+  for (std::string_view endpoint : {JOIN_ENDPOINT, "/api/v1/game/players"sv, "/api/v1/game/state"sv,
+                                    "/api/v1/game/player/action"sv, "/api/v1/maps"sv}) {
+    admission_.SetLimits(std::string(endpoint), limits);
+  }
+
+  // Карты у частей пока одинаковые, поэтому кеш собирается один раз
+  maps_caches_.assign(app_.GetPartitionCount(), BuildMapsCache());
+  records_caches_.resize(app_.GetPartitionCount());
+}
+
+unsigned ApiHandler::ChoosePartition(const StringRequest& req, std::string_view endpoint) {
+  if (endpoint == TICK_ENDPOINT) {
+    return 0;
+  }
+  if (endpoint == JOIN_ENDPOINT) {
+    const auto map_id = TryExtractMapId(req);
+    return map_id ? app_.ChooseJoinPartition(*map_id) : app_.GetCurrentPartition();
+  }
+  if (const auto token = TryExtractToken(req)) {
+    return app_.GetTokenPartition(*token);
+  }
+  // Карты, рекорды и запросы без токена обслуживает часть шарда, принявшего запрос
+  return app_.GetCurrentPartition();
+}
+
+ApiHandler::MapsCache& ApiHandler::GetMapsCache() {
+  auto& cache = maps_caches_[app_.GetCurrentPartition()];
+  if (cache.maps_version != app_.GetMapsVersion()) {
+    cache = BuildMapsCache();
+  }
+  return cache;
+}
+
+ApiHandler::MapsCache ApiHandler::BuildMapsCache() {
+  MapsCache cache{.maps_version = app_.GetMapsVersion()};
+  json::array maps_json;
+  for (const auto& map : app_.GetGame().GetMaps()) {
+    maps_json.push_back({{"id", *map.GetId()}, {"name", map.GetName()}});
+    cache.bodies.emplace(*map.GetId(),
+                         compression::CachedBody{json::serialize(SerializeMap(map))});
+  }
+  cache.list = compression::CachedBody{json::serialize(maps_json)};
+  return cache;
 }
 
 std::optional<model::Token> ApiHandler::TryExtractToken(const StringRequest& req) const {
@@ -74,6 +182,19 @@ std::optional<model::Token> ApiHandler::TryExtractToken(const StringRequest& req
   return model::Token(token_str);
 }
 
+std::optional<model::Map::Id> ApiHandler::TryExtractMapId(const StringRequest& req) const {
+  boost::system::error_code ec;
+  const json::value body = json::parse(req.body(), ec);
+  if (ec || !body.is_object()) {
+    return std::nullopt;
+  }
+  const json::value* map_id = body.as_object().if_contains("mapId");
+  if (!map_id || !map_id->is_string()) {
+    return std::nullopt;
+  }
+  return model::Map::Id{std::string(map_id->as_string())};
+}
+
 bool ApiHandler::ValidateContentType(const StringRequest& req) const {
   return req[http::field::content_type] == ContentType::APP_JSON;
 }
@@ -83,30 +204,115 @@ bool ApiHandler::ValidateMoveDirection(const std::string& direction) const {
          direction == "";
 }
 
-StringResponse ApiHandler::HandleGetMaps(const StringRequest& req) {
-  json::array maps_json;
-  for (const auto& map : app_.GetGame().GetMaps()) {
-    maps_json.push_back({{"id", *map.GetId()}, {"name", map.GetName()}});
+StringResponse ApiHandler::Dispatch(const StringRequest& req) {
+  using http::verb;
+  using router::MakeRoute;
+  using router::On;
+  using A = ApiHandler;
+
+  // Таблица и хеш для неё строятся при компиляции
+  static constexpr router::Router ROUTES{std::array{
+      MakeRoute("/api/v1/maps", On(verb::get, Plain<&A::HandleGetMaps>()),
+                On(verb::head, Plain<&A::HandleGetMaps>())),
+      MakeRoute("/api/v1/maps/{id}", On(verb::get, &A::HandleGetMapById),
+                On(verb::head, &A::HandleGetMapById)),
+      MakeRoute("/api/v1/game/join", On(verb::post, Plain<&A::HandleJoinGame>())),
+      MakeRoute("/api/v1/game/players", On(verb::get, Plain<&A::HandleGetPlayers>()),
+                On(verb::head, Plain<&A::HandleGetPlayers>())),
+      MakeRoute("/api/v1/game/state", On(verb::get, Plain<&A::HandleGetGameState>()),
+                On(verb::head, Plain<&A::HandleGetGameState>())),
+      MakeRoute("/api/v1/game/player/action", On(verb::post, Plain<&A::HandlePlayerAction>())),
+      MakeRoute(TICK_ENDPOINT, On(verb::post, Plain<&A::HandleGameTick>())),
+      MakeRoute(RECORDS_ENDPOINT, On(verb::get, Plain<&A::HandleGetRecords>()),
+                On(verb::head, Plain<&A::HandleGetRecords>())),
+  }};
+
+  const auto match = ROUTES.Find(req.target(), req.method());
+  StringResponse response;
+  if (match.handler) {
+    response = (this->**match.handler)(req, match.params);
+  } else if (match.IsPathFound()) {
+    response = MakeMethodNotAllowedError(match.allow);
+  } else {
+    response = MakeErrorResponse(http::status::not_found, "notFound", "Endpoint not found");
+  }
+
+  // Успешные ответы на HEAD собираются без тела, а ошибки короткие: у них тело убирается здесь.
+  // Тела, которые пришлось бы сжимать ради одной длины, описываются в несжатом виде.
+  if (IsHead(req)) {
+    if (!response.body().empty()) {
+      const std::size_t content_length = response.body().size();
+      response.body().clear();
+      response.content_length(content_length);
+    }
+    // GET с тем же Accept-Encoding получил бы сжатое тело, поэтому кеши должны
+    // различать ответы по Accept-Encoding, как и у GET (у ответов из кеша Vary уже есть)
+    if (response.count(http::field::vary) == 0 &&
+        ContentLength(response) >= compression::MIN_COMPRESSED_SIZE) {
+      response.set(http::field::vary, "Accept-Encoding");
+    }
+    return response;
   }
-  return MakeJsonResponse(http::status::ok, maps_json, req.version(), req.keep_alive());
+
+  // Сжатие выполняет HandleRequest уже вне strand
+  return response;
 }
 
-StringResponse ApiHandler::HandleGetMapById(const StringRequest& req,
-                                            const model::Map::Id& map_id) {
-  const auto* map = app_.GetGame().FindMap(map_id);
-  if (!map) {
-    return MakeErrorResponse(http::status::not_found, "mapNotFound", "Map not found");
+StringResponse ApiHandler::MakeCachedJsonResponse(const StringRequest& req,
+                                                  compression::CachedBody& body) {
+  using namespace compression;
+
+  const bool compressible = body.Identity().size() >= MIN_COMPRESSED_SIZE;
+  const Encoding encoding =
+      compressible ? ChooseEncoding(req[http::field::accept_encoding]) : Encoding::IDENTITY;
+
+  auto response = MakeSerializedJsonResponse(http::status::ok, body.Get(encoding), req.version(),
+                                             req.keep_alive(), IsHead(req));
+  if (compressible) {
+    response.set(http::field::vary, "Accept-Encoding");
+  }
+  if (encoding != Encoding::IDENTITY) {
+    response.set(http::field::content_encoding, EncodingName(encoding));
   }
+  return response;
+}
+
+bool ApiHandler::NeedsCompression(compression::Encoding encoding,
+                                  const StringResponse& response) {
+  return encoding != compression::Encoding::IDENTITY &&
+         response.body().size() >= compression::MIN_COMPRESSED_SIZE &&
+         response.count(http::field::vary) == 0;
+}
 
-  json::object map_json{{"id", *map->GetId()}, {"name", map->GetName()}};
+void ApiHandler::CompressResponse(compression::Encoding encoding, StringResponse& response) {
+  using namespace compression;
 
-  SerializeRoads(map, map_json);
-  SerializeBuildings(map, map_json);
-  SerializeOffices(map, map_json);
+  // Vary уже выставлен у ответов из кеша: их тело выбрано в нужном кодировании
+  if (response.body().size() < MIN_COMPRESSED_SIZE || response.count(http::field::vary) > 0) {
+    return;
+  }
+  response.set(http::field::vary, "Accept-Encoding");
 
-  map_json["lootTypes"] = app_.GetExtraData().GetLootTypes(map_id);
+  if (encoding == Encoding::IDENTITY) {
+    return;
+  }
+  response.body() = Compress(response.body(), encoding);
+  response.set(http::field::content_encoding, EncodingName(encoding));
+  response.content_length(response.body().size());
+}
 
-  return MakeJsonResponse(http::status::ok, map_json, req.version(), req.keep_alive());
+StringResponse ApiHandler::HandleGetMaps(const StringRequest& req) {
+  return MakeCachedJsonResponse(req, GetMapsCache().list);
+}
+
+StringResponse ApiHandler::HandleGetMapById(const StringRequest& req,
+                                            const router::PathParams& params) {
+  auto& bodies = GetMapsCache().bodies;
+  const auto it = bodies.find(std::string(params[0]));
+  if (it == bodies.end()) {
+    return MakeErrorResponse(http::status::not_found, "mapNotFound", "Map not found");
+  }
+  return MakeCachedJsonResponse(req, it->second);
 }
 
 StringResponse ApiHandler::HandleJoinGame(const StringRequest& req) {
@@ -134,17 +340,13 @@ StringResponse ApiHandler::HandleJoinGame(const StringRequest& req) {
       return MakeErrorResponse(http::status::not_found, "mapNotFound", "Map not found");
     }
 
-    auto session = app_.GetGame().FindGameSession(model::Map::Id(map_id));
-    if (!session) {
+    const auto* player = app_.JoinGame(model::Map::Id(map_id), user_name);
+    if (!player) {
       return MakeErrorResponse(http::status::internal_server_error, "internalError",
                                "Failed to create game session");
     }
 
-    auto dog = std::make_shared<model::Dog>(user_name);
-    dog->SetDefaultDogSpeed(session->GetMapDefaultSpeed());
-    auto token = app_.GetPlayers().AddPlayer(dog, session);
-
-    json::object response{{"authToken", *token}, {"playerId", dog->GetId()}};
+    json::object response{{"authToken", *player->GetToken()}, {"playerId", player->GetDogId()}};
 
     return MakeJsonResponse(http::status::ok, response, req.version(), req.keep_alive());
 
@@ -157,74 +359,103 @@ StringResponse ApiHandler::HandleJoinGame(const StringRequest& req) {
 
 StringResponse ApiHandler::HandleGetPlayers(const StringRequest& req) {
   return ExecuteAuthorized(req, [this, &req](const model::Player& player) {
-    auto game_session = player.GetGameSession();
+    const auto& game_session = player.GetGameSession();
     json::object players_json;
 
-    for (const auto& [dog_id, dog] : game_session->GetDogs()) {
-      players_json[std::to_string(dog_id)] = json::object{{"name", dog->GetName()}};
+    for (const auto& dog : game_session.GetDogs()) {
+      players_json[std::to_string(dog.GetId())] = json::object{{"name", dog.GetName()}};
     }
 
-    return MakeJsonResponse(http::status::ok, players_json, req.version(), req.keep_alive());
+    return MakeJsonResponse(http::status::ok, players_json, req.version(), req.keep_alive(),
+                            IsHead(req));
   });
 }
 
 StringResponse ApiHandler::HandleGetGameState(const StringRequest& req) {
   return ExecuteAuthorized(req, [this, &req](const model::Player& player) {
-    auto game_session = player.GetGameSession();
-    json::object players_json;
-    json::object lost_objects_json;
-
-    // Сериализация игроков
-    for (const auto& [dog_id, dog] : game_session->GetDogs()) {
-      const auto& state = dog->GetState();
-
-      std::string direction;
-      switch (state.direction) {
-        case MoveInfo::Direction::NORTH:
-          direction = "U";
-          break;
-        case MoveInfo::Direction::SOUTH:
-          direction = "D";
-          break;
-        case MoveInfo::Direction::WEST:
-          direction = "L";
-          break;
-        case MoveInfo::Direction::EAST:
-          direction = "R";
-          break;
-        default:
-          assert(false && "Unexpected direction in MoveInfo::Direction");
-      }
+    const auto& game_session = player.GetGameSession();
 
-      json::array bag_json;
-      const auto& bag_items = dog->GetBag().GetItems();
-      for (size_t i = 0; i < bag_items.size(); ++i) {
-        bag_json.push_back(
-            json::object{{"id", static_cast<int>(i)}, {"type", static_cast<int>(bag_items[i])}});
-      }
-
-      players_json[std::to_string(dog_id)] = {
-          {"pos", json::array{state.position.x, state.position.y}},
-          {"speed", json::array{state.speed.x, state.speed.y}},
-          {"dir", direction},
-          {"bag", bag_json},
-          {"score", dog->GetScore()}  // Добавляем счет игрока
-      };
+    std::optional<util::InterestArea> area;
+    try {
+      area = ParseInterestArea(req, player.GetDog());
+    } catch (const std::invalid_argument& ex) {
+      return MakeErrorResponse(http::status::bad_request, "invalidArgument", ex.what());
     }
 
-    // Сериализация потерянных объектов
-    size_t loot_id = 0;
-    for (const auto& loot : game_session->GetLoots()) {
-      lost_objects_json[std::to_string(loot_id++)] = {
-          {"type", loot.type}, {"pos", json::array{loot.position.x, loot.position.y}}};
+    // HEAD получает только длину ответа, объекты ответа для неё не строятся
+    if (IsHead(req)) {
+      return MakeJsonHeadResponse(http::status::ok,
+                                  game_state::SerializedSessionSize(game_session, area),
+                                  req.version(), req.keep_alive());
     }
 
-    json::object response{{"players", players_json}, {"lostObjects", lost_objects_json}};
+    // Без области интереса в ответ попадает вся сессия
+    const json::object response = game_state::SerializeSession(game_session, area);
 
     return MakeJsonResponse(http::status::ok, response, req.version(), req.keep_alive());
   });
 }
 
+std::optional<util::InterestArea> ApiHandler::ParseInterestArea(const StringRequest& req,
+                                                                const model::Dog& dog) const {
+  const auto parsed_url = boost::urls::parse_origin_form(req.target());
+  if (!parsed_url.has_value()) {
+    return std::nullopt;
+  }
+
+  std::optional<double> radius;
+  std::array<std::optional<double>, 4> viewport;  // x0, y0, x1, y1
+  static constexpr std::array<std::string_view, 4> VIEWPORT_KEYS = {"x0", "y0", "x1", "y1"};
+
+  const auto parse_number = [](std::string_view key, std::string_view value) {
+    double number = NAN;
+    try {
+      number = boost::lexical_cast<double>(std::string(value));
+    } catch (const boost::bad_lexical_cast&) {
+    }
+    if (!std::isfinite(number)) {
+      throw std::invalid_argument(std::string(key) + " must be a number");
+    }
+    return number;
+  };
+
+  for (const auto& param : parsed_url->params()) {
+    if (param.key == "radius") {
+      radius = parse_number(param.key, param.value);
+      if (*radius < 0) {
+        throw std::invalid_argument("radius must not be negative");
+      }
+      continue;
+    }
+    for (size_t i = 0; i < VIEWPORT_KEYS.size(); ++i) {
+      if (param.key == VIEWPORT_KEYS[i]) {
+        viewport[i] = parse_number(param.key, param.value);
+      }
+    }
+  }
+
+  const auto given = std::count_if(viewport.begin(), viewport.end(),
+                                   [](const auto& value) { return value.has_value(); });
+  if (given != 0 && given != static_cast<std::ptrdiff_t>(viewport.size())) {
+    throw std::invalid_argument("Viewport requires x0, y0, x1 and y1");
+  }
+  if (given != 0 && radius) {
+    throw std::invalid_argument("Use either radius or viewport");
+  }
+
+  if (radius) {
+    const auto& position = dog.GetPosition();
+    return util::InterestArea::Circle({position.x, position.y}, *radius);
+  }
+  if (given != 0) {
+    return util::InterestArea::Rect({std::min(*viewport[0], *viewport[2]),
+                                     std::min(*viewport[1], *viewport[3])},
+                                    {std::max(*viewport[0], *viewport[2]),
+                                     std::max(*viewport[1], *viewport[3])});
+  }
+  return std::nullopt;
+}
+
 StringResponse ApiHandler::HandlePlayerAction(const StringRequest& req) {
   if (!ValidateContentType(req)) {
     return MakeBadRequestError("Invalid content type");
@@ -247,29 +478,7 @@ StringResponse ApiHandler::HandlePlayerAction(const StringRequest& req) {
     }
 
     return ExecuteAuthorized(req, [this, req, move_direction](model::Player& player) {
-      auto game_session = player.GetGameSession();
-      auto dog_id = player.GetDogId();
-      auto dogs = game_session->GetDogs();
-      auto dog_it = dogs.find(dog_id);
-
-      if (dog_it == dogs.end()) {
-        return MakeErrorResponse(http::status::internal_server_error, "internalError",
-                                 "Dog not found in game session");
-      }
-
-      auto dog = dog_it->second;
-
-      if (!move_direction.empty()) {
-        player.SetTryingToMove(true);
-        player.SetStopTime(0);  // активность — сброс
-      } else {
-        player.SetTryingToMove(false);
-        if (player.GetStopTime() == 0) {
-          player.CheckActivityDog(0);  // запуск отсчёта бездействия
-        }
-      }
-
-      dog->SetDogDirSpeed(move_direction);
+      app_.ApplyPlayerAction(player, move_direction);
 
       return MakeJsonResponse(http::status::ok, json::object{}, req.version(), req.keep_alive());
     });
@@ -359,20 +568,54 @@ StringResponse ApiHandler::HandleGetRecords(const StringRequest& req) {
       }
     }
 
-    auto result = app_.GetDatabase().GetRetiredPlayers(start, maxItems);
+    return MakeCachedJsonResponse(req, GetRecordsBody(start, maxItems));
 
-    array records;
-    for (const auto& row : result) {
-      records.emplace_back(object{{"name", row["name"].c_str()},
-                                  {"score", row["score"].as<int>()},
-                                  {"playTime", row["play_time"].as<double>()}});
-    }
+  } catch (const std::exception& ex) {
+    return MakeJsonResponse(http::status::ok, array{}, req.version(), req.keep_alive(),
+                            IsHead(req));
+  }
+}
 
-    return MakeJsonResponse(http::status::ok, records, req.version(), req.keep_alive());
+compression::CachedBody& ApiHandler::GetRecordsBody(int start, int max_items) {
+  auto& database = app_.GetDatabase();
+  auto& records_cache = records_caches_[app_.GetCurrentPartition()];
 
-  } catch (const std::exception& ex) {
-    return MakeJsonResponse(http::status::ok, array{}, req.version(), req.keep_alive());
+  // Версия читается до запроса: запись, сделанная во время него, сбросит кеш в следующий раз
+  const std::uint64_t db_version = database.GetVersion();
+  if (records_cache.db_version != db_version) {
+    records_cache.bodies.clear();
+    records_cache.db_version = db_version;
+  }
+
+  const std::uint64_t key = (std::uint64_t{static_cast<std::uint32_t>(start)} << 32) |
+                            static_cast<std::uint32_t>(max_items);
+  if (auto it = records_cache.bodies.find(key); it != records_cache.bodies.end()) {
+    return it->second;
   }
+
+  json::array records;
+  for (const auto& row : database.GetRetiredPlayers(start, max_items)) {
+    records.emplace_back(json::object{{"name", row["name"].c_str()},
+                                      {"score", row["score"].as<int>()},
+                                      {"playTime", row["play_time"].as<double>()}});
+  }
+
+  if (records_cache.bodies.size() >= RecordsCache::MAX_ENTRIES) {
+    records_cache.bodies.clear();
+  }
+  return records_cache.bodies.emplace(key, compression::CachedBody{json::serialize(records)})
+      .first->second;
+}
+
+json::object ApiHandler::SerializeMap(const model::Map& map) const {
+  json::object map_json{{"id", *map.GetId()}, {"name", map.GetName()}};
+
+  SerializeRoads(&map, map_json);
+  SerializeBuildings(&map, map_json);
+  SerializeOffices(&map, map_json);
+
+  map_json["lootTypes"] = app_.GetExtraData().GetLootTypes(map.GetId());
+  return map_json;
 }
 
 void ApiHandler::SerializeRoads(const model::Map* map, json::object& map_json) const {
@@ -2,6 +2,8 @@
 #include <boost/json/serialize.hpp>
 #include <boost/json/serializer.hpp>
 #include "application.h"
+#include "admission_control.h"
+#include "metrics.h"
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
 #include <boost/json.hpp>
@@ -13,9 +15,16 @@
 #include "model.h"
 #include "tagged.h"
 #include "extra_data.h"
+#include "game_state.h"
+#include "compression.h"
+#include "router.h"
+#include "shard.h"
 
+#include <cstdint>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <filesystem>
 #include <optional>
 
@@ -37,6 +46,7 @@ struct ContentType {
   constexpr static std::string_view APP_JSON = "application/json";
   constexpr static std::string_view OCTET_STREAM = "application/octet-stream";
   constexpr static std::string_view TEXT_PLAIN = "text/plain";
+  constexpr static std::string_view PROMETHEUS_TEXT = "text/plain; version=0.0.4";
 };
 
 // Базовый класс для обработчиков
@@ -46,92 +56,178 @@ class BaseHandler {
                                     unsigned http_version, bool keep_alive,
                                     std::string_view content_type = ContentType::TEXT_HTML);
 
+  // Для ответа на HEAD (head_only) тело не сериализуется в строку, считается только
+  // его длина для Content-Length
   StringResponse MakeJsonResponse(http::status status, const json::value& body,
-                                  unsigned http_version, bool keep_alive);
-
+                                  unsigned http_version, bool keep_alive, bool head_only = false);
+  // То же для заранее сериализованного тела
+  StringResponse MakeSerializedJsonResponse(http::status status, std::string_view body,
+                                            unsigned http_version, bool keep_alive,
+                                            bool head_only = false);
+  // Заголовки ответа без тела с заданным Content-Length
+  StringResponse MakeJsonHeadResponse(http::status status, std::size_t content_length,
+                                      unsigned http_version, bool keep_alive);
+
+  // allow - значение заголовка Allow для ответа 405
   StringResponse MakeErrorResponse(http::status status, std::string_view code,
-                                   std::string_view message,
-                                   const std::vector<std::string_view>& allowed_methods = {});
+                                   std::string_view message, std::string_view allow = {});
 
   StringResponse MakeUnauthorizedError(
       std::string_view message = "Authorization header is missing");
   StringResponse MakeBadRequestError(std::string_view message = "Bad request");
-  StringResponse MakeMethodNotAllowedError(const std::vector<std::string_view>& allowed_methods);
+  StringResponse MakeMethodNotAllowedError(std::string_view allow);
+  StringResponse MakeServiceUnavailableError(std::chrono::seconds retry_after);
 };
 
 // Обработчик API запросов
 class ApiHandler : public BaseHandler {
  public:
-  explicit ApiHandler(app::Application& app, Strand& strand) : app_(app), strand_(strand) {
-  }
+  // Если заданы шарды, запрос выполняется в потоке шарда, часть игры которого он касается,
+  // а не в strand. Создаётся после того, как игра поделена на части.
+  explicit ApiHandler(app::Application& app, Strand& strand,
+                      const admission::EndpointLimits& limits,
+                      shard::ShardSet* shards = nullptr);
 
   template <typename Body, typename Allocator, typename Send>
   void HandleRequest(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
-    auto handle = [this, safe_req = http::request<Body, http::basic_fields<Allocator>>(req),
-                   send = std::forward<Send>(send)]() mutable {
-      static const std::unordered_map<
-          std::string_view,
-          std::vector<std::pair<http::verb, StringResponse (ApiHandler::*)(const StringRequest&)>>>
-          handlers = {
-              {"/api/v1/game/join", {{http::verb::post, &ApiHandler::HandleJoinGame}}},
-              {"/api/v1/game/players",
-               {{http::verb::get, &ApiHandler::HandleGetPlayers},
-                {http::verb::head, &ApiHandler::HandleGetPlayers}}},
-              {"/api/v1/maps",
-               {{http::verb::get, &ApiHandler::HandleGetMaps},
-                {http::verb::head, &ApiHandler::HandleGetMaps}}},
-              {"/api/v1/game/records",
-               {{http::verb::get, &ApiHandler::HandleGetRecords},
-                {http::verb::head, &ApiHandler::HandleGetRecords}}},
-              {"/api/v1/game/state",
-               {{http::verb::get, &ApiHandler::HandleGetGameState},
-                {http::verb::head, &ApiHandler::HandleGetGameState}}},
-              {"/api/v1/game/player/action", {{http::verb::post, &ApiHandler::HandlePlayerAction}}},
-              {"/api/v1/game/tick", {{http::verb::post, &ApiHandler::HandleGameTick}}}};
-
-      std::string_view target = safe_req.target();
-      size_t query_start = target.find('?');
-      std::string_view base_path = target.substr(0, query_start);
-
-      auto it = handlers.find(base_path);
-      if (it != handlers.end()) {
-        for (const auto& [verb, handler] : it->second) {
-          if (verb == safe_req.method()) {
-            return send((this->*handler)(safe_req));
-          }
-        }
-        std::vector<std::string_view> allowed_methods;
-        for (const auto& [m, _] : it->second) {
-          allowed_methods.push_back(boost::beast::http::to_string(m));
-        }
-        return send(MakeMethodNotAllowedError(allowed_methods));
+    std::string_view endpoint = req.target().substr(0, req.target().find('?'));
+    const bool tick = endpoint == TICK_ENDPOINT;
+    const unsigned partition = shards_ ? ChoosePartition(req, endpoint) : 0;
+
+    // Запрос, которому не хватило места в очереди, отклоняется сразу, не попадая в strand.
+    // Ручной тик не ограничивается: тики приоритетнее остальных запросов.
+    std::optional<admission::AdmissionController::Ticket> ticket;
+    if (!tick) {
+      ticket = admission_.TryAdmit(endpoint);
+      if (!ticket) {
+        return send(MakeServiceUnavailableError(admission_.GetRetryAfter(endpoint)));
       }
+    }
 
-      if (safe_req.target().starts_with("/api/v1/maps/") &&
-          safe_req.target().size() > strlen("/api/v1/maps/")) {
-        auto map_id =
-            model::Map::Id{std::string(safe_req.target().substr(strlen("/api/v1/maps/")))};
-        if (safe_req.method() == http::verb::get || safe_req.method() == http::verb::head) {
-          return send(HandleGetMapById(safe_req, map_id));
-        } else {
-          return send(MakeMethodNotAllowedError({"GET", "HEAD"}));
-        }
+    auto& queue_depth = metrics::Server().strand_queue_depth;
+    queue_depth.Add(1);
+
+    // Тело, сформированное для этого запроса, сжимается уже вне strand игры:
+    // сжатие большого состояния заняло бы strand на время, сравнимое с тиком
+    const auto encoding = compression::ChooseEncoding(req[http::field::accept_encoding]);
+    auto finish = [encoding, send = std::forward<Send>(send)](StringResponse&& response) mutable {
+      CompressResponse(encoding, response);
+      send(std::move(response));
+    };
+
+    auto handle = [this, ticket = std::move(ticket), safe_req = std::move(req),
+                   &queue_depth]() mutable -> StringResponse {
+      queue_depth.Add(-1);
+
+      // Просроченный тик выполняется раньше запросов, стоявших перед ним в очереди
+      app_.RunOverdueTick();
+
+      if (ticket && ticket->IsExpired()) {
+        return MakeServiceUnavailableError(ticket->GetRetryAfter());
       }
 
-      return send(MakeErrorResponse(http::status::not_found, "notFound", "Endpoint not found"));
+      return Dispatch(safe_req);
     };
 
-    net::dispatch(strand_, std::move(handle));
+    if (shards_) {
+      return ForwardToPartition(partition, tick, std::move(handle), std::move(finish));
+    }
+    net::dispatch(strand_, [this, encoding, handle = std::move(handle),
+                            finish = std::move(finish)]() mutable {
+      StringResponse response = handle();
+      if (!NeedsCompression(encoding, response)) {
+        return finish(std::move(response));
+      }
+      net::post(strand_.get_inner_executor(),
+                [finish = std::move(finish), response = std::move(response)]() mutable {
+                  finish(std::move(response));
+                });
+    });
   }
 
  private:
+  static constexpr std::string_view JOIN_ENDPOINT = "/api/v1/game/join";
+  static constexpr std::string_view TICK_ENDPOINT = "/api/v1/game/tick";
+  static constexpr std::string_view RECORDS_ENDPOINT = "/api/v1/game/records";
+
+  // Описания карт одной версии набора карт, сериализованные и сжимаемые один раз
+  struct MapsCache {
+    std::uint64_t maps_version = 0;
+    compression::CachedBody list;
+    std::unordered_map<std::string, compression::CachedBody> bodies;
+  };
+
+  // Кеш ответов /api/v1/game/records для одной версии таблицы рекордов
+  struct RecordsCache {
+    static constexpr std::size_t MAX_ENTRIES = 64;
+
+    std::uint64_t db_version = 0;
+    // Ключ - (start << 32) | maxItems, значение - сериализованный массив рекордов
+    std::unordered_map<std::uint64_t, compression::CachedBody> bodies;
+  };
+
   app::Application& app_;
   Strand& strand_;
+  shard::ShardSet* shards_;
+  admission::AdmissionController admission_;
+
+  // Кеши частей игры; кеш части используется только в её потоке, как и обработчики
+  std::vector<MapsCache> maps_caches_;
+  std::vector<RecordsCache> records_caches_;
+
+  // Часть игры, в которой выполняется запрос: часть игрока с токеном запроса, часть,
+  // выбранная для входа на карту, или часть шарда, принявшего запрос. Ручной тик
+  // начинается в потоке тиков (шард 0).
+  unsigned ChoosePartition(const StringRequest& req, std::string_view endpoint);
+
+  // Запрос уходит в очередь шарда части, а готовый ответ - обратно в очередь шарда,
+  // принявшего соединение, где finish его сжимает и отправляет. Оба перехода между
+  // потоками идут через очереди без блокировок. Ответ на ручной тик (after_ticks)
+  // отправляется, когда тик завершится во всех частях.
+  template <typename Handle, typename Finish>
+  void ForwardToPartition(unsigned partition, bool after_ticks, Handle&& handle,
+                          Finish&& finish) {
+    (*shards_)[partition].Post([this, after_ticks, handle = std::forward<Handle>(handle),
+                                finish = std::forward<Finish>(finish),
+                                origin = shard::Shard::Current()]() mutable {
+      auto reply = [origin, finish = std::move(finish), response = handle()]() mutable {
+        if (!origin) {
+          return finish(std::move(response));
+        }
+        origin->Post([finish = std::move(finish), response = std::move(response)]() mutable {
+          finish(std::move(response));
+        });
+      };
+      if (!after_ticks) {
+        return reply();
+      }
+      app_.AfterTicks([reply = std::make_shared<decltype(reply)>(std::move(reply))] {
+        (*reply)();
+      });
+    });
+  }
 
   // Вспомогательные методы
   std::optional<model::Token> TryExtractToken(const StringRequest& req) const;
+  // Карта из тела запроса на вход в игру, если тело разбирается
+  std::optional<model::Map::Id> TryExtractMapId(const StringRequest& req) const;
   bool ValidateContentType(const StringRequest& req) const;
   bool ValidateMoveDirection(const std::string& direction) const;
+  static bool IsHead(const StringRequest& req) {
+    return req.method() == http::verb::head;
+  }
+
+  // Ответ с неизменяемым телом в кодировании, которое принимает клиент
+  StringResponse MakeCachedJsonResponse(const StringRequest& req, compression::CachedBody& body);
+  // Тело, сформированное для этого запроса, достаточно длинное, чтобы его сжать в encoding.
+  // Ответы из кеша (с Vary) уже в нужном кодировании.
+  static bool NeedsCompression(compression::Encoding encoding, const StringResponse& response);
+  // Сжимает такое тело; вызывается вне strand игры
+  static void CompressResponse(compression::Encoding encoding, StringResponse& response);
+  // Область интереса из параметров radius (вокруг собаки игрока) или x0, y0, x1, y1.
+  // nullopt, если параметров нет; std::invalid_argument, если они заданы неверно.
+  std::optional<util::InterestArea> ParseInterestArea(const StringRequest& req,
+                                                      const model::Dog& dog) const;
 
   // Шаблонный метод для авторизованных запросов
   template <typename Fn>
@@ -149,9 +245,26 @@ class ApiHandler : public BaseHandler {
     return action(*player);
   }
 
+  // Выбирает обработчик по таблице маршрутов
+  StringResponse Dispatch(const StringRequest& req);
+
+  using RouteHandler = StringResponse (ApiHandler::*)(const StringRequest&,
+                                                      const router::PathParams&);
+
+  // Обработчик маршрута без параметров пути
+  template <StringResponse (ApiHandler::*Handle)(const StringRequest&)>
+  StringResponse WithoutParams(const StringRequest& req, const router::PathParams&) {
+    return (this->*Handle)(req);
+  }
+
+  template <StringResponse (ApiHandler::*Handle)(const StringRequest&)>
+  static constexpr RouteHandler Plain() {
+    return &ApiHandler::WithoutParams<Handle>;
+  }
+
   // Обработчики эндпоинтов
   StringResponse HandleGetMaps(const StringRequest& req);
-  StringResponse HandleGetMapById(const StringRequest& req, const model::Map::Id& map_id);
+  StringResponse HandleGetMapById(const StringRequest& req, const router::PathParams& params);
   StringResponse HandleJoinGame(const StringRequest& req);
   StringResponse HandleGetPlayers(const StringRequest& req);
   StringResponse HandleGetGameState(const StringRequest& req);
@@ -159,7 +272,14 @@ class ApiHandler : public BaseHandler {
   StringResponse HandleGameTick(const StringRequest& req);
   StringResponse HandleGetRecords(const StringRequest& req);
 
+  // Описания карт текущей части; пересобираются после перезагрузки карт
+  MapsCache& GetMapsCache();
+  MapsCache BuildMapsCache();
+  // Тело ответа с рекордами; запрос к БД выполняется, только если его нет в кеше
+  compression::CachedBody& GetRecordsBody(int start, int max_items);
+
   // Сериализаторы
+  json::object SerializeMap(const model::Map& map) const;
   void SerializeRoads(const model::Map* map, json::object& map_json) const;
   void SerializeBuildings(const model::Map* map, json::object& map_json) const;
   void SerializeOffices(const model::Map* map, json::object& map_json) const;
@@ -175,7 +295,7 @@ class StaticHandler : public BaseHandler {
   template <typename Body, typename Allocator, typename Send>
   void HandleRequest(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
     if (req.method() != http::verb::get && req.method() != http::verb::head) {
-      send(MakeMethodNotAllowedError({"GET", "HEAD"}));
+      send(MakeMethodNotAllowedError("GET, HEAD"));
       return;
     }
 
@@ -228,12 +348,41 @@ class StaticHandler : public BaseHandler {
   std::string UrlDecode(std::string_view str) const;
 };
 
+// Обработчик /metrics: метрики сервера в текстовом формате Prometheus.
+// Не использует strand игры, поэтому отвечает и при перегрузке API.
+class MetricsHandler : public BaseHandler {
+ public:
+  static constexpr std::string_view TARGET = "/metrics";
+
+  template <typename Body, typename Allocator, typename Send>
+  void HandleRequest(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
+    if (req.method() != http::verb::get && req.method() != http::verb::head) {
+      send(MakeMethodNotAllowedError("GET, HEAD"));
+      return;
+    }
+
+    auto response =
+        MakeStringResponse(http::status::ok, metrics::DefaultRegistry().Serialize(), req.version(),
+                           req.keep_alive(), ContentType::PROMETHEUS_TEXT);
+    response.set(http::field::cache_control, "no-cache");
+    // Beast отправляет тело и в ответе на HEAD, поэтому остаётся только его длина
+    if (req.method() == http::verb::head) {
+      const std::size_t content_length = response.body().size();
+      response.body().clear();
+      response.content_length(content_length);
+    }
+    send(std::move(response));
+  }
+};
+
 // Основной обработчик запросов
 class RequestHandler {
  public:
   explicit RequestHandler(app::Application& app, Strand& strand,
-                          const std::filesystem::path& static_root)
-      : api_handler_(app, strand), static_handler_(static_root) {
+                          const std::filesystem::path& static_root,
+                          const admission::EndpointLimits& api_limits = {},
+                          shard::ShardSet* shards = nullptr)
+      : api_handler_(app, strand, api_limits, shards), static_handler_(static_root) {
   }
 
   template <typename Body, typename Allocator, typename Send>
@@ -242,6 +391,8 @@ class RequestHandler {
 
     if (target.starts_with("/api/")) {
       api_handler_.HandleRequest(std::move(req), std::forward<Send>(send));
+    } else if (target == MetricsHandler::TARGET) {
+      metrics_handler_.HandleRequest(std::move(req), std::forward<Send>(send));
     } else {
       static_handler_.HandleRequest(std::move(req), std::forward<Send>(send));
     }
@@ -249,6 +400,7 @@ class RequestHandler {
 
  private:
   ApiHandler api_handler_;
+  MetricsHandler metrics_handler_;
   StaticHandler static_handler_;
 };
 
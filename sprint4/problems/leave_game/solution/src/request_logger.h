@@ -1,6 +1,7 @@
 #pragma once
 #include "request_handler.h"
 #include "log.h" 
+#include "metrics.h"
 #include <boost/beast/http.hpp>
 #include <chrono>
 
@@ -36,10 +37,12 @@ template <typename Body, typename Allocator, typename Send>
 void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
     LogRequest(req);
     const auto start_time = steady_clock::now();
+    const auto endpoint = metrics::RequestMetrics::Classify(req.target());
 
     // Оборачиваем отправку ответа, чтобы залогировать ответ в момент отправки
-    auto wrapped_send = [start_time, &send](auto&& response) {
-        auto duration = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+    auto wrapped_send = [start_time, endpoint, send = std::forward<Send>(send)](auto&& response) {
+        const auto elapsed = steady_clock::now() - start_time;
+        auto duration = duration_cast<milliseconds>(elapsed).count();
 
         std::string content_type;
         if (response.find(http::field::content_type) != response.end()) {
@@ -48,6 +51,7 @@ void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&&
 
         // Получаем статус
         int status = response.result_int();
+        metrics::Server().requests.Record(endpoint, status, elapsed);
 
         LogResponse(duration, status, content_type.empty() ? "null" : content_type);
         send(std::forward<decltype(response)>(response));
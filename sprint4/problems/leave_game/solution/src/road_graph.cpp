@@ -0,0 +1,158 @@
+#include "road_graph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace road_graph {
+
+namespace {
+
+bool Intersects(const Segment& lhs, const Segment& rhs) noexcept {
+  return lhs.min[0] <= rhs.max[0] && rhs.min[0] <= lhs.max[0] && lhs.min[1] <= rhs.max[1] &&
+         rhs.min[1] <= lhs.max[1];
+}
+
+double Coord(geom::Point2D point, int axis) noexcept {
+  return axis == 0 ? point.x : point.y;
+}
+
+}  // namespace
+
+std::int32_t RoadGraph::CellCoord(double value) noexcept {
+  return static_cast<std::int32_t>(std::floor(value / CELL_SIZE));
+}
+
+RoadGraph::CellKey RoadGraph::MakeKey(std::int32_t x, std::int32_t y) noexcept {
+  return (static_cast<CellKey>(static_cast<std::uint32_t>(x)) << 32) |
+         static_cast<std::uint32_t>(y);
+}
+
+SegmentId RoadGraph::AddRoad(geom::Point2D start, geom::Point2D end) {
+  Segment segment;
+  if (start.y == end.y) {
+    const auto [x0, x1] = std::minmax(start.x, end.x);
+    segment.min[0] = x0 - HALF_WIDTH;
+    segment.max[0] = x1 + HALF_WIDTH;
+    segment.min[1] = start.y - HALF_WIDTH;
+    segment.max[1] = start.y + HALF_WIDTH;
+  } else {
+    const auto [y0, y1] = std::minmax(start.y, end.y);
+    segment.min[0] = start.x - HALF_WIDTH;
+    segment.max[0] = start.x + HALF_WIDTH;
+    segment.min[1] = y0 - HALF_WIDTH;
+    segment.max[1] = y1 + HALF_WIDTH;
+  }
+
+  const auto id = static_cast<SegmentId>(segments_.size());
+
+  // Соседи ищутся среди сегментов, делящих с новым хотя бы одну ячейку
+  std::vector<SegmentId> candidates;
+  for (auto x = CellCoord(segment.min[0]); x <= CellCoord(segment.max[0]); ++x) {
+    for (auto y = CellCoord(segment.min[1]); y <= CellCoord(segment.max[1]); ++y) {
+      auto& cell = cells_[MakeKey(x, y)];
+      candidates.insert(candidates.end(), cell.begin(), cell.end());
+      cell.push_back(id);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  for (const SegmentId other : candidates) {
+    if (Intersects(segment, segments_[other])) {
+      segment.neighbors.push_back(other);
+      segments_[other].neighbors.push_back(id);
+    }
+  }
+
+  segments_.push_back(std::move(segment));
+  return id;
+}
+
+SegmentId RoadGraph::FindSegment(geom::Point2D point) const {
+  auto it = cells_.find(MakeKey(CellCoord(point.x), CellCoord(point.y)));
+  if (it == cells_.end()) {
+    return NO_SEGMENT;
+  }
+  for (const SegmentId id : it->second) {
+    if (segments_[id].Contains(point)) {
+      return id;
+    }
+  }
+  return NO_SEGMENT;
+}
+
+MoveResult RoadGraph::Move(geom::Point2D from, SegmentId hint, geom::Vec2D delta) const {
+  const SegmentId start = hint < segments_.size() && segments_[hint].Contains(from)
+                              ? hint
+                              : FindSegment(from);
+
+  if (delta.x == 0 && delta.y == 0) {
+    return {from, start, false};
+  }
+
+  if (start != NO_SEGMENT && (delta.x == 0 || delta.y == 0)) {
+    return delta.x != 0 ? MoveAlongAxis(from, start, 0, delta.x)
+                        : MoveAlongAxis(from, start, 1, delta.y);
+  }
+
+  // Точка вне дорог или движется по диагонали: путь не прослеживается,
+  // принимается только конечная точка на дороге
+  const geom::Point2D target = from + delta;
+  if (const SegmentId segment = FindSegment(target); segment != NO_SEGMENT) {
+    return {target, segment, false};
+  }
+  return {from, start, true};
+}
+
+MoveResult RoadGraph::MoveAlongAxis(geom::Point2D from, SegmentId start, int axis,
+                                    double delta) const {
+  const int lateral_axis = 1 - axis;
+  const double lateral = Coord(from, lateral_axis);
+  const bool forward = delta > 0;
+  const double target = Coord(from, axis) + delta;
+
+  // Край текущего сегмента в направлении движения
+  const auto edge = [axis, forward](const Segment& segment) {
+    return forward ? segment.max[axis] : segment.min[axis];
+  };
+  const auto is_further = [forward](double lhs, double rhs) {
+    return forward ? lhs > rhs : lhs < rhs;
+  };
+
+  SegmentId current = start;
+  double reach = edge(segments_[current]);
+
+  // Переход к соседу, который лежит на той же линии, начинается не дальше
+  // достигнутого края и уходит дальше всех. Сосед соседа, уходящий ещё дальше,
+  // пересекается и с выбранным, поэтому жадный выбор не теряет путей.
+  while (is_further(target, reach)) {
+    SegmentId best = NO_SEGMENT;
+    double best_reach = reach;
+    for (const SegmentId id : segments_[current].neighbors) {
+      const Segment& segment = segments_[id];
+      if (lateral < segment.min[lateral_axis] || lateral > segment.max[lateral_axis]) {
+        continue;
+      }
+      const double near_edge = forward ? segment.min[axis] : segment.max[axis];
+      if (is_further(near_edge, reach) || !is_further(edge(segment), best_reach)) {
+        continue;
+      }
+      best = id;
+      best_reach = edge(segment);
+    }
+    if (best == NO_SEGMENT) {
+      break;
+    }
+    current = best;
+    reach = best_reach;
+  }
+
+  const bool stopped = is_further(target, reach);
+  const double along = stopped ? reach : target;
+  const geom::Point2D position = axis == 0 ? geom::Point2D{along, lateral}
+                                           : geom::Point2D{lateral, along};
+  return {position, current, stopped};
+}
+
+}  // namespace road_graph
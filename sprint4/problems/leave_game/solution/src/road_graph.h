@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "geom.h"
+
+namespace road_graph {
+
+using SegmentId = std::uint32_t;
+inline constexpr SegmentId NO_SEGMENT = UINT32_MAX;
+
+// Расстояние от оси дороги до её края
+inline constexpr double HALF_WIDTH = 0.4;
+
+// Прямоугольник, занимаемый дорогой с учётом ширины.
+// Индекс 0 относится к оси X, индекс 1 - к оси Y.
+struct Segment {
+  double min[2];
+  double max[2];
+  // Сегменты, прямоугольники которых пересекаются с этим или касаются его
+  std::vector<SegmentId> neighbors;
+
+  bool Contains(geom::Point2D point) const noexcept {
+    return point.x >= min[0] && point.x <= max[0] && point.y >= min[1] && point.y <= max[1];
+  }
+};
+
+struct MoveResult {
+  geom::Point2D position;
+  // Сегмент, в котором оказалась точка; подсказка для следующего шага
+  SegmentId segment = NO_SEGMENT;
+  // Точка упёрлась в край дорог и не прошла весь путь
+  bool stopped = false;
+};
+
+/*
+ * Граф дорог карты. Сегменты и списки соседей строятся при добавлении дорог,
+ * поэтому шаг перемещения проходит только по текущему сегменту и его соседям
+ * на пути, а не по всем дорогам карты.
+ */
+class RoadGraph {
+ public:
+  // Добавляет дорогу от start до end, параллельную одной из осей
+  SegmentId AddRoad(geom::Point2D start, geom::Point2D end);
+
+  std::size_t SegmentsCount() const noexcept {
+    return segments_.size();
+  }
+
+  const Segment& GetSegment(SegmentId id) const {
+    return segments_.at(id);
+  }
+
+  // Сегмент, содержащий точку, или NO_SEGMENT
+  SegmentId FindSegment(geom::Point2D point) const;
+
+  /*
+   * Сдвигает точку на delta вдоль одной из осей, не выходя за пределы дорог.
+   * hint - сегмент, в котором точка была на прошлом шаге; если точка в нём
+   * уже не лежит, сегмент ищется заново. Путь, упирающийся в край дорог,
+   * обрывается на этом краю, и результат помечается как stopped.
+   * Смещение сразу по двум осям принимается, только если конечная точка
+   * лежит на дороге.
+   */
+  MoveResult Move(geom::Point2D from, SegmentId hint, geom::Vec2D delta) const;
+
+ private:
+  using CellKey = std::uint64_t;
+  static constexpr double CELL_SIZE = 16.0;
+
+  static std::int32_t CellCoord(double value) noexcept;
+  static CellKey MakeKey(std::int32_t x, std::int32_t y) noexcept;
+
+  MoveResult MoveAlongAxis(geom::Point2D from, SegmentId start, int axis, double delta) const;
+
+  std::vector<Segment> segments_;
+  // Сегменты, пересекающие ячейку равномерной сетки, для поиска по точке и соседей
+  std::unordered_map<CellKey, std::vector<SegmentId>> cells_;
+};
+
+}  // namespace road_graph
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <boost/beast/http/verb.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+/*
+ * Таблица маршрутов HTTP, построенная при компиляции.
+ *
+ * Маршрут - шаблон пути и обработчики по методам. Сегмент шаблона вида {name}
+ * совпадает с любым непустым сегментом пути, значение попадает в PathParams.
+ * Пути без параметров ищутся в совершенной хеш-таблице: зерно хеша подбирается
+ * при компиляции так, чтобы у всех таких путей были разные ячейки, и поиск - это
+ * один хеш и одно сравнение строк. Хешируются длина пути и его последние 8 байт;
+ * вся строка - только если этого не хватает, чтобы различить пути таблицы.
+ * Шаблоны с параметрами проверяются по порядку.
+ * Заголовок Allow каждого маршрута тоже собирается при компиляции.
+ */
+namespace router {
+
+namespace http = boost::beast::http;
+
+inline constexpr std::size_t MAX_PARAMS = 4;
+inline constexpr std::size_t MAX_METHODS = 4;
+
+// Значения параметров пути в порядке их следования в шаблоне
+class PathParams {
+ public:
+  constexpr std::size_t size() const noexcept {
+    return size_;
+  }
+
+  constexpr std::string_view operator[](std::size_t index) const noexcept {
+    return values_[index];
+  }
+
+  constexpr void push_back(std::string_view value) noexcept {
+    values_[size_++] = value;
+  }
+
+ private:
+  std::array<std::string_view, MAX_PARAMS> values_{};
+  std::size_t size_ = 0;
+};
+
+template <typename Handler>
+struct Endpoint {
+  http::verb method = http::verb::unknown;
+  Handler handler{};
+};
+
+template <typename Handler>
+constexpr Endpoint<Handler> On(http::verb method, Handler handler) {
+  return {method, handler};
+}
+
+template <typename Handler>
+struct Route {
+  std::string_view pattern;
+  // Неиспользуемые элементы имеют метод http::verb::unknown
+  std::array<Endpoint<Handler>, MAX_METHODS> endpoints{};
+};
+
+template <typename Handler, typename... Rest>
+constexpr Route<Handler> MakeRoute(std::string_view pattern, Endpoint<Handler> first,
+                                   Rest... rest) {
+  static_assert(sizeof...(Rest) < MAX_METHODS, "Too many methods in one route");
+  return {pattern, {first, rest...}};
+}
+
+template <typename Handler>
+struct Match {
+  // Обработчик метода запроса; nullptr, если путь не найден или метод не разрешён
+  const Handler* handler = nullptr;
+  // Заголовок Allow найденного маршрута; пуст, если путь не найден
+  std::string_view allow;
+  PathParams params;
+
+  constexpr bool IsPathFound() const noexcept {
+    return !allow.empty();
+  }
+};
+
+template <typename Handler, std::size_t N>
+class Router {
+ public:
+  consteval explicit Router(const std::array<Route<Handler>, N>& routes) : routes_(routes) {
+    for (std::size_t i = 0; i < N; ++i) {
+      const Route<Handler>& route = routes_[i];
+      if (route.pattern.empty() || route.pattern.front() != '/') {
+        throw "Route pattern must start with '/'";
+      }
+      if (ParamsCount(route.pattern) > MAX_PARAMS) {
+        throw "Too many path parameters in one route";
+      }
+      BuildAllow(route, allow_[i]);
+      if (ParamsCount(route.pattern) > 0) {
+        dynamic_prefix_[dynamic_count_] = route.pattern.find('{');
+        dynamic_[dynamic_count_++] = static_cast<std::uint8_t>(i);
+      }
+    }
+    FindSeed();
+  }
+
+  // target может содержать строку запроса, она не участвует в поиске
+  constexpr Match<Handler> Find(std::string_view target, http::verb method) const {
+    const std::string_view path = target.substr(0, target.find('?'));
+
+    const std::uint8_t slot = table_[Slot(Key(path, full_key_), seed_)];
+    if (slot != EMPTY && routes_[slot].pattern == path) {
+      return MakeMatch(slot, method, {});
+    }
+    for (std::size_t i = 0; i < dynamic_count_; ++i) {
+      // Постоянная часть до первого параметра сравнивается целиком
+      const std::string_view pattern = routes_[dynamic_[i]].pattern;
+      const std::size_t prefix = dynamic_prefix_[i];
+      PathParams params;
+      if (path.starts_with(pattern.substr(0, prefix)) &&
+          MatchPattern(pattern.substr(prefix), path.substr(prefix), params)) {
+        return MakeMatch(dynamic_[i], method, params);
+      }
+    }
+    return {};
+  }
+
+ private:
+  static_assert(N > 0 && N < 255, "Router supports 1..254 routes");
+
+  // Не меньше двух ячеек на маршрут, чтобы зерно без коллизий находилось быстро
+  static constexpr std::size_t TABLE_SIZE = std::bit_ceil(2 * N);
+  static constexpr std::uint8_t EMPTY = 0xFF;
+  static constexpr std::uint64_t MAX_SEED = 1 << 16;
+
+  struct AllowHeader {
+    std::array<char, 64> data{};
+    std::size_t size = 0;
+
+    constexpr std::string_view View() const noexcept {
+      return {data.data(), size};
+    }
+  };
+
+  static constexpr std::uint64_t Key(std::string_view path, bool full) noexcept {
+    if (full) {
+      // FNV-1a всей строки
+      std::uint64_t hash = 14695981039346656037ull;
+      for (const char c : path) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+      }
+      return hash;
+    }
+    // Последние 8 байт в порядке little-endian: при выполнении это одно чтение
+    std::uint64_t tail = 0;
+    if (path.size() >= 8) {
+      const char* end = path.data() + path.size() - 8;
+      if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+        std::memcpy(&tail, end, sizeof(tail));
+        return tail + path.size() * 0x9E3779B97F4A7C15ull;
+      }
+      for (unsigned i = 0; i < 8; ++i) {
+        tail |= std::uint64_t{static_cast<unsigned char>(end[i])} << (8 * i);
+      }
+    } else {
+      for (const char c : path) {
+        tail = (tail << 8) | static_cast<unsigned char>(c);
+      }
+    }
+    return tail + path.size() * 0x9E3779B97F4A7C15ull;
+  }
+
+  static constexpr std::size_t Slot(std::uint64_t key, std::uint64_t seed) noexcept {
+    return static_cast<std::size_t>(((key ^ seed) * 0xFF51AFD7ED558CCDull) >> 32) &
+           (TABLE_SIZE - 1);
+  }
+
+  static constexpr bool IsParam(std::string_view segment) noexcept {
+    return segment.size() > 2 && segment.front() == '{' && segment.back() == '}';
+  }
+
+  static constexpr std::size_t ParamsCount(std::string_view pattern) {
+    std::size_t count = 0;
+    ForEachSegment(pattern, [&count](std::string_view segment) {
+      count += IsParam(segment) ? 1 : 0;
+      return true;
+    });
+    return count;
+  }
+
+  template <typename Fn>
+  static constexpr bool ForEachSegment(std::string_view path, Fn&& fn) {
+    while (!path.empty()) {
+      path.remove_prefix(1);  // '/'
+      const std::string_view segment = path.substr(0, path.find('/'));
+      if (!fn(segment)) {
+        return false;
+      }
+      path.remove_prefix(segment.size());
+    }
+    return true;
+  }
+
+  // Сравнивает посимвольно, без разбиения на сегменты: чужой путь обычно отсеивается
+  // на первых отличающихся символах общего префикса
+  static constexpr bool MatchPattern(std::string_view pattern, std::string_view path,
+                                     PathParams& params) {
+    std::size_t p = 0;
+    std::size_t s = 0;
+    while (p < pattern.size()) {
+      if (pattern[p] == '{') {
+        // Шаблон проверен при построении: параметр занимает целый сегмент
+        while (pattern[p++] != '}') {
+        }
+        const std::size_t begin = s;
+        while (s < path.size() && path[s] != '/') {
+          ++s;
+        }
+        if (s == begin) {
+          return false;
+        }
+        params.push_back(path.substr(begin, s - begin));
+      } else if (s < path.size() && path[s] == pattern[p]) {
+        ++p;
+        ++s;
+      } else {
+        return false;
+      }
+    }
+    return s == path.size();
+  }
+
+  static constexpr std::string_view MethodName(http::verb method) {
+    switch (method) {
+      case http::verb::get:
+        return "GET";
+      case http::verb::head:
+        return "HEAD";
+      case http::verb::post:
+        return "POST";
+      case http::verb::put:
+        return "PUT";
+      case http::verb::delete_:
+        return "DELETE";
+      case http::verb::patch:
+        return "PATCH";
+      case http::verb::options:
+        return "OPTIONS";
+      default:
+        throw "Unsupported method in route";
+    }
+  }
+
+  static constexpr void BuildAllow(const Route<Handler>& route, AllowHeader& allow) {
+    const auto append = [&allow](std::string_view text) {
+      if (allow.size + text.size() > allow.data.size()) {
+        throw "Allow header is too long";
+      }
+      for (const char c : text) {
+        allow.data[allow.size++] = c;
+      }
+    };
+
+    for (std::size_t i = 0; i < MAX_METHODS; ++i) {
+      const http::verb method = route.endpoints[i].method;
+      if (method == http::verb::unknown) {
+        continue;
+      }
+      for (std::size_t j = 0; j < i; ++j) {
+        if (route.endpoints[j].method == method) {
+          throw "Duplicate method in route";
+        }
+      }
+      if (allow.size > 0) {
+        append(", ");
+      }
+      append(MethodName(method));
+    }
+    if (allow.size == 0) {
+      throw "Route has no methods";
+    }
+  }
+
+  constexpr void FindSeed() {
+    for (std::size_t i = 0; i < N; ++i) {
+      for (std::size_t j = 0; j < i; ++j) {
+        if (ParamsCount(routes_[i].pattern) > 0 || ParamsCount(routes_[j].pattern) > 0) {
+          continue;
+        }
+        if (routes_[i].pattern == routes_[j].pattern) {
+          throw "Duplicate route pattern";
+        }
+        // Одинаковые ключи не разделит никакое зерно
+        if (Key(routes_[i].pattern, false) == Key(routes_[j].pattern, false)) {
+          full_key_ = true;
+        }
+      }
+    }
+
+    for (std::uint64_t seed = 0; seed < MAX_SEED; ++seed) {
+      if (TryFillTable(seed)) {
+        seed_ = seed;
+        return;
+      }
+    }
+    throw "No perfect hash seed for the routes";
+  }
+
+  constexpr bool TryFillTable(std::uint64_t seed) {
+    table_.fill(EMPTY);
+    for (std::size_t i = 0; i < N; ++i) {
+      if (ParamsCount(routes_[i].pattern) > 0) {
+        continue;
+      }
+      std::uint8_t& slot = table_[Slot(Key(routes_[i].pattern, full_key_), seed)];
+      if (slot != EMPTY) {
+        return false;
+      }
+      slot = static_cast<std::uint8_t>(i);
+    }
+    return true;
+  }
+
+  constexpr Match<Handler> MakeMatch(std::size_t index, http::verb method,
+                                     const PathParams& params) const {
+    Match<Handler> match{nullptr, allow_[index].View(), params};
+    for (const auto& endpoint : routes_[index].endpoints) {
+      if (endpoint.method == method && method != http::verb::unknown) {
+        match.handler = &endpoint.handler;
+        break;
+      }
+    }
+    return match;
+  }
+
+  std::array<Route<Handler>, N> routes_;
+  std::array<AllowHeader, N> allow_{};
+  std::array<std::uint8_t, TABLE_SIZE> table_{};
+  std::array<std::uint8_t, N> dynamic_{};
+  std::array<std::size_t, N> dynamic_prefix_{};
+  std::size_t dynamic_count_ = 0;
+  bool full_key_ = false;
+  std::uint64_t seed_ = 0;
+};
+
+}  // namespace router
@@ -1,4 +1,6 @@
 #include "serialization.h"
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include "model.h"
 
@@ -8,22 +10,21 @@ namespace model {
 
 SerDog SerializeDog(const Dog& dog) {
   return {
-      dog.GetName(),              // name
-      dog.GetId(),                // id
-      dog.GetScore(),             // score
-      dog.GetState(),             // state
-      dog.GetDefaultDogSpeed(),   // default_dog_speed
-      dog.GetBag().GetItems(),    // bag_items
-      dog.GetBag().GetCapacity()  // bag_capacity
+      dog.GetName(),   // name
+      dog.GetId(),     // id
+      dog.GetScore(),  // score
+      dog.GetState(),  // state
+      {dog.GetBag().GetItems().begin(), dog.GetBag().GetItems().end()}  // bag_items
   };
 }
 
-Dog DeserializeDog(const SerDog& ser_dog) {
-  Dog dog(ser_dog.name, ser_dog.id, ser_dog.state, ser_dog.bag_capacity);
-  dog.SetDefaultDogSpeed(ser_dog.default_dog_speed);
+Dog DeserializeDog(const SerDog& ser_dog, const Map& map) {
+  Dog dog(ser_dog.name, ser_dog.id, ser_dog.state, map.GetBagCapacity());
   dog.AddScore(ser_dog.score);
   for (size_t loot_type : ser_dog.bag_items) {
-    dog.GetBag().AddLoot(loot_type);
+    if (loot_type < map.GetLootTypesCount()) {
+      dog.GetBag().AddLoot(loot_type);
+    }
   }
   return dog;
 }
@@ -34,41 +35,48 @@ SerGameSession SerializeGameSession(const GameSession& session) {
   ser_session.map_id = *session.GetMapId();
   ser_session.id = session.GetSessionId();
 
-  for (const auto& [dog_id, dog] : session.GetDogs()) {
-    ser_session.dogs[dog_id] = SerializeDog(*dog);
+  for (const auto& dog : session.GetDogs()) {
+    ser_session.dogs[dog.GetId()] = SerializeDog(dog);
   }
 
   for (const auto& loot : session.GetLoots()) {
     ser_session.loots.push_back({loot.type, loot.value, loot.position});
   }
 
+  ser_session.next_dog_id = session.GetDogIdAllocator().GetNextId();
+  ser_session.free_dog_ids = session.GetDogIdAllocator().GetFreeIds();
+
   return ser_session;
 }
 
 std::shared_ptr<GameSession> DeserializeGameSessionInto(const SerGameSession& ser_session,
                                                         Game& game) {
   // 1. Найти карту
-  const Map* map = game.FindMap(Map::Id{ser_session.map_id});
+  auto map = game.FindSharedMap(Map::Id{ser_session.map_id});
   if (!map) {
     throw std::runtime_error("Map not found: " + ser_session.map_id);
   }
 
   // 2. Восстановить Dogs из SerDog
-  model::GameSession::Dogs dogs;
+  std::vector<Dog> dogs;
+  dogs.reserve(ser_session.dogs.size());
   for (const auto& [dog_id, ser_dog] : ser_session.dogs) {
-    auto dog = std::make_shared<Dog>(DeserializeDog(ser_dog));
-    dogs[dog_id] = dog;
+    dogs.push_back(DeserializeDog(ser_dog, *map));
   }
 
-  // 3. Восстановить Loots
+  // 3. Восстановить Loots. Трофеи типов, которых у карты больше нет, не восстанавливаются:
+  // в рюкзак помещаются только типы карты.
   std::vector<GameSession::Loot> loots;
   for (const auto& ser_loot : ser_session.loots) {
-    loots.push_back({ser_loot.type, ser_loot.value, ser_loot.position});
+    if (ser_loot.type < map->GetLootTypesCount()) {
+      loots.push_back({ser_loot.type, ser_loot.value, ser_loot.position});
+    }
   }
 
   // 4. Создать GameSession
-  auto session =
-      std::make_shared<GameSession>(std::move(dogs), *map, ser_session.id, std::move(loots));
+  auto session = std::make_shared<GameSession>(
+      std::move(dogs), std::move(map), ser_session.id, std::move(loots),
+      util::IdAllocator{ser_session.next_dog_id, ser_session.free_dog_ids});
 
   session->SetRandomSpawnMode(game.GetSettings().random_spawn);
 
@@ -78,39 +86,126 @@ std::shared_ptr<GameSession> DeserializeGameSessionInto(const SerGameSession& se
 SerPlayers SerializePlayers(Players& players) {
   SerPlayers ser;
 
-  for (const auto& [token, player_ptr] : players.GetPlayerTokens().GetTokenToPlayer()) {
+  for (const auto& player : players.GetAllPlayers()) {
     SerPlayer ser_player;
-    ser_player.dog_id = player_ptr->GetDogId();
-    ser_player.gamesession_id = player_ptr->GetGameSession()->GetSessionId();
-    ser_player.map_id = *player_ptr->GetGameSession()->GetMap().GetId();
+    ser_player.dog_id = player.GetDogId();
+    ser_player.gamesession_id = player.GetGameSession().GetSessionId();
+    ser_player.map_id = *player.GetGameSession().GetMap().GetId();
 
-    ser.players_with_tokens.push_back(SerPlayerWithToken{std::string(*token), ser_player});
+    ser.players_with_tokens.push_back(
+        SerPlayerWithToken{std::string(*player.GetToken()), ser_player});
   }
 
   return ser;
 }
 
+void AssignDenseDogIds(std::vector<SerGameSession>& sessions, SerPlayers& players) {
+  for (auto& session : sessions) {
+    if (!session.legacy_dog_ids) {
+      continue;
+    }
+
+    // Новые идентификаторы выдаются по возрастанию старых
+    std::vector<Dog::Id> old_ids;
+    old_ids.reserve(session.dogs.size());
+    for (const auto& [dog_id, ser_dog] : session.dogs) {
+      old_ids.push_back(dog_id);
+    }
+    std::sort(old_ids.begin(), old_ids.end());
+
+    std::unordered_map<Dog::Id, Dog::Id> new_ids;
+    std::unordered_map<Dog::Id, SerDog> dogs;
+    for (const Dog::Id old_id : old_ids) {
+      const Dog::Id new_id = new_ids.size();
+      new_ids.emplace(old_id, new_id);
+      SerDog ser_dog = std::move(session.dogs.at(old_id));
+      ser_dog.id = new_id;
+      dogs.emplace(new_id, std::move(ser_dog));
+    }
+
+    for (auto& [token, ser_player] : players.players_with_tokens) {
+      if (ser_player.gamesession_id != session.id) {
+        continue;
+      }
+      if (auto it = new_ids.find(ser_player.dog_id); it != new_ids.end()) {
+        ser_player.dog_id = it->second;
+      }
+    }
+
+    session.dogs = std::move(dogs);
+    session.next_dog_id = static_cast<util::IdAllocator::Id>(new_ids.size());
+    session.free_dog_ids.clear();
+    session.legacy_dog_ids = false;
+  }
+}
+
 void DeserializePlayers(const SerPlayers& ser_players, Game& game, Players& players) {
   for (const auto& ser_player_with_token : ser_players.players_with_tokens) {
     const auto& ser_player = ser_player_with_token.player;
     const auto& token_str = ser_player_with_token.token;
 
-    // Находим игровую сессию
-    auto game_session = game.FindGameSession(Map::Id{ser_player.map_id});
+    // Игрок возвращается в свою сессию, а не в любую сессию карты
+    auto game_session = game.FindGameSession(ser_player.gamesession_id);
     if (!game_session) {
       continue;
     }
 
-    // Находим собаку
-    auto dog = game_session->FindDog(ser_player.dog_id);
-    if (!dog) {
+    // Собака игрока должна быть в сессии
+    if (!game_session->HasDog(ser_player.dog_id)) {
       continue;
     }
 
     // Восстанавливаем игрока с токеном
-    auto player = std::make_shared<Player>(dog, game_session);
-    players.GetPlayerTokens().AddToken(player, Token{token_str});  // Создаем Token из строки
-    players.GetAllPlayers().emplace(std::make_pair(dog->GetId(), ser_player.map_id), player);
+    players.AddPlayer(Token{token_str}, ser_player.dog_id, *game_session);
+  }
+}
+
+SerGamePart SerializeGamePart(const GamePart& part) {
+  SerGamePart ser;
+  for (const auto& session : part.game.GetGameSessions()) {
+    // Сессии карт, убранных из конфигурации при перезагрузке, доигрываются, но не
+    // сохраняются: после перезапуска их карт не будет
+    if (part.game.FindMap(session->GetMapId())) {
+      ser.sessions.push_back(SerializeGameSession(*session));
+    }
+  }
+  ser.players = SerializePlayers(part.players);
+  std::erase_if(ser.players.players_with_tokens, [&part](const SerPlayerWithToken& player) {
+    return !part.game.FindMap(Map::Id{player.player.map_id});
+  });
+  return ser;
+}
+
+void SaveGameParts(std::vector<SerGamePart> parts, std::ostream& out) {
+  std::vector<SerGameSession> sessions;
+  SerPlayers players;
+  for (auto& part : parts) {
+    std::move(part.sessions.begin(), part.sessions.end(), std::back_inserter(sessions));
+    std::move(part.players.players_with_tokens.begin(), part.players.players_with_tokens.end(),
+              std::back_inserter(players.players_with_tokens));
+  }
+
+  boost::archive::text_oarchive oa(out);
+  oa << sessions << players;
+}
+
+void LoadGameParts(const std::vector<GamePart>& parts, std::istream& in) {
+  boost::archive::text_iarchive ia(in);
+  std::vector<SerGameSession> sessions;
+  SerPlayers players;
+  ia >> sessions >> players;
+  AssignDenseDogIds(sessions, players);
+
+  const auto count = static_cast<unsigned>(parts.size());
+  for (const auto& ser_session : sessions) {
+    const unsigned index =
+        SessionPartition(parts.front().game, Map::Id{ser_session.map_id}, ser_session.id, count);
+    Game& game = parts[index].game;
+    game.LoadGameSession(DeserializeGameSessionInto(ser_session, game));
+  }
+  // Игроки, сессий которых нет в части, пропускаются: они достанутся другой части
+  for (const auto& part : parts) {
+    DeserializePlayers(players, part.game, part.players);
   }
 }
 
@@ -10,6 +10,7 @@
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/serialization/access.hpp>
+#include <boost/serialization/version.hpp>
 
 #include <fstream>
 
@@ -24,13 +25,22 @@ struct SerDog {
   size_t id;
   int score;
   MoveInfo state;
-  double default_dog_speed;
   std::vector<size_t> bag_items;
-  size_t bag_capacity;
 
+  // Скорость и вместимость рюкзака берутся из карты; в снимках версии 0 они
+  // хранились у каждой собаки и при чтении пропускаются
   template <typename Archive>
   void serialize(Archive& ar, const unsigned int version) {
-    ar & name & id & score & state & default_dog_speed & bag_items & bag_capacity;
+    double default_dog_speed = 0;
+    size_t bag_capacity = 0;
+    ar & name & id & score & state;
+    if (version == 0) {
+      ar & default_dog_speed;
+    }
+    ar & bag_items;
+    if (version == 0) {
+      ar & bag_capacity;
+    }
   }
 };
 
@@ -51,9 +61,20 @@ struct SerGameSession {
   std::unordered_map<Dog::Id, SerDog> dogs;
   std::vector<SerLoot> loots;
 
+  // Состояние выдачи идентификаторов собак (с версии 1)
+  util::IdAllocator::Id next_dog_id = 0;
+  std::vector<util::IdAllocator::Id> free_dog_ids;
+  // Сессия из снимка версии 0, где id собаки был хешем имени
+  bool legacy_dog_ids = false;
+
   template <typename Archive>
   void serialize(Archive& ar, const unsigned int version) {
     ar & map_id & id & dogs & loots;
+    if (version >= 1) {
+      ar & next_dog_id & free_dog_ids;
+    } else {
+      legacy_dog_ids = true;
+    }
   }
 };
 
@@ -91,38 +112,46 @@ struct SerPlayers {
 SerPlayers SerializePlayers(Players& players);
 void DeserializePlayers(const SerPlayers& ser_players, Game& game, Players& players);
 
+/// Переводит собак из снимков версии 0 на плотные идентификаторы,
+/// обновляя ссылки игроков на них
+void AssignDenseDogIds(std::vector<SerGameSession>& sessions, SerPlayers& players);
+
 /// Конвертирует Dog → SerDog
 SerDog SerializeDog(const Dog& dog);
-Dog DeserializeDog(const SerDog& ser_dog);
+/// Рюкзак получает вместимость карты, предметы неизвестных карте типов отбрасываются
+Dog DeserializeDog(const SerDog& ser_dog, const Map& map);
 
 /// Конвертирует GameSession → SerGameSession
 SerGameSession SerializeGameSession(const GameSession& session);
 std::shared_ptr<GameSession> DeserializeGameSessionInto(const SerGameSession& ser_session,
                                                         Game& game);
 
+// Сессии и игроки части игры (GamePart). Снимок хранит части вместе, как одну игру,
+// поэтому его можно восстановить с другим числом частей.
+struct SerGamePart {
+  std::vector<SerGameSession> sessions;
+  SerPlayers players;
+};
+
+SerGamePart SerializeGamePart(const GamePart& part);
+// Записывает части одним снимком в формате SaveGame
+void SaveGameParts(std::vector<SerGamePart> parts, std::ostream& out);
+// Раскладывает сессии снимка по частям (SessionPartition); игроки попадают в части
+// своих сессий
+void LoadGameParts(const std::vector<GamePart>& parts, std::istream& in);
+
 inline void SaveGame(model::Game& game, model::Players& players, std::ostream& out) {
-  boost::archive::text_oarchive oa(out);
-  std::vector<SerGameSession> serialized_sessions;
-  for (const auto& session : game.GetGameSessions()) {
-    serialized_sessions.push_back(SerializeGameSession(*session));
-  }
-  SerPlayers ser_players = SerializePlayers(players);
-  oa << serialized_sessions << ser_players;
+  std::vector<SerGamePart> parts;
+  parts.push_back(SerializeGamePart({game, players}));
+  SaveGameParts(std::move(parts), out);
 }
 
 inline void LoadGame(model::Game& game, model::Players& players, std::istream& in) {
-  boost::archive::text_iarchive ia(in);
-  std::vector<SerGameSession> serialized_sessions;
-  SerPlayers ser_players;
-
-  ia >> serialized_sessions >> ser_players;
-
-  for (const auto& ser_session : serialized_sessions) {
-    game.LoadGameSession(DeserializeGameSessionInto(ser_session, game));
-  }
-
-  DeserializePlayers(ser_players, game, players);
+  LoadGameParts({{game, players}}, in);
 }
 
 }  // namespace model
+
+BOOST_CLASS_VERSION(model::SerDog, 1)
+BOOST_CLASS_VERSION(model::SerGameSession, 1)
    //
@@ -0,0 +1,211 @@
+#include "shard.h"
+
+#include <boost/asio/post.hpp>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace shard {
+
+namespace {
+
+thread_local Shard* current_shard = nullptr;
+
+// Процессоры, на которых процессу разрешено работать (например, cpuset контейнера).
+// Список запоминается при первом вызове, до того как потоки шардов закрепятся за ядрами:
+// закреплённый поток сузил бы маску, которую наследуют потоки, созданные после него.
+const std::vector<int>& AllowedCpus() {
+  static const std::vector<int> cpus = [] {
+    std::vector<int> result;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+          result.push_back(cpu);
+        }
+      }
+    }
+#endif
+    return result;
+  }();
+  return cpus;
+}
+
+std::optional<int> ResolveCpu(std::optional<unsigned> cpu) {
+  const auto& cpus = AllowedCpus();
+  if (!cpu || cpus.empty()) {
+    return std::nullopt;
+  }
+  // Шардов больше, чем ядер: лишние делят ядра по кругу
+  return cpus[*cpu % cpus.size()];
+}
+
+void PinCurrentThread([[maybe_unused]] int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  // Неудача не мешает работе: шард просто не будет закреплён
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+}  // namespace
+
+void TaskQueue::Push(Task* task) noexcept {
+  task->next_.store(nullptr, std::memory_order_relaxed);
+  Task* prev = tail_.exchange(task);
+  prev->next_.store(task, std::memory_order_release);
+}
+
+Task* TaskQueue::Pop() noexcept {
+  Task* head = head_;
+  Task* next = head->next_.load(std::memory_order_acquire);
+  if (head == &stub_) {
+    if (!next) {
+      return nullptr;
+    }
+    head_ = next;
+    head = next;
+    next = next->next_.load(std::memory_order_acquire);
+  }
+  if (next) {
+    head_ = next;
+    return head;
+  }
+  if (head != tail_.load()) {
+    // Писатель уже занял место в хвосте, но ещё не связал его с предыдущим узлом
+    return nullptr;
+  }
+  // head - последний узел; заглушка встаёт за ним, чтобы head можно было отдать
+  Push(&stub_);
+  next = head->next_.load(std::memory_order_acquire);
+  if (next) {
+    head_ = next;
+    return head;
+  }
+  return nullptr;
+}
+
+bool TaskQueue::IsEmpty() const noexcept {
+  return head_ == &stub_ && tail_.load() == &stub_;
+}
+
+Shard::Shard(unsigned index, std::optional<unsigned> cpu)
+    : index_(index), cpu_(ResolveCpu(cpu)), work_(net::make_work_guard(ioc_)) {
+}
+
+Shard::~Shard() {
+  Stop();
+  Join();
+  // Невыполненные задания могут владеть соединениями других шардов,
+  // поэтому освобождаются здесь, пока те ещё существуют
+  DiscardTasks();
+}
+
+void Shard::DiscardTasks() noexcept {
+  while (Task* task = queue_.Pop()) {
+    delete task;
+  }
+}
+
+Shard* Shard::Current() noexcept {
+  return current_shard;
+}
+
+void Shard::Start() {
+  thread_ = std::thread([this] { Run(); });
+}
+
+void Shard::Run() {
+  current_shard = this;
+  if (cpu_) {
+    PinCurrentThread(*cpu_);
+  }
+  ioc_.run();
+  current_shard = nullptr;
+}
+
+void Shard::Stop() {
+  work_.reset();
+  ioc_.stop();
+}
+
+void Shard::Join() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void Shard::ScheduleDrain() {
+  net::post(ioc_, [this] { Drain(); });
+}
+
+void Shard::Drain() {
+  // Флаг снимается до проверки очереди: задание, вставленное после проверки,
+  // увидит снятый флаг и само поставит обработчик
+  const auto finish = [this] {
+    drain_scheduled_.store(false);
+    if (!queue_.IsEmpty() && !drain_scheduled_.exchange(true)) {
+      ScheduleDrain();
+    }
+  };
+
+  try {
+    for (unsigned i = 0; i < DRAIN_BATCH; ++i) {
+      std::unique_ptr<Task> task{queue_.Pop()};
+      if (!task) {
+        break;
+      }
+      task->Run();
+    }
+  } catch (...) {
+    finish();
+    throw;
+  }
+  finish();
+}
+
+ShardSet::ShardSet(unsigned count, unsigned first_cpu) {
+  // Лишние шарды делят по кругу процессоры начиная с first_cpu. Процессоры до него
+  // оставлены другим потокам, и круг через них не проходит.
+  const auto cpu_count = static_cast<unsigned>(AllowedCpus().size());
+  const unsigned own_cpus = cpu_count > first_cpu ? cpu_count - first_cpu : 0;
+  shards_.reserve(count);
+  for (unsigned i = 0; i < count; ++i) {
+    const unsigned cpu = own_cpus > 0 ? first_cpu + i % own_cpus : first_cpu + i;
+    shards_.push_back(std::make_unique<Shard>(i, cpu));
+  }
+}
+
+ShardSet::~ShardSet() {
+  Stop();
+  Join();
+  for (auto& shard : shards_) {
+    shard->DiscardTasks();
+  }
+}
+
+void ShardSet::Start() {
+  for (auto& shard : shards_) {
+    shard->Start();
+  }
+}
+
+void ShardSet::Stop() {
+  for (auto& shard : shards_) {
+    shard->Stop();
+  }
+}
+
+void ShardSet::Join() {
+  for (auto& shard : shards_) {
+    shard->Join();
+  }
+}
+
+}  // namespace shard
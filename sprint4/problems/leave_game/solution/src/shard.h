@@ -0,0 +1,158 @@
+#pragma once
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+ * Шарды: io_context с единственным потоком, закреплённым за ядром процессора.
+ * Всё, что выполняется в шарде, выполняется последовательно и без блокировок;
+ * другие потоки передают шарду задания через его входящую очередь (Post).
+ */
+namespace shard {
+
+namespace net = boost::asio;
+
+// Задание, переданное в другой шард. Узел интрузивной очереди TaskQueue.
+class Task {
+ public:
+  virtual ~Task() = default;
+  virtual void Run() = 0;
+
+ private:
+  friend class TaskQueue;
+  std::atomic<Task*> next_{nullptr};
+};
+
+/*
+ * Очередь без блокировок со многими писателями и одним читателем (алгоритм Вьюкова).
+ * Push - один атомарный обмен, Pop не выделяет память.
+ * Pop может вернуть nullptr, пока писатель не закончил вставку; IsEmpty при этом ложно.
+ */
+class TaskQueue {
+ public:
+  TaskQueue() = default;
+  TaskQueue(const TaskQueue&) = delete;
+  TaskQueue& operator=(const TaskQueue&) = delete;
+
+  // Вызывается из любого потока
+  void Push(Task* task) noexcept;
+
+  // Вызываются только читателем
+  Task* Pop() noexcept;
+  bool IsEmpty() const noexcept;
+
+ private:
+  class Stub : public Task {
+    void Run() override {
+    }
+  };
+
+  Stub stub_;
+  Task* head_ = &stub_;
+  std::atomic<Task*> tail_{&stub_};
+};
+
+class Shard {
+ public:
+  // cpu - номер процессора из разрешённых процессу, за которым закрепляется поток шарда
+  explicit Shard(unsigned index, std::optional<unsigned> cpu = std::nullopt);
+  ~Shard();
+
+  Shard(const Shard&) = delete;
+  Shard& operator=(const Shard&) = delete;
+
+  unsigned GetIndex() const noexcept {
+    return index_;
+  }
+
+  net::io_context& GetIoContext() noexcept {
+    return ioc_;
+  }
+
+  // Шард, в потоке которого выполняется вызывающий код, или nullptr
+  static Shard* Current() noexcept;
+
+  // Передаёт fn на выполнение в поток шарда. Можно вызывать из любого потока.
+  template <typename Fn>
+  void Post(Fn&& fn) {
+    queue_.Push(new TaskImpl<std::decay_t<Fn>>(std::forward<Fn>(fn)));
+    // Обработчик очереди ставится в io_context, только если он ещё не стоит там
+    if (!drain_scheduled_.exchange(true)) {
+      ScheduleDrain();
+    }
+  }
+
+  // Запускает поток шарда
+  void Start();
+  // Выполняет шард в текущем потоке до остановки
+  void Run();
+  void Stop();
+  void Join();
+  // Освобождает невыполненные задания. Вызывается после остановки потока шарда.
+  void DiscardTasks() noexcept;
+
+ private:
+  template <typename Fn>
+  class TaskImpl : public Task {
+   public:
+    explicit TaskImpl(Fn&& fn) : fn_(std::move(fn)) {
+    }
+    explicit TaskImpl(const Fn& fn) : fn_(fn) {
+    }
+
+    void Run() override {
+      fn_();
+    }
+
+   private:
+    Fn fn_;
+  };
+
+  // Сколько заданий выполняется подряд, прежде чем уступить другим обработчикам io_context
+  static constexpr unsigned DRAIN_BATCH = 64;
+
+  void ScheduleDrain();
+  void Drain();
+
+  unsigned index_;
+  std::optional<int> cpu_;
+  net::io_context ioc_{1};
+  net::executor_work_guard<net::io_context::executor_type> work_;
+  TaskQueue queue_;
+  std::atomic<bool> drain_scheduled_{false};
+  std::thread thread_;
+};
+
+// Набор шардов; i-й шард закрепляется за процессором first_cpu + i. Если шардов больше,
+// чем процессоров начиная с first_cpu, они делят эти процессоры, не занимая предыдущие.
+class ShardSet {
+ public:
+  ShardSet(unsigned count, unsigned first_cpu);
+  // Задания в очереди одного шарда могут владеть соединениями другого, поэтому
+  // очереди всех шардов освобождаются прежде, чем разрушается любой из них
+  ~ShardSet();
+
+  unsigned Size() const noexcept {
+    return static_cast<unsigned>(shards_.size());
+  }
+
+  Shard& operator[](unsigned index) {
+    return *shards_[index];
+  }
+
+  void Start();
+  void Stop();
+  void Join();
+
+ private:
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace shard
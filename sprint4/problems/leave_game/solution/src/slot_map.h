@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*
+ * Контейнер со стабильными ключами.
+ * Значения лежат в плотном массиве, поэтому обход идёт без пропусков,
+ * а вставка и удаление выполняются за O(1): удаляемый элемент меняется
+ * местами с последним. Ключ состоит из номера слота и его поколения;
+ * поколение растёт при каждом освобождении слота, так что ключ удалённого
+ * элемента не находит элемент, занявший тот же слот позже.
+ */
+template <typename T>
+class SlotMap {
+ public:
+  struct Key {
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+
+    // Ключ одним числом, например для передачи клиенту
+    std::uint64_t Pack() const noexcept {
+      return (static_cast<std::uint64_t>(generation) << 32) | index;
+    }
+
+    static Key Unpack(std::uint64_t packed) noexcept {
+      return {static_cast<std::uint32_t>(packed), static_cast<std::uint32_t>(packed >> 32)};
+    }
+
+    bool operator==(const Key&) const = default;
+  };
+
+  using iterator = typename std::vector<T>::iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  Key Insert(T value) {
+    std::uint32_t index;
+    if (free_head_ != NO_SLOT) {
+      index = free_head_;
+      free_head_ = slots_[index].position;
+    } else {
+      index = static_cast<std::uint32_t>(slots_.size());
+      slots_.push_back({});
+    }
+
+    Slot& slot = slots_[index];
+    slot.position = static_cast<std::uint32_t>(values_.size());
+    values_.push_back(std::move(value));
+    keys_.push_back({index, slot.generation});
+    return keys_.back();
+  }
+
+  // Возвращает false, если элемента с таким ключом уже нет
+  bool Erase(Key key) {
+    if (!Contains(key)) {
+      return false;
+    }
+
+    Slot& slot = slots_[key.index];
+    const std::uint32_t position = slot.position;
+    const std::uint32_t last = static_cast<std::uint32_t>(values_.size() - 1);
+    if (position != last) {
+      values_[position] = std::move(values_[last]);
+      keys_[position] = keys_[last];
+      slots_[keys_[position].index].position = position;
+    }
+    values_.pop_back();
+    keys_.pop_back();
+
+    ++slot.generation;
+    slot.position = free_head_;
+    free_head_ = key.index;
+    return true;
+  }
+
+  bool Contains(Key key) const noexcept {
+    return key.index < slots_.size() && slots_[key.index].generation == key.generation &&
+           slots_[key.index].position < keys_.size() && keys_[slots_[key.index].position] == key;
+  }
+
+  T* Find(Key key) noexcept {
+    return Contains(key) ? &values_[slots_[key.index].position] : nullptr;
+  }
+
+  const T* Find(Key key) const noexcept {
+    return Contains(key) ? &values_[slots_[key.index].position] : nullptr;
+  }
+
+  // Текущий ключ слота, если слот занят. Номер слота - плотный идентификатор элемента.
+  std::optional<Key> KeyOfSlot(std::uint32_t index) const noexcept {
+    if (index >= slots_.size()) {
+      return std::nullopt;
+    }
+    const Key key{index, slots_[index].generation};
+    return Contains(key) ? std::optional{key} : std::nullopt;
+  }
+
+  // Ключ элемента по его позиции в плотном массиве
+  Key KeyAt(std::size_t position) const noexcept {
+    assert(position < keys_.size());
+    return keys_[position];
+  }
+
+  std::size_t size() const noexcept {
+    return values_.size();
+  }
+
+  bool empty() const noexcept {
+    return values_.empty();
+  }
+
+  void reserve(std::size_t capacity) {
+    values_.reserve(capacity);
+    keys_.reserve(capacity);
+    slots_.reserve(capacity);
+  }
+
+  void clear() {
+    for (const Key& key : keys_) {
+      Slot& slot = slots_[key.index];
+      ++slot.generation;
+      slot.position = free_head_;
+      free_head_ = key.index;
+    }
+    values_.clear();
+    keys_.clear();
+  }
+
+  T& operator[](std::size_t position) noexcept {
+    return values_[position];
+  }
+
+  const T& operator[](std::size_t position) const noexcept {
+    return values_[position];
+  }
+
+  iterator begin() noexcept {
+    return values_.begin();
+  }
+
+  iterator end() noexcept {
+    return values_.end();
+  }
+
+  const_iterator begin() const noexcept {
+    return values_.begin();
+  }
+
+  const_iterator end() const noexcept {
+    return values_.end();
+  }
+
+ private:
+  static constexpr std::uint32_t NO_SLOT = UINT32_MAX;
+
+  struct Slot {
+    // Позиция значения в values_ для занятого слота,
+    // следующий свободный слот для освобождённого
+    std::uint32_t position = NO_SLOT;
+    std::uint32_t generation = 0;
+  };
+
+  std::vector<T> values_;
+  // Ключ каждого значения, индексы совпадают с values_
+  std::vector<Key> keys_;
+  std::vector<Slot> slots_;
+  std::uint32_t free_head_ = NO_SLOT;
+};
+
+}  // namespace util
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "geom.h"
+
+namespace util {
+
+// Область интереса: прямоугольник и, если задан радиус, круг внутри него
+struct InterestArea {
+  geom::Point2D min;
+  geom::Point2D max;
+  std::optional<double> radius;
+  geom::Point2D center;
+
+  static InterestArea Circle(geom::Point2D center, double radius) {
+    return {{center.x - radius, center.y - radius},
+            {center.x + radius, center.y + radius},
+            radius,
+            center};
+  }
+
+  static InterestArea Rect(geom::Point2D min, geom::Point2D max) {
+    return {min, max, std::nullopt, {}};
+  }
+
+  bool Contains(geom::Point2D point) const noexcept {
+    if (point.x < min.x || point.x > max.x || point.y < min.y || point.y > max.y) {
+      return false;
+    }
+    if (!radius) {
+      return true;
+    }
+    const double dx = point.x - center.x;
+    const double dy = point.y - center.y;
+    return dx * dx + dy * dy <= *radius * *radius;
+  }
+};
+
+/*
+ * Равномерная сетка для поиска объектов рядом с точкой.
+ * Объекты адресуются плотными идентификаторами, для каждого хранится ячейка
+ * и позиция в ней, поэтому перемещение внутри ячейки стоит одного сравнения,
+ * а переход в соседнюю ячейку - O(1). Запрос просматривает только ячейки,
+ * пересекающие область, то есть стоит O(объектов рядом), а не O(всех объектов).
+ */
+class SpatialGrid {
+ public:
+  using Id = std::uint32_t;
+
+  explicit SpatialGrid(double cell_size) : cell_size_(cell_size) {
+    assert(cell_size > 0);
+  }
+
+  void Insert(Id id, geom::Point2D position) {
+    if (id >= entries_.size()) {
+      entries_.resize(id + 1);
+    }
+    Entry& entry = entries_[id];
+    assert(!entry.used);
+    entry.used = true;
+    entry.position = position;
+    AddToCell(id, CellOf(position));
+    ++size_;
+  }
+
+  // Запоминает новую позицию объекта, перенося его в другую ячейку при необходимости
+  void Update(Id id, geom::Point2D position) {
+    assert(Contains(id));
+    Entry& entry = entries_[id];
+    entry.position = position;
+    if (const CellKey cell = CellOf(position); cell != entry.cell) {
+      RemoveFromCell(id);
+      AddToCell(id, cell);
+    }
+  }
+
+  void Erase(Id id) {
+    if (!Contains(id)) {
+      return;
+    }
+    RemoveFromCell(id);
+    entries_[id].used = false;
+    --size_;
+  }
+
+  bool Contains(Id id) const noexcept {
+    return id < entries_.size() && entries_[id].used;
+  }
+
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  void clear() {
+    entries_.clear();
+    cells_.clear();
+    size_ = 0;
+  }
+
+  // Вызывает fn(id, position) для каждого объекта в области
+  template <typename Fn>
+  void ForEachIn(const InterestArea& area, Fn&& fn) const {
+    const auto x0 = CellCoord(area.min.x);
+    const auto x1 = CellCoord(area.max.x);
+    const auto y0 = CellCoord(area.min.y);
+    const auto y1 = CellCoord(area.max.y);
+
+    const auto visit_cell = [&](const std::vector<Id>& ids) {
+      for (const Id id : ids) {
+        const geom::Point2D position = entries_[id].position;
+        if (area.Contains(position)) {
+          fn(id, position);
+        }
+      }
+    };
+
+    // Область больше занятой части сетки: дешевле обойти все ячейки
+    const double cells_in_area =
+        (static_cast<double>(x1) - x0 + 1) * (static_cast<double>(y1) - y0 + 1);
+    if (cells_in_area > static_cast<double>(cells_.size())) {
+      for (const auto& [cell, ids] : cells_) {
+        visit_cell(ids);
+      }
+      return;
+    }
+
+    for (auto x = x0; x <= x1; ++x) {
+      for (auto y = y0; y <= y1; ++y) {
+        if (auto it = cells_.find(MakeKey(x, y)); it != cells_.end()) {
+          visit_cell(it->second);
+        }
+      }
+    }
+  }
+
+ private:
+  using CellKey = std::uint64_t;
+
+  struct Entry {
+    CellKey cell = 0;
+    // Позиция идентификатора в списке ячейки
+    std::uint32_t slot = 0;
+    bool used = false;
+    geom::Point2D position;
+  };
+
+  std::int32_t CellCoord(double value) const noexcept {
+    // Ограничение нужно для областей вроде [-1e300, 1e300]
+    constexpr double LIMIT = INT32_MAX;
+    return static_cast<std::int32_t>(std::clamp(std::floor(value / cell_size_), -LIMIT, LIMIT));
+  }
+
+  static CellKey MakeKey(std::int32_t x, std::int32_t y) noexcept {
+    return (static_cast<CellKey>(static_cast<std::uint32_t>(x)) << 32) |
+           static_cast<std::uint32_t>(y);
+  }
+
+  CellKey CellOf(geom::Point2D position) const noexcept {
+    return MakeKey(CellCoord(position.x), CellCoord(position.y));
+  }
+
+  void AddToCell(Id id, CellKey cell) {
+    auto& ids = cells_[cell];
+    entries_[id].cell = cell;
+    entries_[id].slot = static_cast<std::uint32_t>(ids.size());
+    ids.push_back(id);
+  }
+
+  void RemoveFromCell(Id id) {
+    const Entry& entry = entries_[id];
+    auto& ids = cells_.at(entry.cell);
+    // На место удаляемого встаёт последний объект ячейки
+    const Id moved = ids.back();
+    ids[entry.slot] = moved;
+    entries_[moved].slot = entry.slot;
+    ids.pop_back();
+  }
+
+  double cell_size_;
+  std::vector<Entry> entries_;
+  // Пустые ячейки не удаляются: объекты часто возвращаются в те же места
+  std::unordered_map<CellKey, std::vector<Id>> cells_;
+  std::size_t size_ = 0;
+};
+
+}  // namespace util
@@ -0,0 +1,110 @@
+#include "tick_pipeline.h"
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <latch>
+#include <stdexcept>
+
+namespace game_time {
+
+TickPipeline::TickPipeline(unsigned workers) {
+  if (workers > 0) {
+    workers_.emplace(workers);
+  }
+}
+
+void TickPipeline::AddStage(std::string name, Stage stage, metrics::Histogram* duration) {
+  Add(stages_.empty() ? 0 : stages_.back().wave + 1, std::move(name), std::move(stage), duration);
+}
+
+void TickPipeline::AddStageAfter(const std::vector<std::string_view>& after, std::string name,
+                                 Stage stage, metrics::Histogram* duration) {
+  std::size_t wave = 0;
+  for (const auto dependency : after) {
+    wave = std::max(wave, stages_[FindStage(dependency)].wave + 1);
+  }
+  Add(wave, std::move(name), std::move(stage), duration);
+}
+
+void TickPipeline::Add(std::size_t wave, std::string name, Stage stage,
+                       metrics::Histogram* duration) {
+  if (std::any_of(stages_.begin(), stages_.end(),
+                  [&name](const StageInfo& info) { return info.name == name; })) {
+    throw std::invalid_argument("Tick stage " + name + " already exists");
+  }
+  if (wave >= waves_.size()) {
+    waves_.resize(wave + 1);
+  }
+  waves_[wave].push_back(stages_.size());
+  stages_.push_back({std::move(name), std::move(stage), duration, wave});
+}
+
+std::size_t TickPipeline::FindStage(std::string_view name) const {
+  const auto it = std::find_if(stages_.begin(), stages_.end(),
+                               [name](const StageInfo& info) { return info.name == name; });
+  if (it == stages_.end()) {
+    throw std::invalid_argument("Unknown tick stage " + std::string(name));
+  }
+  return static_cast<std::size_t>(it - stages_.begin());
+}
+
+void TickPipeline::RunStage(const StageInfo& info, std::chrono::milliseconds delta) {
+  if (info.duration) {
+    metrics::ScopedTimer timer{*info.duration};
+    info.stage(delta);
+  } else {
+    info.stage(delta);
+  }
+}
+
+void TickPipeline::Run(std::chrono::milliseconds delta) {
+  for (const auto& wave : waves_) {
+    if (!workers_ || wave.size() == 1) {
+      for (const std::size_t index : wave) {
+        RunStage(stages_[index], delta);
+      }
+      continue;
+    }
+
+    // Первая стадия волны выполняется в этом потоке, остальные - в рабочих
+    std::vector<std::exception_ptr> errors(wave.size());
+    std::latch done{static_cast<std::ptrdiff_t>(wave.size() - 1)};
+    for (std::size_t i = 1; i < wave.size(); ++i) {
+      boost::asio::post(*workers_, [this, delta, &wave, &errors, &done, i] {
+        try {
+          RunStage(stages_[wave[i]], delta);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+        done.count_down();
+      });
+    }
+    try {
+      RunStage(stages_[wave.front()], delta);
+    } catch (...) {
+      errors.front() = std::current_exception();
+    }
+    done.wait();
+
+    for (const auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  }
+}
+
+std::vector<std::vector<std::string>> TickPipeline::GetWaves() const {
+  std::vector<std::vector<std::string>> result;
+  for (const auto& wave : waves_) {
+    auto& names = result.emplace_back();
+    for (const std::size_t index : wave) {
+      names.push_back(stages_[index].name);
+    }
+  }
+  return result;
+}
+
+}  // namespace game_time
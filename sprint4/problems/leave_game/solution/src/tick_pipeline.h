@@ -0,0 +1,67 @@
+#pragma once
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metrics.h"
+
+namespace game_time {
+
+/*
+ * Конвейер тика: именованные стадии, которые выполняются в заданном порядке.
+ *
+ * Стадия выполняется после стадий, от которых зависит; по умолчанию - после предыдущей.
+ * Стадии одного уровня зависимостей составляют волну. Если у конвейера есть рабочие
+ * потоки, стадии волны выполняются параллельно, иначе - по очереди в порядке добавления.
+ * Время стадии записывается в её гистограмму.
+ *
+ * Стадии добавляются до первого Run; Run вызывается из одного потока (strand игры).
+ */
+class TickPipeline {
+ public:
+  using Stage = std::function<void(std::chrono::milliseconds delta)>;
+
+  // workers - потоки для параллельных стадий; 0 - все стадии выполняются в потоке Run
+  explicit TickPipeline(unsigned workers = 0);
+
+  TickPipeline(const TickPipeline&) = delete;
+  TickPipeline& operator=(const TickPipeline&) = delete;
+
+  // Стадия после предыдущей
+  void AddStage(std::string name, Stage stage, metrics::Histogram* duration = nullptr);
+  // Стадия после стадий after, добавленных раньше. С другими стадиями той же волны
+  // она может выполняться одновременно, поэтому не должна менять данные, которые они читают.
+  void AddStageAfter(const std::vector<std::string_view>& after, std::string name, Stage stage,
+                     metrics::Histogram* duration = nullptr);
+
+  // Выполняет все стадии. Исключение стадии передаётся вызывающему после завершения её волны.
+  void Run(std::chrono::milliseconds delta);
+
+  // Имена стадий по волнам, для проверки порядка
+  std::vector<std::vector<std::string>> GetWaves() const;
+
+ private:
+  struct StageInfo {
+    std::string name;
+    Stage stage;
+    metrics::Histogram* duration;
+    std::size_t wave;
+  };
+
+  std::size_t FindStage(std::string_view name) const;
+  void Add(std::size_t wave, std::string name, Stage stage, metrics::Histogram* duration);
+  static void RunStage(const StageInfo& info, std::chrono::milliseconds delta);
+
+  std::vector<StageInfo> stages_;
+  // Номера стадий каждой волны в порядке добавления
+  std::vector<std::vector<std::size_t>> waves_;
+  std::optional<boost::asio::thread_pool> workers_;
+};
+
+}  // namespace game_time
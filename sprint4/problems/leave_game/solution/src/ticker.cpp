@@ -1,35 +1,87 @@
 #include "ticker.h"
 
+#include "metrics.h"
+
 namespace game_time {
     void Ticker::Start() {
         net::dispatch(strand_, [self = shared_from_this()] {
             self->last_tick_ = Clock::now();
+            self->next_deadline_ = self->last_tick_ + self->period_;
             self->ScheduleTick();
         });
     }
 
     void Ticker::ScheduleTick() {
         //assert(strand_.running_in_this_thread());
-        timer_.expires_after(period_);
-        timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
-            self->OnTick(ec);
-        });
+        if (settings_.fixed_step) {
+            timer_.expires_at(next_deadline_);
+        } else {
+            timer_.expires_after(period_);
+        }
+        timer_.async_wait([self = shared_from_this(), generation = ++wait_generation_](
+                              sys::error_code ec) { self->OnTick(ec, generation); });
     }
 
-    void Ticker::OnTick(sys::error_code ec) {
-        using namespace std::chrono;
+    void Ticker::RunIfOverdue() {
+        //assert(strand_.running_in_this_thread());
+        const auto now = Clock::now();
+        const bool overdue =
+            settings_.fixed_step ? now >= next_deadline_ : now - last_tick_ >= period_;
+        if (overdue) {
+            // Новое ожидание отменит текущее. Если таймер уже сработал и его обработчик
+            // ждёт в очереди strand, обработчик увидит, что его ожидание устарело.
+            RunTick();
+        }
+    }
+
+    void Ticker::OnTick(sys::error_code ec, std::uint64_t generation) {
         //assert(strand_.running_in_this_thread());
+        if (!ec && generation == wait_generation_) {
+            RunTick();
+        }
+    }
+
+    void Ticker::RunTick() {
+        using namespace std::chrono;
 
-        if (!ec) {
-            auto this_tick = Clock::now();
+        auto this_tick = Clock::now();
+        if (settings_.fixed_step) {
+            RunFixedSteps(this_tick);
+        } else {
             auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
-            last_tick_ = this_tick;
             try {
                 handler_(delta);
             } catch (...) {
             }
-            ScheduleTick();
         }
+        last_tick_ = this_tick;
+        ScheduleTick();
+    }
+
+    void Ticker::RunFixedSteps(Clock::time_point now) {
+        // Срок шага ещё не наступил: шагать раньше времени значит обогнать часы
+        if (now < next_deadline_) {
+            return;
+        }
+        auto& server_metrics = metrics::Server();
+        server_metrics.tick_lateness.Record(now - next_deadline_);
+
+        // Шаги, срок которых уже наступил, включая текущий
+        const auto due = static_cast<unsigned long long>((now - next_deadline_) / period_) + 1;
+        const auto steps = std::min<unsigned long long>(due, std::max(1u, settings_.max_catch_up_steps));
+        if (due > steps) {
+            server_metrics.tick_overruns.Inc(due - steps);
+        }
+
+        for (unsigned long long i = 0; i < steps; ++i) {
+            try {
+                handler_(period_);
+            } catch (...) {
+            }
+        }
+
+        // Отброшенные шаги не догоняются: расписание сдвигается на все наступившие сроки
+        next_deadline_ += period_ * due;
     }
 
-}
\ No newline at end of file
+}
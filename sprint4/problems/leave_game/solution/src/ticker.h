@@ -5,30 +5,51 @@
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 
 namespace game_time {
 
     namespace net = boost::asio;
     namespace sys = boost::system;
 
+    struct TickerSettings {
+        // Фиксированный шаг: handler всегда получает period, таймер взводится
+        // на абсолютные сроки, и отставание догоняется несколькими шагами.
+        // Иначе handler получает фактически прошедшее время одним шагом.
+        bool fixed_step = false;
+        // Наибольшее число шагов за одно срабатывание. Пропущенные сверх
+        // этого шаги отбрасываются, чтобы после долгой паузы не уйти в догонялки.
+        unsigned max_catch_up_steps = 5;
+    };
+
     class Ticker : public std::enable_shared_from_this<Ticker> {
     public:
         using Strand = net::strand<net::io_context::executor_type>;
         using Handler = std::function<void(std::chrono::milliseconds delta)>;
 
         // Функция handler будет вызываться внутри strand с интервалом period
-        Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
+        Ticker(Strand strand, std::chrono::milliseconds period, Handler handler,
+               TickerSettings settings = {})
             : strand_{strand}
             , period_{period}
-            , handler_{std::move(handler)} {
+            , handler_{std::move(handler)}
+            , settings_{settings} {
         }
 
         void Start();
 
+        // Выполняет тик сразу, если его срок уже наступил, и перезапускает таймер.
+        // Вызывается внутри strand перед обработкой запросов, чтобы просроченный
+        // тик не ждал в очереди strand позади них.
+        void RunIfOverdue();
+
     private:
         void ScheduleTick();
 
-        void OnTick(sys::error_code ec);
+        void OnTick(sys::error_code ec, std::uint64_t generation);
+        void RunTick();
+        void RunFixedSteps(std::chrono::steady_clock::time_point now);
 
         using Clock = std::chrono::steady_clock;
 
@@ -36,6 +57,12 @@ namespace game_time {
         std::chrono::milliseconds period_;
         net::steady_timer timer_{strand_};
         Handler handler_;
+        TickerSettings settings_;
         std::chrono::steady_clock::time_point last_tick_;
+        // Срок следующего шага в режиме фиксированного шага
+        std::chrono::steady_clock::time_point next_deadline_;
+        // Номер текущего ожидания таймера. Срабатывание прежнего ожидания устарело:
+        // его обработчик мог попасть в очередь strand до того, как тик выполнил RunIfOverdue
+        std::uint64_t wait_generation_ = 0;
     }; 
 }  // namespace util
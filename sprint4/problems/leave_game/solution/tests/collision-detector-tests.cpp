@@ -6,6 +6,8 @@
 #include <sstream>
 #include <vector>
 #include <cmath>
+#include <map>
+#include <random>
 #include <set>
 
 #include "../src/collision_detector.h"
@@ -220,3 +222,70 @@ TEST_CASE("Multiple events at same time are allowed") {
   CHECK(item_ids.count(0) == 1);
   CHECK(item_ids.count(1) == 1);
 }
+
+TEST_CASE("All collision kernels find the same events as the per-pair check") {
+  using namespace collision_detector;
+
+  std::mt19937 random{42};
+  std::uniform_real_distribution<double> coord(0.0, 20.0);
+  std::uniform_real_distribution<double> step(-3.0, 3.0);
+  std::uniform_real_distribution<double> width(0.0, 0.7);
+
+  // Количество предметов не кратно ширине векторов, чтобы проверить хвост
+  ItemsBatch items;
+  std::vector<Item> item_list;
+  for (int i = 0; i < 1003; ++i) {
+    Item item{{coord(random), coord(random)}, width(random)};
+    items.Add(item);
+    item_list.push_back(item);
+  }
+
+  GatherersBatch gatherers;
+  std::vector<Gatherer> gatherer_list;
+  for (int g = 0; g < 50; ++g) {
+    geom::Point2D start{coord(random), coord(random)};
+    // Каждый десятый собиратель стоит на месте и ничего не собирает
+    geom::Point2D end = g % 10 == 0
+                            ? start
+                            : geom::Point2D{start.x + step(random), start.y + step(random)};
+    Gatherer gatherer{start, end, 0.6};
+    gatherers.Add(gatherer);
+    gatherer_list.push_back(gatherer);
+  }
+
+  // Эталон: проверка каждой пары через TryCollectPoint
+  std::map<std::pair<size_t, size_t>, CollectionResult> expected;
+  for (size_t g = 0; g < gatherer_list.size(); ++g) {
+    const auto& gatherer = gatherer_list[g];
+    if (gatherer.start_pos == gatherer.end_pos) {
+      continue;
+    }
+    for (size_t i = 0; i < item_list.size(); ++i) {
+      auto result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item_list[i].position);
+      if (result.IsCollected(gatherer.width + item_list[i].width)) {
+        expected.emplace(std::pair{g, i}, result);
+      }
+    }
+  }
+  REQUIRE_FALSE(expected.empty());
+
+  for (Kernel kernel : {Kernel::SCALAR, Kernel::SSE2, Kernel::AVX2}) {
+    if (!IsKernelSupported(kernel)) {
+      continue;
+    }
+    INFO("kernel: " << static_cast<int>(kernel));
+
+    auto events = FindGatherEvents(items.View(), gatherers.View(), kernel);
+    REQUIRE(events.size() == expected.size());
+    CHECK(std::is_sorted(events.begin(), events.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.time < rhs.time;
+    }));
+
+    for (const auto& event : events) {
+      auto it = expected.find({event.gatherer_id, event.item_id});
+      REQUIRE(it != expected.end());
+      CHECK_THAT(event.sq_distance, WithinAbs(it->second.sq_distance, 1e-12));
+      CHECK_THAT(event.time, WithinAbs(it->second.proj_ratio, 1e-12));
+    }
+  }
+}
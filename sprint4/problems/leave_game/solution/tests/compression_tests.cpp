@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <zlib.h>
+
+#include <string>
+#include <string_view>
+
+#include "../src/compression.h"
+
+namespace {
+
+using compression::Encoding;
+
+// Распаковывает gzip или zlib, формат определяется по заголовку
+std::string Inflate(std::string_view data) {
+  z_stream stream{};
+  REQUIRE(inflateInit2(&stream, 15 + 32) == Z_OK);
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+
+  std::string result;
+  char buffer[4096];
+  int status = Z_OK;
+  while (status == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    status = inflate(&stream, Z_NO_FLUSH);
+    result.append(buffer, sizeof(buffer) - stream.avail_out);
+  }
+  inflateEnd(&stream);
+  CHECK(status == Z_STREAM_END);
+  return result;
+}
+
+std::string MakeJsonLikeBody() {
+  std::string body = "[";
+  for (int i = 0; i < 500; ++i) {
+    body += R"({"name":"dog )" + std::to_string(i) + R"(","score":)" + std::to_string(i * 7) +
+            R"(,"playTime":12.5},)";
+  }
+  body.back() = ']';
+  return body;
+}
+
+}  // namespace
+
+SCENARIO("Accept-Encoding selects the response encoding") {
+  CHECK(compression::ChooseEncoding("") == Encoding::IDENTITY);
+  CHECK(compression::ChooseEncoding("gzip") == Encoding::GZIP);
+  CHECK(compression::ChooseEncoding("deflate") == Encoding::DEFLATE);
+  CHECK(compression::ChooseEncoding("gzip, deflate, br") == Encoding::GZIP);
+  CHECK(compression::ChooseEncoding("deflate, GZIP") == Encoding::GZIP);
+  CHECK(compression::ChooseEncoding("br, zstd") == Encoding::IDENTITY);
+
+  // q-значения и "*"
+  CHECK(compression::ChooseEncoding("gzip;q=0.5, deflate") == Encoding::DEFLATE);
+  CHECK(compression::ChooseEncoding("gzip;q=0, deflate;q=0") == Encoding::IDENTITY);
+  CHECK(compression::ChooseEncoding("gzip ; q=0 , deflate;q=0.1") == Encoding::DEFLATE);
+  CHECK(compression::ChooseEncoding("*") == Encoding::GZIP);
+  CHECK(compression::ChooseEncoding("*;q=0.3, gzip;q=0") == Encoding::DEFLATE);
+  CHECK(compression::ChooseEncoding("identity, *;q=0") == Encoding::IDENTITY);
+}
+
+SCENARIO("Compressed bodies decompress to the original") {
+  GIVEN("a JSON-like body") {
+    const std::string body = MakeJsonLikeBody();
+
+    THEN("both formats round trip and shrink the body") {
+      for (const Encoding encoding : {Encoding::GZIP, Encoding::DEFLATE}) {
+        for (const int level : {compression::FAST_LEVEL, compression::BEST_LEVEL}) {
+          const std::string compressed = compression::Compress(body, encoding, level);
+          CHECK(compressed.size() < body.size() / 4);
+          CHECK(Inflate(compressed) == body);
+        }
+      }
+    }
+
+    THEN("gzip output carries the gzip magic number") {
+      const std::string compressed = compression::Compress(body, Encoding::GZIP);
+      REQUIRE(compressed.size() > 2);
+      CHECK(static_cast<unsigned char>(compressed[0]) == 0x1f);
+      CHECK(static_cast<unsigned char>(compressed[1]) == 0x8b);
+    }
+
+    THEN("an empty body compresses too") {
+      CHECK(Inflate(compression::Compress("", Encoding::GZIP)).empty());
+    }
+
+    WHEN("the body is cached") {
+      compression::CachedBody cached{body};
+
+      THEN("each encoding is compressed once and reused") {
+        const std::string& gzip = cached.Get(Encoding::GZIP);
+        CHECK(&cached.Get(Encoding::GZIP) == &gzip);
+        CHECK(&cached.Get(Encoding::IDENTITY) == &cached.Identity());
+        CHECK(Inflate(gzip) == body);
+        CHECK(Inflate(cached.Get(Encoding::DEFLATE)) == body);
+      }
+    }
+  }
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+
+#include "../src/model.h"
+#include "../src/serialization.h"
+
+using namespace model;
+
+namespace {
+
+Game MakeGame(size_t session_capacity) {
+  Map map{Map::Id{"map"}, "Map"};
+  map.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 40});
+  Game game;
+  game.AddMap(std::move(map));
+  game.GetSettings().session_capacity = session_capacity;
+  return game;
+}
+
+}  // namespace
+
+SCENARIO("Players of a game part get tokens routed to that part") {
+  Game game = MakeGame(0);
+  Players players;
+  players.SetPartition(2, 3);
+
+  for (int i = 0; i < 20; ++i) {
+    const Player* player = JoinGame(game, players, Map::Id{"map"}, "Rex");
+    REQUIRE(player);
+    CHECK(TokenPartition(player->GetToken(), 3) == 2);
+  }
+}
+
+SCENARIO("Partitions of maps and tokens do not depend on the run") {
+  // Значения FNV-1a от строк: повтор записи должен попадать в те же части, что и сервер
+  CHECK(MapPartition(Map::Id{"map1"}, 4) == 0);
+  CHECK(MapPartition(Map::Id{"town"}, 4) == 1);
+  CHECK(TokenPartition(Token{"0123456789abcdef0123456789abcdef"}, 3) == 0);
+  CHECK(MapPartition(Map::Id{"town"}, 1) == 0);
+  CHECK(PartitionSeed(42, 0) == 42);
+}
+
+SCENARIO("A snapshot is split between game parts by session") {
+  GIVEN("a single game with several capacity-limited sessions") {
+    Game game = MakeGame(1);
+    Players players;
+    for (int i = 0; i < 8; ++i) {
+      REQUIRE(JoinGame(game, players, Map::Id{"map"}, "Rex"));
+    }
+    REQUIRE(game.GetGameSessions().size() == 8);
+
+    std::stringstream snapshot;
+    SaveGame(game, players, snapshot);
+
+    WHEN("it is loaded into two parts") {
+      Game game0 = MakeGame(1);
+      Game game1 = MakeGame(1);
+      Players players0;
+      Players players1;
+      const std::vector<GamePart> parts{{game0, players0}, {game1, players1}};
+      LoadGameParts(parts, snapshot);
+
+      THEN("every session goes to its part and its players follow it") {
+        CHECK(game0.GetGameSessions().size() + game1.GetGameSessions().size() == 8);
+        CHECK(players0.GetAllPlayers().size() + players1.GetAllPlayers().size() == 8);
+        for (const auto& part : parts) {
+          for (const auto& session : part.game.GetGameSessions()) {
+            CHECK(&parts[SessionPartition(game0, session->GetMapId(), session->GetSessionId(),
+                                          2)]
+                       .game == &part.game);
+          }
+          for (const Player& player : part.players.GetAllPlayers()) {
+            CHECK(part.game.FindGameSession(player.GetGameSession().GetSessionId()));
+          }
+        }
+        for (const Player& player : players.GetAllPlayers()) {
+          const bool in_part0 = players0.GetPlayerByToken(player.GetToken()) != nullptr;
+          const bool in_part1 = players1.GetPlayerByToken(player.GetToken()) != nullptr;
+          CHECK(in_part0 != in_part1);
+        }
+      }
+    }
+  }
+
+  GIVEN("a map without a session capacity") {
+    Game game = MakeGame(0);
+    Players players;
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE(JoinGame(game, players, Map::Id{"map"}, "Rex"));
+    }
+    std::stringstream snapshot;
+    SaveGame(game, players, snapshot);
+
+    THEN("its session and all its players go to the part of the map") {
+      Game game0 = MakeGame(0);
+      Game game1 = MakeGame(0);
+      Players players0;
+      Players players1;
+      LoadGameParts({{game0, players0}, {game1, players1}}, snapshot);
+
+      const bool to_part1 = MapPartition(Map::Id{"map"}, 2) == 1;
+      CHECK((to_part1 ? game1 : game0).GetGameSessions().size() == 1);
+      CHECK((to_part1 ? game0 : game1).GetGameSessions().empty());
+      CHECK((to_part1 ? players1 : players0).GetAllPlayers().size() == 4);
+    }
+  }
+}
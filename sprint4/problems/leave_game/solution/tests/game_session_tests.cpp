@@ -0,0 +1,489 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/model.h"
+
+using namespace model;
+
+namespace {
+
+Map MakeStraightRoadMap() {
+  Map map{Map::Id{"map"}, "Map"};
+  map.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 40});
+  map.SetLootValues({10, 20});
+  return map;
+}
+
+Dog::Id PlaceDog(GameSession& session, const std::string& name, double x, double speed) {
+  Dog& dog = session.AddDog(Dog{name});
+  dog.MoveDog({x, 0});
+  dog.SetDogSpeed(speed, 0);
+  return dog.GetId();
+}
+
+}  // namespace
+
+SCENARIO("Dogs gather loot in a game session") {
+  const Map map = MakeStraightRoadMap();
+
+  GIVEN("many dogs running through the same loot in one tick") {
+    GameSession session{map};
+    const auto loot_id = session.AddLoot({0, 10, {10, 0}});
+
+    constexpr int DOG_COUNT = 20;
+    std::vector<Dog::Id> dogs;
+    for (int i = 0; i < DOG_COUNT; ++i) {
+      dogs.push_back(PlaceDog(session, "dog" + std::to_string(i), i * 0.25, 20));
+    }
+
+    WHEN("collisions are processed") {
+      session.ProcessCollisions(1.0);
+
+      THEN("the loot is gathered exactly once, by the dog that reaches it first") {
+        CHECK(session.GetLoots().empty());
+        CHECK_FALSE(session.GetLoots().Contains(loot_id));
+
+        int gathered = 0;
+        for (const auto dog_id : dogs) {
+          gathered += static_cast<int>(session.FindDog(dog_id)->GetBag().GetSize());
+        }
+        CHECK(gathered == 1);
+        CHECK(session.FindDog(dogs.back())->GetBag().GetSize() == 1);
+      }
+    }
+  }
+
+  GIVEN("several loots along the road") {
+    GameSession session{map};
+    const auto first = session.AddLoot({0, 10, {5, 0}});
+    const auto second = session.AddLoot({1, 20, {15, 0}});
+    const auto third = session.AddLoot({0, 10, {30, 0}});
+    PlaceDog(session, "dog", 14, 2);
+
+    WHEN("a dog picks up the loot in the middle") {
+      session.ProcessCollisions(1.0);
+
+      THEN("the other loots keep their ids and positions") {
+        REQUIRE(session.GetLoots().size() == 2);
+        CHECK_FALSE(session.GetLoots().Contains(second));
+        REQUIRE(session.GetLoots().Find(first));
+        REQUIRE(session.GetLoots().Find(third));
+        CHECK(session.GetLoots().Find(first)->position.x == 5);
+        CHECK(session.GetLoots().Find(third)->position.x == 30);
+      }
+    }
+  }
+}
+
+SCENARIO("Dogs keep a compact state") {
+  GIVEN("a bag") {
+    Bag bag{3};
+
+    WHEN("it is filled over its capacity") {
+      for (size_t type = 0; type < 4; ++type) {
+        bag.AddLoot(type * 50);
+      }
+
+      THEN("it keeps the first items in order") {
+        CHECK(bag.IsFull());
+        CHECK(std::vector<size_t>(bag.GetItems().begin(), bag.GetItems().end()) ==
+              std::vector<size_t>{0, 50, 100});
+      }
+
+      AND_WHEN("its capacity shrinks") {
+        bag.SetCapacity(2);
+
+        THEN("the extra items are dropped") {
+          CHECK(bag.GetSize() == 2);
+          CHECK(bag.GetItems().back() == 50);
+        }
+      }
+    }
+
+    THEN("a capacity over the inline limit is rejected") {
+      CHECK_THROWS_AS(Bag{Bag::MAX_CAPACITY + 1}, std::invalid_argument);
+      CHECK_THROWS_AS(bag.SetCapacity(Bag::MAX_CAPACITY + 1), std::invalid_argument);
+      CHECK(bag.GetCapacity() == 3);
+    }
+  }
+
+  GIVEN("dogs with equal names") {
+    const Dog first{"Rex"};
+    const Dog second{std::string("Re") + "x"};
+    const Dog other{"Bim"};
+
+    THEN("they share one copy of the name") {
+      CHECK(&first.GetName() == &second.GetName());
+      CHECK(first.GetName() == "Rex");
+      CHECK(other.GetName() == "Bim");
+    }
+  }
+
+  GIVEN("a dog of a session") {
+    Map map = MakeStraightRoadMap();
+    map.SetDefaultDogSpeed(3);
+    GameSession session{map};
+    Dog& dog = session.AddDog(Dog{"dog"});
+
+    WHEN("it is sent along the road with the speed of the map") {
+      dog.SetDogDirSpeed("L", session.GetMapDefaultSpeed());
+
+      THEN("it moves with that speed") {
+        CHECK(dog.GetSpeed() == MoveInfo::Speed{-3, 0});
+        CHECK(dog.GetDirection() == MoveInfo::Direction::WEST);
+      }
+    }
+  }
+}
+
+SCENARIO("Idle players retire after the waiting time") {
+  const Map map = MakeStraightRoadMap();
+  auto session = std::make_shared<GameSession>(map);
+
+  Players players;
+  players.SetTimeWaitDog(10);
+
+  struct Retired {
+    std::string name;
+    double play_time;
+  };
+  std::vector<Retired> retired;
+  const auto on_retire = [&retired](const Dog& dog, double play_time) {
+    retired.push_back({dog.GetName(), play_time});
+  };
+
+  players.OnTick(5, on_retire);
+  const Token idle_token = players.AddPlayer(Dog{"idle"}, *session).GetToken();
+  const Token active_token = players.AddPlayer(Dog{"active"}, *session).GetToken();
+
+  WHEN("one player keeps moving and the other never acts") {
+    players.OnPlayerAction(*players.GetPlayerByToken(active_token), true);
+    players.OnTick(9.5, on_retire);
+
+    THEN("nobody retires before the deadline") {
+      CHECK(retired.empty());
+    }
+
+    players.OnTick(0.5, on_retire);
+
+    THEN("only the idle player retires, with play time counted from joining") {
+      REQUIRE(retired.size() == 1);
+      CHECK(retired[0].name == "idle");
+      CHECK(retired[0].play_time == 10);
+      CHECK_FALSE(players.GetPlayerByToken(idle_token));
+      CHECK(players.GetPlayerByToken(active_token));
+      CHECK(session->GetDogs().size() == 1);
+    }
+  }
+
+  WHEN("a player stops, moves again and then stops for good") {
+    const auto act = [&](bool moving) {
+      players.OnPlayerAction(*players.GetPlayerByToken(active_token), moving);
+    };
+    act(true);
+    players.OnTick(3, on_retire);
+    act(false);
+    players.OnTick(3, on_retire);
+    act(true);
+    players.OnTick(8, on_retire);
+    act(false);
+    act(false);
+
+    THEN("only the last stop starts the countdown") {
+      players.OnTick(9, on_retire);
+      CHECK(players.GetPlayerByToken(active_token));
+      players.OnTick(1, on_retire);
+      CHECK_FALSE(players.GetPlayerByToken(active_token));
+      REQUIRE(retired.size() == 2);
+      CHECK(retired[1].name == "active");
+      CHECK(retired[1].play_time == 24);
+    }
+  }
+}
+
+SCENARIO("Players share one registry entry across all lookups") {
+  const Map map = MakeStraightRoadMap();
+  auto session = std::make_shared<GameSession>(map);
+  Players players;
+
+  const Player& added = players.AddPlayer(Dog{"first"}, *session);
+  const Token first_token = added.GetToken();
+  const Dog::Id first_dog = added.GetDogId();
+  const Token second_token = players.AddPlayer(Dog{"second"}, *session).GetToken();
+
+  THEN("token and dog lookups find the same player object") {
+    Player* by_token = players.GetPlayerByToken(first_token);
+    REQUIRE(by_token);
+    CHECK(by_token == players.FindByDog(session->GetSessionId(), first_dog));
+    CHECK(&by_token->GetGameSession() == session.get());
+    CHECK(&by_token->GetDog() == session->FindDog(first_dog));
+    CHECK(players.GetAllPlayers().size() == 2);
+  }
+
+  WHEN("a player moves the dog through the registry") {
+    players.GetPlayerByToken(second_token)->MovePlayer("R");
+
+    THEN("the session sees the change") {
+      const Player* second = players.GetPlayerByToken(second_token);
+      CHECK(session->FindDog(second->GetDogId())->GetSpeed().x > 0);
+    }
+  }
+}
+
+SCENARIO("Dogs get dense ids unique within a session") {
+  const Map map = MakeStraightRoadMap();
+  GameSession session{map};
+
+  GIVEN("dogs with the same name") {
+    const Dog::Id first = session.AddDog(Dog{"Rex"}).GetId();
+    const Dog::Id second = session.AddDog(Dog{"Rex"}).GetId();
+    const Dog::Id third = session.AddDog(Dog{"Bim"}).GetId();
+
+    THEN("each dog has its own id starting from zero") {
+      CHECK(first == 0);
+      CHECK(second == 1);
+      CHECK(third == 2);
+      CHECK(session.GetDogs().size() == 3);
+    }
+
+    WHEN("a dog leaves and another joins") {
+      session.DeleteDog(second);
+      const Dog::Id next = session.AddDog(Dog{"Sharik"}).GetId();
+
+      THEN("the freed id is reused and other dogs keep theirs") {
+        CHECK(next == second);
+        CHECK(session.FindDog(next)->GetName() == "Sharik");
+        CHECK(session.FindDog(first)->GetName() == "Rex");
+        CHECK(session.FindDog(third)->GetName() == "Bim");
+        CHECK(session.GetDogIdAllocator().GetNextId() == 3);
+      }
+    }
+  }
+}
+
+SCENARIO("Restored sessions reject inconsistent dog ids") {
+  const auto map = std::make_shared<const Map>(MakeStraightRoadMap());
+  const auto restore = [&map](std::vector<Dog::Id> dog_ids, util::IdAllocator::Id next_id,
+                              std::vector<util::IdAllocator::Id> free_ids) {
+    std::vector<Dog> dogs;
+    for (const Dog::Id id : dog_ids) {
+      dogs.emplace_back("Rex", id, MoveInfo{});
+    }
+    return GameSession{std::move(dogs), map, 0, {},
+                       util::IdAllocator{next_id, std::move(free_ids)}};
+  };
+
+  THEN("a consistent state is restored and freed ids are reused") {
+    GameSession session = restore({0, 2}, 3, {1});
+    CHECK(session.AddDog(Dog{"Bim"}).GetId() == 1);
+    CHECK(session.AddDog(Dog{"Sharik"}).GetId() == 3);
+  }
+
+  THEN("a free id beyond the allocated range is rejected") {
+    CHECK_THROWS_AS(restore({0}, 2, {2}), std::invalid_argument);
+  }
+
+  THEN("a repeated free id is rejected") {
+    CHECK_THROWS_AS(restore({0}, 3, {1, 2, 1}), std::invalid_argument);
+  }
+
+  THEN("a free id of a live dog is rejected") {
+    CHECK_THROWS_AS(restore({0, 1}, 2, {1}), std::invalid_argument);
+  }
+
+  THEN("a repeated or out of range dog id is rejected") {
+    CHECK_THROWS_AS(restore({0, 0}, 2, {}), std::invalid_argument);
+    CHECK_THROWS_AS(restore({2}, 2, {}), std::invalid_argument);
+  }
+}
+
+SCENARIO("Maps spread players over session instances") {
+  Game game;
+  Map map = MakeStraightRoadMap();
+  map.SetSessionCapacity(2);
+  game.AddMap(std::move(map));
+  game.GetSettings().session_grace_period = 5;
+  const Map::Id map_id{"map"};
+
+  Players players;
+  const auto join = [&](const std::string& name) -> const Player& {
+    return players.AddPlayer(Dog{name}, *game.FindSessionForJoin(map_id));
+  };
+
+  WHEN("more players join than one session can hold") {
+    const auto first_session = join("a").GetGameSession().GetSessionId();
+    join("b");
+    const Player& third = join("c");
+    const auto third_session = third.GetGameSession().GetSessionId();
+    const Dog::Id third_dog = third.GetDogId();
+
+    THEN("a second instance of the map is created") {
+      CHECK(first_session != third_session);
+      CHECK(game.GetGameSessions().size() == 2);
+      CHECK(game.GetMapIdToSessionIds().at(map_id).size() == 2);
+      CHECK(players.FindByDog(third_session, third_dog)->GetDog().GetName() == "c");
+    }
+
+    AND_WHEN("the second instance has a free place") {
+      THEN("the next player fills it instead of creating a new one") {
+        CHECK(join("d").GetGameSession().GetSessionId() == third_session);
+        CHECK(game.GetGameSessions().size() == 2);
+      }
+    }
+
+    AND_WHEN("the second instance stays empty longer than the grace period") {
+      auto session = game.FindGameSession(third_session);
+      session->DeleteDog(third_dog);
+      game.Tick(4);
+      CHECK(game.GetGameSessions().size() == 2);
+      game.Tick(1);
+
+      THEN("it is reclaimed and the first instance remains") {
+        CHECK(game.GetGameSessions().size() == 1);
+        CHECK_FALSE(game.FindGameSession(third_session));
+        CHECK(game.FindGameSession(first_session));
+      }
+    }
+  }
+}
+
+SCENARIO("Reloaded maps replace the maps of a running game") {
+  const auto make_vertical_map = [](std::string id) {
+    Map map{Map::Id{std::move(id)}, "Vertical"};
+    map.AddRoad(Road{Road::VERTICAL, Point{0, 0}, 10});
+    map.SetLootValues({5});
+    return map;
+  };
+
+  Game game;
+  game.AddMap(MakeStraightRoadMap());
+  game.AddMap(make_vertical_map("same"));
+  game.AddMap(make_vertical_map("old"));
+  game.GetSettings().session_grace_period = 5;
+
+  auto changed_session = game.FindSessionForJoin(Map::Id{"map"});
+  Dog& far_dog = changed_session->AddDog(Dog{"far"});
+  far_dog.MoveDog({30, 0});
+  far_dog.SetDogSpeed(1, 0);
+  const Dog::Id far_dog_id = far_dog.GetId();
+  const Dog::Id near_dog_id = PlaceDog(*changed_session, "near", 10, 1);
+  changed_session->AddLoot({1, 20, {5, 0}});
+  changed_session->AddLoot({0, 10, {35, 0}});
+  changed_session->AddLoot({0, 10, {15, 0}});
+
+  auto same_session = game.FindSessionForJoin(Map::Id{"same"});
+  same_session->AddDog(Dog{"same"});
+  auto old_session = game.FindSessionForJoin(Map::Id{"old"});
+  const Dog::Id old_dog_id = old_session->AddDog(Dog{"old"}).GetId();
+
+  WHEN("a config with a changed, an unchanged, a removed and a new map is loaded") {
+    Game loaded;
+    Map shorter{Map::Id{"map"}, "Map"};
+    shorter.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 20});
+    shorter.SetLootValues({15});
+    loaded.AddMap(std::move(shorter));
+    loaded.AddMap(make_vertical_map("same"));
+    loaded.AddMap(make_vertical_map("new"));
+
+    const auto result = game.ReloadMaps(std::move(loaded));
+
+    THEN("every session is kept, migrated or retired") {
+      CHECK(result.kept == 1);
+      CHECK(result.migrated == 1);
+      CHECK(result.retired == 1);
+      CHECK(game.GetGameSessions().size() == 3);
+      REQUIRE(game.GetMaps().size() == 3);
+      CHECK(game.FindMap(Map::Id{"new"}));
+      CHECK_FALSE(game.FindMap(Map::Id{"old"}));
+    }
+
+    THEN("the session of an unchanged map uses the new map without changes") {
+      CHECK(&same_session->GetMap() == game.FindMap(Map::Id{"same"}));
+      CHECK(same_session->GetDogs().size() == 1);
+    }
+
+    THEN("the session of a changed map moves to the new map") {
+      CHECK(&changed_session->GetMap() == game.FindMap(Map::Id{"map"}));
+
+      const Dog* far = changed_session->FindDog(far_dog_id);
+      CHECK(far->GetPosition().x == 0);
+      CHECK(far->GetSpeed().x == 0);
+      CHECK(changed_session->FindDog(near_dog_id)->GetPosition().x == 10);
+
+      // Остаётся только трофей на дороге с типом, который есть на новой карте
+      REQUIRE(changed_session->GetLoots().size() == 1);
+      CHECK(changed_session->GetLoots()[0].position.x == 15);
+      CHECK(changed_session->GetLoots()[0].value == 15);
+    }
+
+    THEN("new players join the migrated session") {
+      CHECK(game.FindSessionForJoin(Map::Id{"map"}) == changed_session);
+    }
+
+    THEN("the session of a removed map keeps its map but takes no new players") {
+      CHECK(old_session->GetMapId() == Map::Id{"old"});
+      CHECK(old_session->GetMap().GetRoads().size() == 1);
+      CHECK_FALSE(game.FindSessionForJoin(Map::Id{"old"}));
+      game.Tick(1);
+      CHECK(old_session->GetDogs().size() == 1);
+    }
+
+    AND_WHEN("the session of a removed map stays empty longer than the grace period") {
+      old_session->DeleteDog(old_dog_id);
+      game.Tick(5);
+
+      THEN("it is reclaimed although its map has no other sessions") {
+        CHECK_FALSE(game.FindGameSession(old_session->GetSessionId()));
+        CHECK(game.GetGameSessions().size() == 2);
+      }
+    }
+  }
+}
+
+SCENARIO("Game session reports only objects in the area of interest") {
+  Map map{Map::Id{"map"}, "Map"};
+  map.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 100});
+  map.SetLootValues({10});
+  GameSession session{map};
+
+  const auto near_loot = session.AddLoot({0, 10, {5, 0}});
+  session.AddLoot({0, 10, {90, 0}});
+
+  const Dog::Id walker = session.AddDog(Dog{"walker"}).GetId();
+  const Dog::Id sitter = session.AddDog(Dog{"sitter"}).GetId();
+  session.FindDog(walker)->SetDogSpeed(10, 0);
+
+  const auto dogs_in = [&session](const util::InterestArea& area) {
+    std::vector<Dog::Id> ids;
+    session.ForEachDogIn(area, [&ids](const Dog& dog) { ids.push_back(dog.GetId()); });
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  };
+
+  THEN("objects near the start are found") {
+    const auto area = util::InterestArea::Circle({0, 0}, 10);
+    CHECK(dogs_in(area) == std::vector<Dog::Id>{walker, sitter});
+
+    std::vector<GameSession::LootId> loots;
+    session.ForEachLootIn(area, [&loots](GameSession::LootId id, const GameSession::Loot&) {
+      loots.push_back(id);
+    });
+    CHECK(loots == std::vector<GameSession::LootId>{near_loot});
+  }
+
+  WHEN("a dog walks away during ticks") {
+    for (int i = 0; i < 6; ++i) {
+      session.Tick(1);
+    }
+
+    THEN("the grid follows it") {
+      CHECK(dogs_in(util::InterestArea::Circle({0, 0}, 10)) == std::vector<Dog::Id>{sitter});
+      CHECK(dogs_in(util::InterestArea::Rect({55, -1}, {65, 1})) == std::vector<Dog::Id>{walker});
+    }
+  }
+}
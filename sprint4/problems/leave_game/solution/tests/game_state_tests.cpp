@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <optional>
+
+#include <boost/json.hpp>
+
+#include "../src/game_state.h"
+
+using namespace model;
+
+namespace {
+
+std::size_t SerializedLength(const GameSession& session,
+                             const std::optional<util::InterestArea>& area) {
+  return boost::json::serialize(game_state::SerializeSession(session, area)).size();
+}
+
+}  // namespace
+
+SCENARIO("Game state size for HEAD matches the serialized state") {
+  Map map{Map::Id{"map"}, "Map"};
+  map.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 40});
+  map.AddRoad(Road{Road::VERTICAL, Point{0, 0}, 30});
+  map.SetLootValues({10, 20, 30});
+  GameSession session{map};
+
+  GIVEN("an empty session") {
+    THEN("the size is the size of empty players and lost objects") {
+      CHECK(game_state::SerializedSessionSize(session, std::nullopt) ==
+            SerializedLength(session, std::nullopt));
+    }
+  }
+
+  GIVEN("dogs with bags, scores and fractional coordinates, and loot") {
+    for (int i = 0; i < 20; ++i) {
+      Dog& dog = session.AddDog(Dog{"Rex", 5});
+      dog.MoveDog({i * 1.7, 0});
+      dog.SetDogSpeed(i % 2 == 0 ? 1.25 : -0.1, i % 3 == 0 ? 0.5 : 0);
+      for (int k = 0; k < i % 6; ++k) {
+        dog.GetBag().AddLoot(k % 3);
+      }
+      dog.AddScore(i * 37);
+    }
+    session.GenerateLoot(15, 3);
+
+    THEN("the size equals the length of the whole serialized session") {
+      CHECK(game_state::SerializedSessionSize(session, std::nullopt) ==
+            SerializedLength(session, std::nullopt));
+    }
+
+    THEN("the size in an area of interest equals the length of the filtered state") {
+      const util::InterestArea area{{0, -1}, {10, 1}};
+      CHECK(game_state::SerializedSessionSize(session, area) ==
+            SerializedLength(session, area));
+
+      const util::InterestArea empty_area{{100, 100}, {101, 101}};
+      CHECK(game_state::SerializedSessionSize(session, empty_area) ==
+            SerializedLength(session, empty_area));
+    }
+  }
+}
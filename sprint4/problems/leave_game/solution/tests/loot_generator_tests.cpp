@@ -1,4 +1,6 @@
 #include <cmath>
+#include <random>
+#include <vector>
 #include <catch2/catch_test_macros.hpp>
 
 #include "../src/loot_generator.h"
@@ -72,3 +74,121 @@ SCENARIO("Loot generation") {
         }
     }
 }
+
+namespace {
+
+using loot_gen::SpawnBatch;
+using loot_gen::SpawnPolicy;
+using loot_gen::SpawnState;
+using Seconds = std::chrono::duration<double>;
+
+// Моделирует сессии с одним мародёром, который сразу подбирает появившийся трофей.
+// Возвращает среднее число трофеев в секунду на сессию.
+double MeasureSpawnRate(const SpawnPolicy& policy, size_t session_count, Seconds time_delta,
+                        unsigned ticks, std::mt19937& random) {
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::vector<SpawnState> states(session_count, SpawnState{policy});
+    SpawnBatch batch;
+    unsigned long long generated = 0;
+
+    for (unsigned tick = 0; tick < ticks; ++tick) {
+        batch.Clear();
+        for (const auto& state : states) {
+            batch.Add(state, 0, 1, dist(random));
+        }
+        batch.Generate(time_delta);
+        for (size_t i = 0; i < states.size(); ++i) {
+            states[i].time_without_loot = batch.GetTimeWithoutLoot(i);
+            generated += batch.GetGenerated(i);
+        }
+    }
+    return static_cast<double>(generated) / (session_count * ticks * time_delta.count());
+}
+
+}  // namespace
+
+SCENARIO("Batched loot spawning") {
+    using namespace std::chrono;
+    std::mt19937 random{2024};
+
+    GIVEN("a rate policy without random factor") {
+        const auto policy = SpawnPolicy::Rate(1s, 0.5);
+
+        THEN("it generates the same loot as LootGenerator") {
+            loot_gen::LootGenerator gen{1s, 0.5};
+            SpawnState state{policy};
+            const std::vector<loot_gen::LootGenerator::TimeInterval> deltas = {100ms, 250ms, 1s, 30ms, 3s,
+                                                                     500ms, 2s,    10ms};
+            for (unsigned looters = 0; looters < 6; ++looters) {
+                for (auto delta : deltas) {
+                    INFO("looters: " << looters << ", delta: " << delta.count());
+                    const unsigned expected = gen.Generate(delta, 0, looters);
+                    CHECK(loot_gen::Generate(state, delta, 0, looters) == expected);
+                }
+            }
+        }
+    }
+
+    GIVEN("a rate policy with random factor") {
+        const auto policy = SpawnPolicy::Rate(1s, 0.5);
+        constexpr size_t SESSIONS = 1000;
+        constexpr unsigned TICKS = 300;
+        constexpr auto DELTA = 100ms;
+
+        THEN("the spawn rate matches independent LootGenerators") {
+            std::uniform_real_distribution<double> dist(0.0, 1.0);
+            unsigned long long expected = 0;
+            for (size_t session = 0; session < SESSIONS; ++session) {
+                loot_gen::LootGenerator gen{1s, 0.5, [&] {
+                                                return dist(random);
+                                            }};
+                for (unsigned tick = 0; tick < TICKS; ++tick) {
+                    expected += gen.Generate(DELTA, 0, 1);
+                }
+            }
+            const double expected_rate
+                = static_cast<double>(expected) / (SESSIONS * TICKS * Seconds{DELTA}.count());
+
+            const double rate = MeasureSpawnRate(policy, SESSIONS, DELTA, TICKS, random);
+            CHECK(std::abs(rate - expected_rate) < 0.03 * expected_rate);
+        }
+
+        THEN("the spawn rate of a session does not depend on the number of sessions") {
+            const double alone = MeasureSpawnRate(policy, 1, DELTA, TICKS * 300, random);
+            const double crowded = MeasureSpawnRate(policy, SESSIONS, DELTA, TICKS, random);
+            CHECK(std::abs(alone - crowded) < 0.05 * crowded);
+        }
+    }
+
+    GIVEN("a burst policy") {
+        constexpr double PROBABILITY = 0.3;
+        const auto policy = SpawnPolicy::Burst(2s, PROBABILITY);
+
+        THEN("one roll per base interval gives probability / interval spawns per second") {
+            const double rate = MeasureSpawnRate(policy, 1000, 100ms, 400, random);
+            CHECK(std::abs(rate - PROBABILITY / 2.0) < 0.01);
+        }
+
+        THEN("a successful roll fills the whole shortage at once") {
+            SpawnState state{policy};
+            CHECK(loot_gen::Generate(state, 1s, 2, 7, 0.1) == 0);
+            CHECK(loot_gen::Generate(state, 1s, 2, 7, 0.1) == 5);
+            CHECK(loot_gen::Generate(state, 2s, 2, 7, 0.9) == 0);
+            CHECK(state.time_without_loot == Seconds{0});
+        }
+    }
+
+    GIVEN("a capped policy") {
+        const auto policy = SpawnPolicy::Capped(1s, 0.5, 3);
+
+        THEN("loot on the map never exceeds the cap") {
+            SpawnState state{policy};
+            unsigned loot = 0;
+            for (int tick = 0; tick < 100; ++tick) {
+                loot += loot_gen::Generate(state, 500ms, loot, 10);
+                REQUIRE(loot <= 3);
+            }
+            CHECK(loot == 3);
+        }
+    }
+}
@@ -0,0 +1,155 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "../src/map_cache.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+model::Game MakeGame() {
+  using namespace model;
+
+  Game game;
+  game.SetDefaultDogSpeed(3);
+  game.SetDefaultBagCapacity(4);
+  game.GetSettings().dog_retirement_time = 15;
+  game.GetSettings().session_capacity = 20;
+  game.SetSpawnPolicy(loot_gen::SpawnPolicy::Rate(std::chrono::seconds{5}, 0.5));
+
+  Map town{Map::Id{"town"}, "Town"};
+  town.SetDefaultDogSpeed(2.5);
+  town.SetBagCapacity(2);
+  town.SetLootValues({10, 30});
+  town.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 40});
+  town.AddRoad(Road{Road::VERTICAL, Point{40, 0}, 30});
+  town.AddBuilding(Building{Rectangle{Point{5, 5}, Size{30, 20}}});
+  town.AddOffice(Office{Office::Id{"o0"}, Point{40, 30}, Offset{5, 0}});
+  game.AddMap(std::move(town));
+
+  Map village{Map::Id{"village"}, "Деревня"};
+  village.SetDefaultDogSpeed(3);
+  village.SetBagCapacity(4);
+  village.SetLootValues({5});
+  village.SetSpawnPolicy(loot_gen::SpawnPolicy::Capped(std::chrono::seconds{2}, 0.8, 7));
+  village.SetSessionCapacity(3);
+  village.AddRoad(Road{Road::VERTICAL, Point{0, 0}, 10});
+  game.AddMap(std::move(village));
+
+  return game;
+}
+
+class TempDir {
+ public:
+  TempDir()
+      : path_(fs::temp_directory_path() /
+              ("map_cache_tests_" + std::to_string(std::random_device{}()))) {
+    fs::create_directories(path_);
+  }
+
+  ~TempDir() {
+    std::error_code ec;
+    fs::remove_all(path_, ec);
+  }
+
+  const fs::path& Get() const {
+    return path_;
+  }
+
+ private:
+  fs::path path_;
+};
+
+}  // namespace
+
+SCENARIO("Map cache restores maps and settings of the game") {
+  GIVEN("a game saved to the cache") {
+    TempDir dir;
+    const fs::path cache = dir.Get() / "maps.bin";
+    const model::Game original = MakeGame();
+    const map_cache::LootTypes loot_types = {{model::Map::Id{"town"}, R"([{"value":10}])"}};
+    map_cache::Save(cache, 42, original, loot_types);
+
+    WHEN("it is loaded with the same config hash") {
+      auto contents = map_cache::Load(cache, 42);
+
+      THEN("maps, settings and loot types are the same") {
+        REQUIRE(contents);
+        const model::Game& game = contents->game;
+        CHECK(game.GetDefaultDogSpeed() == 3);
+        CHECK(game.GetDefaultBagCapacity() == 4);
+        CHECK(game.GetSettings().dog_retirement_time == 15);
+        CHECK(game.GetSettings().session_capacity == 20);
+        CHECK(game.GetDefaultSpawnPolicy().probability == 0.5);
+        CHECK(contents->loot_types == loot_types);
+
+        REQUIRE(game.GetMaps().size() == 2);
+        const model::Map* town = game.FindMap(model::Map::Id{"town"});
+        REQUIRE(town);
+        CHECK(town->GetName() == "Town");
+        CHECK(town->GetDefaultDogSpeed() == 2.5);
+        CHECK(town->GetBagCapacity() == 2);
+        CHECK(town->GetLootValues() == std::vector{10, 30});
+        CHECK_FALSE(town->GetSpawnPolicy());
+        CHECK_FALSE(town->GetSessionCapacity());
+        REQUIRE(town->GetRoads().size() == 2);
+        CHECK(town->GetRoads()[0].IsHorizontal());
+        CHECK(town->GetRoads()[0].GetEnd().x == 40);
+        CHECK(town->GetRoads()[1].IsVertical());
+        CHECK(town->GetRoads()[1].GetEnd().y == 30);
+        REQUIRE(town->GetBuildings().size() == 1);
+        CHECK(town->GetBuildings()[0].GetBounds().size.height == 20);
+        REQUIRE(town->GetOffices().size() == 1);
+        CHECK(*town->GetOffices()[0].GetId() == "o0");
+        CHECK(town->GetOffices()[0].GetOffset().dx == 5);
+
+        const model::Map& village = game.GetMaps()[1];
+        CHECK(village.GetName() == "Деревня");
+        REQUIRE(village.GetSpawnPolicy());
+        CHECK(village.GetSpawnPolicy()->kind == loot_gen::SpawnPolicy::Kind::CAPPED);
+        CHECK(village.GetSpawnPolicy()->max_loot == 7);
+        CHECK(village.GetSessionCapacity() == 3);
+      }
+    }
+
+    THEN("a cache built for another config is stale") {
+      CHECK_FALSE(map_cache::Load(cache, 43));
+    }
+
+    THEN("a truncated cache is stale") {
+      fs::resize_file(cache, fs::file_size(cache) - 1);
+      CHECK_FALSE(map_cache::Load(cache, 42));
+    }
+
+    THEN("a cache with a map beyond the bag limits is stale") {
+      model::Game game = MakeGame();
+      model::Map huge{model::Map::Id{"huge"}, "Huge"};
+      huge.SetBagCapacity(static_cast<int>(model::Bag::MAX_CAPACITY) + 1);
+      huge.AddRoad(model::Road{model::Road::HORIZONTAL, model::Point{0, 0}, 10});
+      game.AddMap(std::move(huge));
+      map_cache::Save(cache, 42, game, {});
+      CHECK_FALSE(map_cache::Load(cache, 42));
+    }
+
+    THEN("a missing or foreign file is stale") {
+      CHECK_FALSE(map_cache::Load(dir.Get() / "missing.bin", 42));
+      std::ofstream{dir.Get() / "foreign.bin"} << "not a map cache at all, just text";
+      CHECK_FALSE(map_cache::Load(dir.Get() / "foreign.bin", 42));
+    }
+  }
+}
+
+SCENARIO("Config hash depends on the file content") {
+  TempDir dir;
+  const fs::path config = dir.Get() / "config.json";
+  std::ofstream{config} << R"({"maps":[]})";
+  const auto hash = map_cache::HashFile(config);
+
+  CHECK(map_cache::HashFile(config) == hash);
+  std::ofstream{config} << R"({"maps":[ ]})";
+  CHECK(map_cache::HashFile(config) != hash);
+}
@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../src/metrics.h"
+
+using metrics::Histogram;
+
+SCENARIO("Histogram buckets split each power of two into 16 parts") {
+  GIVEN("values below the first power of two with sub-buckets") {
+    THEN("each value has its own bucket") {
+      for (std::uint64_t value = 0; value < Histogram::SUB_BUCKETS; ++value) {
+        const auto index = Histogram::BucketIndex(value);
+        CHECK(index == value);
+        CHECK(Histogram::BucketLowerBound(index) == value);
+        CHECK(Histogram::BucketUpperBound(index) == value);
+      }
+    }
+  }
+
+  GIVEN("every power of two in the range") {
+    THEN("a power of two starts a bucket and the value before it ends the previous one") {
+      for (unsigned exponent = Histogram::SUB_BUCKET_BITS; exponent < Histogram::MAX_EXPONENT;
+           ++exponent) {
+        INFO("exponent " << exponent);
+        const std::uint64_t power = std::uint64_t{1} << exponent;
+        const auto index = Histogram::BucketIndex(power);
+        CHECK(index == (exponent - Histogram::SUB_BUCKET_BITS + 1) * Histogram::SUB_BUCKETS);
+        CHECK(Histogram::BucketLowerBound(index) == power);
+        CHECK(Histogram::BucketIndex(power - 1) == index - 1);
+        CHECK(Histogram::BucketUpperBound(index - 1) == power - 1);
+        // Ширина корзины - 1/16 от начала интервала
+        CHECK(Histogram::BucketUpperBound(index) - power + 1 == power / Histogram::SUB_BUCKETS);
+      }
+    }
+
+    THEN("bucket bounds follow each other without gaps") {
+      for (std::size_t index = 1; index < Histogram::BUCKETS; ++index) {
+        INFO("bucket " << index);
+        CHECK(Histogram::BucketLowerBound(index) == Histogram::BucketUpperBound(index - 1) + 1);
+        CHECK(Histogram::BucketIndex(Histogram::BucketLowerBound(index)) == index);
+        CHECK(Histogram::BucketIndex(Histogram::BucketUpperBound(index)) == index);
+      }
+    }
+  }
+
+  GIVEN("values beyond the range") {
+    THEN("they fall into the last bucket") {
+      const std::uint64_t limit = std::uint64_t{1} << Histogram::MAX_EXPONENT;
+      CHECK(Histogram::BucketIndex(limit - 1) == Histogram::BUCKETS - 1);
+      CHECK(Histogram::BucketIndex(limit) == Histogram::BUCKETS - 1);
+      CHECK(Histogram::BucketIndex(UINT64_MAX) == Histogram::BUCKETS - 1);
+    }
+  }
+}
+
+SCENARIO("Histogram quantiles are reported with the bucket precision") {
+  GIVEN("an empty histogram") {
+    const auto histogram = std::make_unique<Histogram>();
+    const auto snapshot = histogram->TakeSnapshot();
+
+    THEN("every quantile is zero") {
+      CHECK(snapshot.count == 0);
+      CHECK(snapshot.ValueAtQuantile(0.5) == 0);
+      CHECK(snapshot.ValueAtQuantile(1) == 0);
+    }
+  }
+
+  GIVEN("values from 1 to 1000") {
+    const auto histogram = std::make_unique<Histogram>();
+    for (std::uint64_t value = 1; value <= 1000; ++value) {
+      histogram->Record(value);
+    }
+    const auto snapshot = histogram->TakeSnapshot();
+
+    THEN("count and sum are exact") {
+      CHECK(snapshot.count == 1000);
+      CHECK(snapshot.sum == 500500);
+    }
+
+    THEN("a quantile is the upper bound of the bucket holding the value of its rank") {
+      CHECK(snapshot.ValueAtQuantile(0) == 1);
+      CHECK(snapshot.ValueAtQuantile(0.01) == 10);
+      // 500 лежит в корзине 496..511, 990 - в 960..991, 1000 - в 992..1023
+      CHECK(snapshot.ValueAtQuantile(0.5) == 511);
+      CHECK(snapshot.ValueAtQuantile(0.99) == 991);
+      CHECK(snapshot.ValueAtQuantile(1) == 1023);
+      CHECK(snapshot.ValueAtQuantile(2) == 1023);
+    }
+
+    THEN("counts below a value include only whole buckets") {
+      CHECK(snapshot.CountAtOrBelow(15) == 15);
+      CHECK(snapshot.CountAtOrBelow(511) == 511);
+      // Корзина 496..511 не входит целиком в значения не больше 500
+      CHECK(snapshot.CountAtOrBelow(500) == 495);
+      CHECK(snapshot.CountAtOrBelow(UINT64_MAX) == 1000);
+    }
+
+    WHEN("it is merged with a snapshot of the same values") {
+      auto merged = snapshot;
+      merged.Merge(snapshot);
+
+      THEN("quantiles stay the same") {
+        CHECK(merged.count == 2000);
+        CHECK(merged.sum == 1001000);
+        CHECK(merged.ValueAtQuantile(0.5) == 511);
+        CHECK(merged.ValueAtQuantile(0.99) == 991);
+      }
+    }
+  }
+}
+
+SCENARIO("Registry exports metrics in the Prometheus text format") {
+  GIVEN("a registry with a metric of each type") {
+    metrics::Registry registry;
+    registry.AddCounter("app_requests_total", "Requests", {{"path", "a\"b\\c\nd"}}).Inc(3);
+    registry.AddGauge("app_sessions", "Sessions").Set(-2);
+
+    auto& sizes = registry.AddHistogram("app_size", "Sizes", {1.0, {1, 5, 10}}, {{"kind", "x"}});
+    for (std::uint64_t value : {0, 3, 7, 20}) {
+      sizes.Record(value);
+    }
+    // Значения записаны в миллисекундах и экспортируются в секундах
+    auto& latency = registry.AddHistogram("app_latency_seconds", "Latency", {1e-3, {1, 2}});
+    latency.Record(std::uint64_t{500});
+    latency.Record(std::uint64_t{1500});
+
+    THEN("families are sorted by name, labels are escaped and histograms are cumulative") {
+      const std::string expected = R"(# HELP app_latency_seconds Latency
+# TYPE app_latency_seconds histogram
+app_latency_seconds_bucket{le="1"} 1
+app_latency_seconds_bucket{le="2"} 2
+app_latency_seconds_bucket{le="+Inf"} 2
+app_latency_seconds_sum 2
+app_latency_seconds_count 2
+# HELP app_requests_total Requests
+# TYPE app_requests_total counter
+app_requests_total{path="a\"b\\c\nd"} 3
+# HELP app_sessions Sessions
+# TYPE app_sessions gauge
+app_sessions -2
+# HELP app_size Sizes
+# TYPE app_size histogram
+app_size_bucket{kind="x",le="1"} 1
+app_size_bucket{kind="x",le="5"} 2
+app_size_bucket{kind="x",le="10"} 3
+app_size_bucket{kind="x",le="+Inf"} 4
+app_size_sum{kind="x"} 30
+app_size_count{kind="x"} 4
+)";
+      CHECK(registry.Serialize() == expected);
+    }
+  }
+}
@@ -0,0 +1,206 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <boost/json.hpp>
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/model.h"
+#include "../src/region_movement.h"
+
+using namespace model;
+using Catch::Matchers::WithinAbs;
+
+namespace {
+
+// Карты из data/config.json; файла может не быть, если тесты собраны отдельно от данных
+std::vector<Map> LoadBundledMaps() {
+  const std::filesystem::path path = std::filesystem::path{GAME_DATA_DIR} / "config.json";
+  std::ifstream file{path};
+  if (!file) {
+    return {};
+  }
+  const std::string text{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  const auto config = boost::json::parse(text).as_object();
+  const double default_speed = config.contains("defaultDogSpeed")
+                                   ? config.at("defaultDogSpeed").to_number<double>()
+                                   : 1.0;
+
+  std::vector<Map> maps;
+  for (const auto& map_value : config.at("maps").as_array()) {
+    const auto& map_obj = map_value.as_object();
+    Map& map = maps.emplace_back(Map::Id{std::string{map_obj.at("id").as_string()}},
+                                 std::string{map_obj.at("name").as_string()});
+    map.SetDefaultDogSpeed(map_obj.contains("dogSpeed")
+                               ? map_obj.at("dogSpeed").to_number<double>()
+                               : default_speed);
+    for (const auto& road_value : map_obj.at("roads").as_array()) {
+      const auto& road = road_value.as_object();
+      const auto coord = [&road](const char* key) {
+        return static_cast<model::Coord>(road.at(key).as_int64());
+      };
+      const Point start{coord("x0"), coord("y0")};
+      if (road.contains("x1")) {
+        map.AddRoad(Road{Road::HORIZONTAL, start, coord("x1")});
+      } else {
+        map.AddRoad(Road{Road::VERTICAL, start, coord("y1")});
+      }
+    }
+  }
+  return maps;
+}
+
+// Решётка улиц со случайными пропусками, тупиками и дорогами нулевой длины
+Map MakeRandomMap(std::mt19937& random) {
+  Map map{Map::Id{"random"}, "Random"};
+  map.SetDefaultDogSpeed(3);
+  std::uniform_int_distribution<model::Coord> coord{0, 40};
+  std::uniform_int_distribution<model::Coord> length{0, 15};
+  for (int i = 0; i < 30; ++i) {
+    const Point start{coord(random), coord(random)};
+    const model::Coord offset = length(random) - 7;
+    if (i % 2 == 0) {
+      map.AddRoad(Road{Road::HORIZONTAL, start, start.x + offset});
+    } else {
+      map.AddRoad(Road{Road::VERTICAL, start, start.y + offset});
+    }
+  }
+  return map;
+}
+
+struct Mismatch {
+  int tick = 0;
+  std::string description;
+};
+
+// Прогоняет собак по одним и тем же командам через сессию и через прежний
+// способ перемещения. Шаг меньше зазора между соседними дорогами (0.2),
+// иначе прежний способ перепрыгивает через зазор.
+std::vector<Mismatch> CompareEngines(const Map& map, unsigned seed, int ticks) {
+  constexpr int DOG_COUNT = 16;
+  const double dt = 0.15 / map.GetDefaultDogSpeed();
+  const std::array<std::string, 5> directions{"L", "R", "U", "D", ""};
+
+  std::mt19937 random{seed};
+  GameSession session{map};
+  const RegionMovement reference{map};
+
+  std::vector<Dog::Id> ids;
+  std::vector<Dog> reference_dogs;
+  for (int i = 0; i < DOG_COUNT; ++i) {
+    Dog& dog = session.AddDog(Dog{"dog" + std::to_string(i)});
+    dog.SetDefaultDogSpeed(map.GetDefaultDogSpeed());
+    ids.push_back(dog.GetId());
+    reference_dogs.push_back(dog);
+  }
+
+  std::vector<Mismatch> mismatches;
+  for (int tick = 0; tick < ticks; ++tick) {
+    for (int i = 0; i < DOG_COUNT; ++i) {
+      Dog& dog = *session.FindDog(ids[i]);
+      if (random() % 25 == 0 || dog.GetSpeed() == MoveInfo::Speed{0, 0}) {
+        const std::string& dir = directions[random() % directions.size()];
+        dog.SetDogDirSpeed(dir, session.GetMapDefaultSpeed());
+        reference_dogs[i].SetDogDirSpeed(dir, session.GetMapDefaultSpeed());
+      }
+      session.MovePlayer(ids[i], dt);
+      reference.MoveDog(reference_dogs[i], dt);
+
+      const auto& actual = dog.GetPosition();
+      const auto& expected = reference_dogs[i].GetPosition();
+      if (actual != expected || !(dog.GetSpeed() == reference_dogs[i].GetSpeed())) {
+        std::ostringstream description;
+        description << "dog " << i << ": (" << actual.x << ", " << actual.y << ") vs ("
+                    << expected.x << ", " << expected.y << ")";
+        mismatches.push_back({tick, description.str()});
+        // Дальше собаки идут разными путями, сравнивать их незачем
+        reference_dogs[i] = dog;
+      }
+    }
+  }
+  return mismatches;
+}
+
+}  // namespace
+
+SCENARIO("Dogs move along the road graph") {
+  GIVEN("two collinear roads joined end to end and a crossing dead end") {
+    Map map{Map::Id{"map"}, "Map"};
+    map.AddRoad(Road{Road::HORIZONTAL, Point{0, 0}, 10});
+    map.AddRoad(Road{Road::HORIZONTAL, Point{10, 0}, 20});
+    map.AddRoad(Road{Road::VERTICAL, Point{5, 0}, 4});
+    map.AddRoad(Road{Road::VERTICAL, Point{5, 6}, 10});
+    const auto& graph = map.GetRoadGraph();
+
+    THEN("touching and crossing roads are neighbours") {
+      REQUIRE(graph.SegmentsCount() == 4);
+      CHECK(graph.GetSegment(0).neighbors.size() == 2);
+      CHECK(graph.GetSegment(3).neighbors.empty());
+    }
+
+    WHEN("a dog makes one long step east") {
+      const auto result = graph.Move({1, 0}, road_graph::NO_SEGMENT, {50, 0});
+
+      THEN("it passes the joint and stops at the far end in one step") {
+        CHECK(result.stopped);
+        CHECK_THAT(result.position.x, WithinAbs(20.4, 1e-10));
+        CHECK(result.position.y == 0);
+        CHECK(result.segment == 1);
+      }
+    }
+
+    WHEN("a dog makes a long step south along the dead end") {
+      const auto result = graph.Move({5, 0}, road_graph::NO_SEGMENT, {0, 100});
+
+      THEN("it does not jump over the gap to the separate road") {
+        CHECK(result.stopped);
+        CHECK(result.position.x == 5);
+        CHECK_THAT(result.position.y, WithinAbs(4.4, 1e-10));
+      }
+    }
+
+    WHEN("a dog steps within the road") {
+      const auto result = graph.Move({2, 0.1}, 0, {-2.4, 0});
+
+      THEN("it reaches the edge exactly without stopping") {
+        CHECK_FALSE(result.stopped);
+        CHECK_THAT(result.position.x, WithinAbs(-0.4, 1e-10));
+        CHECK(result.position.y == 0.1);
+      }
+    }
+  }
+}
+
+TEST_CASE("Road graph movement matches the region movement on random maps") {
+  std::mt19937 random{42};
+  for (unsigned round = 0; round < 10; ++round) {
+    const Map map = MakeRandomMap(random);
+    const auto mismatches = CompareEngines(map, round, 2000);
+    INFO("round " << round << ", first mismatch at tick "
+                  << (mismatches.empty() ? 0 : mismatches.front().tick) << ": "
+                  << (mismatches.empty() ? "" : mismatches.front().description));
+    CHECK(mismatches.empty());
+  }
+}
+
+TEST_CASE("Road graph movement matches the region movement on bundled maps") {
+  const auto maps = LoadBundledMaps();
+  if (maps.empty()) {
+    WARN("config.json not found in " GAME_DATA_DIR);
+    return;
+  }
+  for (const auto& map : maps) {
+    const auto mismatches = CompareEngines(map, 7, 5000);
+    INFO("map " << *map.GetId() << ", first mismatch at tick "
+                << (mismatches.empty() ? 0 : mismatches.front().tick) << ": "
+                << (mismatches.empty() ? "" : mismatches.front().description));
+    CHECK(mismatches.empty());
+  }
+}
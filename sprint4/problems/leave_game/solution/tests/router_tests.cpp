@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <string_view>
+
+#include "../src/router.h"
+
+namespace {
+
+using router::On;
+using Verb = router::http::verb;
+
+constexpr router::Router ROUTES{std::array{
+    router::MakeRoute("/api/v1/maps", On(Verb::get, 1), On(Verb::head, 2)),
+    router::MakeRoute("/api/v1/maps/{id}", On(Verb::get, 3), On(Verb::head, 4)),
+    router::MakeRoute("/api/v1/game/join", On(Verb::post, 5)),
+    router::MakeRoute("/api/v1/game/state", On(Verb::get, 6), On(Verb::head, 7)),
+    router::MakeRoute("/api/v1/users/{user}/items/{item}", On(Verb::delete_, 8)),
+}};
+
+// Таблица строится и работает при компиляции
+static_assert(*ROUTES.Find("/api/v1/game/join", Verb::post).handler == 5);
+static_assert(ROUTES.Find("/api/v1/maps/town", Verb::get).params[0] == "town");
+
+}  // namespace
+
+SCENARIO("Router finds routes declared at compile time") {
+  GIVEN("a table with static and parameterized routes") {
+    THEN("a static path finds the handler of the request method") {
+      const auto match = ROUTES.Find("/api/v1/maps", Verb::head);
+      REQUIRE(match.handler != nullptr);
+      CHECK(*match.handler == 2);
+      CHECK(match.params.size() == 0);
+    }
+
+    THEN("the query string does not take part in the lookup") {
+      const auto match = ROUTES.Find("/api/v1/game/state?radius=10", Verb::get);
+      REQUIRE(match.handler != nullptr);
+      CHECK(*match.handler == 6);
+    }
+
+    THEN("path parameters are returned as views of the target") {
+      const std::string_view target = "/api/v1/users/alice/items/42?force=1";
+      const auto match = ROUTES.Find(target, Verb::delete_);
+      REQUIRE(match.handler != nullptr);
+      CHECK(*match.handler == 8);
+      REQUIRE(match.params.size() == 2);
+      CHECK(match.params[0] == "alice");
+      CHECK(match.params[1] == "42");
+      CHECK(match.params[0].data() == target.data() + 14);
+    }
+
+    THEN("a known path with another method gives the precomputed Allow header") {
+      const auto match = ROUTES.Find("/api/v1/maps/town", Verb::post);
+      CHECK(match.handler == nullptr);
+      CHECK(match.IsPathFound());
+      CHECK(match.allow == "GET, HEAD");
+      CHECK(ROUTES.Find("/api/v1/game/join", Verb::get).allow == "POST");
+    }
+
+    THEN("unknown paths are not found") {
+      for (std::string_view target :
+           {"/", "/api/v1/maps/", "/api/v1/maps/town/extra", "/api/v1/map", "/api/v1/mapsx",
+            "/api/v1/users//items/1", "api/v1/maps", ""}) {
+        INFO(target);
+        const auto match = ROUTES.Find(target, Verb::get);
+        CHECK(match.handler == nullptr);
+        CHECK_FALSE(match.IsPathFound());
+      }
+    }
+  }
+}
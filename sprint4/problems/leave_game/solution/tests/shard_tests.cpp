@@ -0,0 +1,119 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/shard.h"
+
+namespace {
+
+class CountingTask : public shard::Task {
+ public:
+  CountingTask(int value, std::vector<int>& log) : value_(value), log_(log) {
+  }
+
+  void Run() override {
+    log_.push_back(value_);
+  }
+
+ private:
+  int value_;
+  std::vector<int>& log_;
+};
+
+}  // namespace
+
+SCENARIO("Task queue returns tasks in insertion order") {
+  GIVEN("an empty queue") {
+    shard::TaskQueue queue;
+    std::vector<int> log;
+
+    THEN("it is empty") {
+      CHECK(queue.IsEmpty());
+      CHECK(queue.Pop() == nullptr);
+    }
+
+    WHEN("tasks are pushed and popped in turns") {
+      std::vector<std::unique_ptr<CountingTask>> tasks;
+      for (int i = 0; i < 5; ++i) {
+        tasks.push_back(std::make_unique<CountingTask>(i, log));
+      }
+      queue.Push(tasks[0].get());
+      queue.Push(tasks[1].get());
+      queue.Pop()->Run();
+      queue.Push(tasks[2].get());
+      queue.Push(tasks[3].get());
+      while (auto* task = queue.Pop()) {
+        task->Run();
+      }
+      queue.Push(tasks[4].get());
+
+      THEN("every task comes out once, first in first out") {
+        CHECK_FALSE(queue.IsEmpty());
+        queue.Pop()->Run();
+        CHECK(log == std::vector{0, 1, 2, 3, 4});
+        CHECK(queue.IsEmpty());
+        CHECK(queue.Pop() == nullptr);
+      }
+    }
+  }
+}
+
+SCENARIO("Shard runs tasks posted from other threads") {
+  GIVEN("a running shard and several producer threads") {
+    constexpr int PRODUCERS = 4;
+    constexpr int TASKS = 10000;
+
+    shard::Shard shard{0};
+    shard.Start();
+
+    // Изменяются только в потоке шарда
+    std::vector<int> last(PRODUCERS, -1);
+    bool ordered = true;
+    bool in_shard_thread = true;
+    std::atomic<int> done{0};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p) {
+      producers.emplace_back([&, p] {
+        for (int i = 0; i < TASKS; ++i) {
+          shard.Post([&, p, i] {
+            ordered = ordered && last[p] + 1 == i;
+            in_shard_thread = in_shard_thread && shard::Shard::Current() == &shard;
+            last[p] = i;
+            done.fetch_add(1, std::memory_order_release);
+          });
+        }
+      });
+    }
+    for (auto& producer : producers) {
+      producer.join();
+    }
+    while (done.load(std::memory_order_acquire) < PRODUCERS * TASKS) {
+      std::this_thread::yield();
+    }
+    shard.Stop();
+    shard.Join();
+
+    THEN("tasks of each producer run in the shard thread in posting order") {
+      CHECK(ordered);
+      CHECK(in_shard_thread);
+      CHECK(shard::Shard::Current() == nullptr);
+    }
+  }
+
+  GIVEN("a shard that is never started") {
+    auto owned = std::make_shared<int>(42);
+    std::weak_ptr<int> watch = owned;
+    {
+      shard::Shard shard{0};
+      shard.Post([owned = std::move(owned)] {});
+    }
+
+    THEN("pending tasks are destroyed with the shard") {
+      CHECK(watch.expired());
+    }
+  }
+}
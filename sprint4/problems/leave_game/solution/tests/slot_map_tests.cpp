@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../src/slot_map.h"
+
+SCENARIO("Slot map keeps keys stable") {
+  using Map = util::SlotMap<std::string>;
+
+  GIVEN("a slot map with three values") {
+    Map map;
+    const auto a = map.Insert("a");
+    const auto b = map.Insert("b");
+    const auto c = map.Insert("c");
+
+    THEN("every key finds its value") {
+      REQUIRE(map.size() == 3);
+      CHECK(*map.Find(a) == "a");
+      CHECK(*map.Find(b) == "b");
+      CHECK(*map.Find(c) == "c");
+    }
+
+    WHEN("a value in the middle is erased") {
+      REQUIRE(map.Erase(b));
+
+      THEN("other keys still find their values") {
+        REQUIRE(map.size() == 2);
+        CHECK(*map.Find(a) == "a");
+        CHECK(*map.Find(c) == "c");
+      }
+
+      THEN("the erased key finds nothing") {
+        CHECK_FALSE(map.Contains(b));
+        CHECK(map.Find(b) == nullptr);
+        CHECK_FALSE(map.Erase(b));
+      }
+
+      THEN("values stay dense and KeyAt matches them") {
+        std::vector<std::string> values(map.begin(), map.end());
+        std::sort(values.begin(), values.end());
+        CHECK(values == std::vector<std::string>{"a", "c"});
+        for (size_t i = 0; i < map.size(); ++i) {
+          CHECK(*map.Find(map.KeyAt(i)) == map[i]);
+        }
+      }
+
+      AND_WHEN("a new value is inserted") {
+        const auto d = map.Insert("d");
+
+        THEN("it reuses the slot with a new generation") {
+          CHECK(d.index == b.index);
+          CHECK(d.generation != b.generation);
+          CHECK_FALSE(map.Contains(b));
+          CHECK(*map.Find(d) == "d");
+        }
+      }
+    }
+
+    WHEN("the map is cleared") {
+      map.clear();
+
+      THEN("old keys become invalid") {
+        CHECK(map.empty());
+        CHECK_FALSE(map.Contains(a));
+        CHECK_FALSE(map.Contains(b));
+        CHECK_FALSE(map.Contains(c));
+      }
+    }
+  }
+
+  GIVEN("a packed key") {
+    Map map;
+    map.Erase(map.Insert("x"));
+    const auto key = map.Insert("y");
+
+    THEN("it unpacks to the same key") {
+      CHECK(Map::Key::Unpack(key.Pack()) == key);
+      CHECK(*map.Find(Map::Key::Unpack(key.Pack())) == "y");
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../src/spatial_grid.h"
+
+using util::InterestArea;
+using util::SpatialGrid;
+
+namespace {
+
+std::vector<SpatialGrid::Id> Query(const SpatialGrid& grid, const InterestArea& area) {
+  std::vector<SpatialGrid::Id> ids;
+  grid.ForEachIn(area, [&ids](SpatialGrid::Id id, geom::Point2D) { ids.push_back(id); });
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+}  // namespace
+
+SCENARIO("Spatial grid finds objects in an area") {
+  GIVEN("a grid with objects in different cells") {
+    SpatialGrid grid{10};
+    grid.Insert(0, {1, 1});
+    grid.Insert(1, {15, 1});
+    grid.Insert(2, {-5, -5});
+    grid.Insert(3, {100, 100});
+
+    THEN("a rectangle returns only objects inside it") {
+      CHECK(Query(grid, InterestArea::Rect({0, 0}, {20, 5})) == std::vector<SpatialGrid::Id>{0, 1});
+      CHECK(Query(grid, InterestArea::Rect({-10, -10}, {0, 0})) == std::vector<SpatialGrid::Id>{2});
+    }
+
+    THEN("a circle excludes the corners of its bounding box") {
+      CHECK(Query(grid, InterestArea::Circle({0, 0}, 7.5)) == std::vector<SpatialGrid::Id>{0, 2});
+      CHECK(Query(grid, InterestArea::Circle({0, 0}, 7)) == std::vector<SpatialGrid::Id>{0});
+    }
+
+    THEN("a huge area returns everything") {
+      CHECK(Query(grid, InterestArea::Rect({-1e300, -1e300}, {1e300, 1e300})).size() == 4);
+    }
+
+    WHEN("objects move and leave") {
+      grid.Update(3, {2, 2});
+      grid.Update(0, {3, 3});
+      grid.Erase(1);
+
+      THEN("queries see the new positions") {
+        CHECK(grid.size() == 3);
+        CHECK_FALSE(grid.Contains(1));
+        CHECK(Query(grid, InterestArea::Rect({0, 0}, {20, 5})) ==
+              std::vector<SpatialGrid::Id>{0, 3});
+        CHECK(Query(grid, InterestArea::Rect({90, 90}, {110, 110})).empty());
+      }
+    }
+  }
+}
+
+TEST_CASE("Spatial grid matches a full scan after random moves") {
+  std::mt19937 random{7};
+  std::uniform_real_distribution<double> coord{-50, 150};
+  std::uniform_real_distribution<double> step{-8, 8};
+
+  constexpr SpatialGrid::Id COUNT = 300;
+  SpatialGrid grid{10};
+  std::vector<geom::Point2D> positions;
+  std::vector<bool> alive(COUNT, true);
+  for (SpatialGrid::Id id = 0; id < COUNT; ++id) {
+    positions.push_back({coord(random), coord(random)});
+    grid.Insert(id, positions.back());
+  }
+
+  for (int round = 0; round < 20; ++round) {
+    for (SpatialGrid::Id id = 0; id < COUNT; ++id) {
+      if (!alive[id]) {
+        continue;
+      }
+      if (random() % 50 == 0) {
+        grid.Erase(id);
+        alive[id] = false;
+        continue;
+      }
+      positions[id].x += step(random);
+      positions[id].y += step(random);
+      grid.Update(id, positions[id]);
+    }
+
+    const auto area = round % 2 == 0
+                          ? InterestArea::Circle({coord(random), coord(random)}, 25)
+                          : InterestArea::Rect({coord(random), coord(random)}, {150, 150});
+    std::vector<SpatialGrid::Id> expected;
+    for (SpatialGrid::Id id = 0; id < COUNT; ++id) {
+      if (alive[id] && area.Contains(positions[id])) {
+        expected.push_back(id);
+      }
+    }
+    CHECK(Query(grid, area) == expected);
+  }
+}
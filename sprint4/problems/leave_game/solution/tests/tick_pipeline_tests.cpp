@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/tick_pipeline.h"
+
+using namespace std::literals;
+using game_time::TickPipeline;
+
+SCENARIO("Tick pipeline runs stages in the declared order") {
+  GIVEN("stages added one after another") {
+    TickPipeline pipeline;
+    std::vector<std::string> log;
+    metrics::Histogram movement_duration;
+
+    pipeline.AddStage(
+        "movement", [&log](std::chrono::milliseconds) { log.push_back("movement"); },
+        &movement_duration);
+    pipeline.AddStage("collisions", [&log](std::chrono::milliseconds delta) {
+      log.push_back("collisions " + std::to_string(delta.count()));
+    });
+    pipeline.AddStage("loot", [&log](std::chrono::milliseconds) { log.push_back("loot"); });
+
+    WHEN("the pipeline runs") {
+      pipeline.Run(10ms);
+
+      THEN("every stage runs once in order and gets the tick delta") {
+        CHECK(log == std::vector<std::string>{"movement", "collisions 10", "loot"});
+        CHECK(pipeline.GetWaves() ==
+              std::vector<std::vector<std::string>>{{"movement"}, {"collisions"}, {"loot"}});
+      }
+
+      THEN("the duration of a stage with a histogram is recorded") {
+        CHECK(movement_duration.TakeSnapshot().count == 1);
+      }
+    }
+  }
+
+  GIVEN("stages that depend on the same stage") {
+    TickPipeline pipeline;
+    std::vector<std::string> log;
+    const auto logged = [&log](std::string name) {
+      return [&log, name](auto) { log.push_back(name); };
+    };
+    pipeline.AddStage("retirement", logged("retirement"));
+    pipeline.AddStageAfter({"retirement"}, "snapshot", logged("snapshot"));
+    pipeline.AddStageAfter({"retirement"}, "publish", logged("publish"));
+    pipeline.AddStage("last", logged("last"));
+
+    THEN("they form one wave, and the next stage waits for the whole wave") {
+      CHECK(pipeline.GetWaves() == std::vector<std::vector<std::string>>{
+                                       {"retirement"}, {"snapshot", "publish"}, {"last"}});
+      pipeline.Run(1ms);
+      CHECK(log == std::vector<std::string>{"retirement", "snapshot", "publish", "last"});
+    }
+  }
+
+  GIVEN("wrong stage declarations") {
+    TickPipeline pipeline;
+    pipeline.AddStage("movement", [](auto) {});
+
+    THEN("they are rejected") {
+      CHECK_THROWS_AS(pipeline.AddStage("movement", [](auto) {}), std::invalid_argument);
+      CHECK_THROWS_AS(pipeline.AddStageAfter({"loot"}, "publish", [](auto) {}),
+                      std::invalid_argument);
+    }
+  }
+}
+
+SCENARIO("Tick pipeline with workers runs independent stages in parallel") {
+  TickPipeline pipeline{2};
+  std::atomic<int> started{0};
+  std::atomic<bool> overlapped{true};
+  std::vector<std::string> log;
+
+  // Каждая стадия волны ждёт начала остальных: по очереди они бы не дождались
+  const auto meet = [&](auto) {
+    started.fetch_add(1);
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (started.load() < 3) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        overlapped = false;
+        return;
+      }
+      std::this_thread::yield();
+    }
+  };
+
+  pipeline.AddStage("first", [&log](auto) { log.push_back("first"); });
+  for (const auto* name : {"a", "b", "c"}) {
+    pipeline.AddStageAfter({"first"}, name, meet);
+  }
+  pipeline.AddStage("after",
+                    [&](auto) { log.push_back("after " + std::to_string(started.load())); });
+
+  WHEN("the pipeline runs") {
+    pipeline.Run(1ms);
+
+    THEN("the wave overlaps and the next stage runs after all of it") {
+      CHECK(overlapped);
+      CHECK(log == std::vector<std::string>{"first", "after 3"});
+    }
+  }
+
+  WHEN("a stage of the wave throws") {
+    TickPipeline failing{2};
+    bool next_ran = false;
+    failing.AddStage("first", [](auto) {});
+    failing.AddStageAfter({"first"}, "ok", [](auto) {});
+    failing.AddStageAfter({"first"}, "broken", [](auto) { throw std::runtime_error("broken"); });
+    failing.AddStage("next", [&next_ran](auto) { next_ran = true; });
+
+    THEN("the error reaches the caller and later stages do not run") {
+      CHECK_THROWS_AS(failing.Run(1ms), std::runtime_error);
+      CHECK_FALSE(next_ran);
+    }
+  }
+}